@@ -16,6 +16,8 @@ this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "LibBoolEE.h"
 
+#include <algorithm>
+
 std::vector<std::string> LibBoolEE::singleParse(const std::string & formula, const char op, ErrorReport* errorReport) {
     int start_pos = -1;
     int parity_count = 0;
@@ -145,6 +147,136 @@ bool LibBoolEE::resolveRec(const std::string &source, const Vals & valuation, Er
     }
 }
 
+LibBoolEE::Compiled LibBoolEE::compile(const std::string &source, const std::vector<std::string> & variables, ErrorReport* errorReport) {
+    if (variables.size() > MAX_COMPILED_VARIABLES) {
+        throw std::runtime_error("Too many variables to compile the formula '" + source + "'.");
+    }
+    std::map<std::string, uint32_t> index;
+    for (uint32_t i = 0; i < variables.size(); i++) {
+        index.emplace(variables[i], i);
+    }
+
+    Compiled compiled;
+    compiled.max_depth = compileRec(removeWhitespaces(source), index, compiled, errorReport);
+    return compiled;
+}
+
+size_t LibBoolEE::compileRec(const std::string &source, const std::map<std::string, uint32_t> & variables, Compiled & compiled, ErrorReport* errorReport) {
+    if (source.empty()) {
+        if (errorReport) {
+            errorReport->type = ErrorReport::ErrorType::EmptySubExpression;
+            errorReport->vecUserData.emplace_back(source);
+            errorReport->strDevData = "bad-txns-null-verifier-empty-sub-expression";
+        }
+        throw std::runtime_error("An empty subexpression was encountered");
+    }
+
+    char current_op = '|';
+    // Try to divide by |
+    std::vector<std::string> subexpressions = singleParse(source, current_op, errorReport);
+    // No | on the top level
+    if (subexpressions.size() == 1) {
+        current_op = '&';
+        subexpressions = singleParse(source, current_op, errorReport);
+    }
+
+    // No valid name found
+    if (subexpressions.size() == 0) {
+        if (errorReport) {
+            errorReport->type = ErrorReport::ErrorType::InvalidQualifierName;
+            errorReport->vecUserData.emplace_back(source);
+            errorReport->strDevData = "bad-txns-null-verifier-no-sub-expressions";
+        }
+        throw std::runtime_error("The subexpression " + source + " is not a valid formula.");
+    }
+
+    // No binary top level operator found
+    else if (subexpressions.size() == 1) {
+        if (source[0] == '!') {
+            size_t depth = compileRec(removeWhitespaces(source.substr(1)), variables, compiled, errorReport);
+            compiled.code.push_back({Compiled::NOT, 0});
+            return depth;
+        }
+        else if (source[0] == '(') {
+            return compileRec(removeWhitespaces(source.substr(1, source.size() - 2)), variables, compiled, errorReport);
+        }
+        else if (source == "1") {
+            compiled.code.push_back({Compiled::PUSH_TRUE, 0});
+            return 1;
+        }
+        else if (source == "0") {
+            compiled.code.push_back({Compiled::PUSH_FALSE, 0});
+            return 1;
+        }
+
+        auto it = variables.find(source);
+        if (it == variables.end()) {
+            if (errorReport) {
+                errorReport->type = ErrorReport::ErrorType::VariableNotFound;
+                errorReport->vecUserData.emplace_back(source);
+                errorReport->strDevData = "bad-txns-null-verifier-variable-not-found";
+            }
+            throw std::runtime_error("Variable '" + source + "' not found in the interpretation.");
+        }
+        compiled.code.push_back({Compiled::PUSH_VAR, it->second});
+        return 1;
+    }
+    else {
+        // Like resolveRec every operand is evaluated, the operands are left on the stack and combined at once
+        size_t depth = 0;
+        for (size_t i = 0; i < subexpressions.size(); i++) {
+            depth = std::max(depth, i + compileRec(removeWhitespaces(subexpressions[i]), variables, compiled, errorReport));
+        }
+        compiled.code.push_back({current_op == '|' ? Compiled::OR : Compiled::AND, static_cast<uint32_t>(subexpressions.size())});
+        return depth;
+    }
+}
+
+bool LibBoolEE::Compiled::evaluate(uint64_t valuation) const {
+    char stack_buffer[64];
+    std::vector<char> stack_heap;
+    char* stack = stack_buffer;
+    if (max_depth > sizeof(stack_buffer)) {
+        stack_heap.resize(max_depth);
+        stack = stack_heap.data();
+    }
+
+    size_t top = 0;
+    for (const Instruction& instruction : code) {
+        switch (instruction.op) {
+        case PUSH_FALSE:
+            stack[top++] = false;
+            break;
+        case PUSH_TRUE:
+            stack[top++] = true;
+            break;
+        case PUSH_VAR:
+            stack[top++] = (valuation >> instruction.arg) & 1;
+            break;
+        case NOT:
+            stack[top - 1] = !stack[top - 1];
+            break;
+        case AND: {
+            bool result = true;
+            for (uint32_t i = 0; i < instruction.arg; i++) {
+                result &= static_cast<bool>(stack[--top]);
+            }
+            stack[top++] = result;
+            break;
+        }
+        case OR: {
+            bool result = false;
+            for (uint32_t i = 0; i < instruction.arg; i++) {
+                result |= static_cast<bool>(stack[--top]);
+            }
+            stack[top++] = result;
+            break;
+        }
+        }
+    }
+    return stack[0];
+}
+
 std::string LibBoolEE::trim(const std::string &source) {
     static const std::string WHITESPACES = " \n\r\t\v\f";
     const size_t front = source.find_first_not_of(WHITESPACES);
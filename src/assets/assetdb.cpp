@@ -19,6 +19,9 @@ static const char ADDRESS_ASSET_QUANTITY_FLAG = 'C';
 static const char MY_ASSET_FLAG = 'M';
 static const char BLOCK_ASSET_UNDO_DATA = 'U';
 static const char MEMPOOL_REISSUED_TX = 'Z';
+static const char ASSET_HOLDER_COUNT_FLAG = 'b';
+static const char ADDRESS_ASSET_COUNT_FLAG = 'c';
+static const char HOLDER_COUNTS_BUILT_FLAG = 'H';
 
 static size_t MAX_DATABASE_RESULTS = 50000;
 
@@ -33,11 +36,38 @@ bool CAssetsDB::WriteAssetData(const CNewAsset &asset, const int nHeight, const
 
 bool CAssetsDB::WriteAssetAddressQuantity(const std::string &assetName, const std::string &address, const CAmount &quantity)
 {
-    return Write(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, address)), quantity);
+    return WriteDirEntry(ASSET_ADDRESS_QUANTITY_FLAG, ASSET_HOLDER_COUNT_FLAG, assetName, address, &quantity);
 }
 
 bool CAssetsDB::WriteAddressAssetQuantity(const std::string &address, const std::string &assetName, const CAmount& quantity) {
-    return Write(std::make_pair(ADDRESS_ASSET_QUANTITY_FLAG, std::make_pair(address, assetName)), quantity);
+    return WriteDirEntry(ADDRESS_ASSET_QUANTITY_FLAG, ADDRESS_ASSET_COUNT_FLAG, address, assetName, &quantity);
+}
+
+bool CAssetsDB::WriteDirEntry(const char flag, const char countFlag, const std::string& first, const std::string& second, const CAmount* quantity)
+{
+    auto key = std::make_pair(flag, std::make_pair(first, second));
+    bool fExists = Exists(key);
+
+    CDBBatch batch(*this);
+    if (quantity)
+        batch.Write(key, *quantity);
+    else
+        batch.Erase(key);
+
+    // Keep the number of entries under first in step with the entries themselves
+    if (fExists != (quantity != nullptr)) {
+        auto countKey = std::make_pair(countFlag, first);
+        int64_t nCount = 0;
+        if (!Read(countKey, nCount))
+            nCount = 0;
+        nCount += quantity ? 1 : -1;
+        if (nCount > 0)
+            batch.Write(countKey, nCount);
+        else
+            batch.Erase(countKey);
+    }
+
+    return WriteBatch(batch);
 }
 
 bool CAssetsDB::ReadAssetData(const std::string& strName, CNewAsset& asset, int& nHeight, uint256& blockHash)
@@ -75,11 +105,11 @@ bool CAssetsDB::EraseMyAssetData(const std::string& assetName)
 }
 
 bool CAssetsDB::EraseAssetAddressQuantity(const std::string &assetName, const std::string &address) {
-    return Erase(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, address)));
+    return WriteDirEntry(ASSET_ADDRESS_QUANTITY_FLAG, ASSET_HOLDER_COUNT_FLAG, assetName, address, nullptr);
 }
 
 bool CAssetsDB::EraseAddressAssetQuantity(const std::string &address, const std::string &assetName) {
-    return Erase(std::make_pair(ADDRESS_ASSET_QUANTITY_FLAG, std::make_pair(address, assetName)));
+    return WriteDirEntry(ADDRESS_ASSET_QUANTITY_FLAG, ADDRESS_ASSET_COUNT_FLAG, address, assetName, nullptr);
 }
 
 bool EraseAddressAssetQuantity(const std::string &address, const std::string &assetName);
@@ -147,6 +177,9 @@ bool CAssetsDB::LoadAssets()
 
 
     if (fAssetIndex) {
+        if (!Exists(HOLDER_COUNTS_BUILT_FLAG) && !BuildHolderCounts())
+            return error("%s: failed to build the asset holder counts", __func__);
+
         std::unique_ptr<CDBIterator> pcursor3(NewIterator());
         pcursor3->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(std::string(), std::string())));
 
@@ -245,148 +278,157 @@ bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets, const std::st
     return true;
 }
 
-bool CAssetsDB::AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start)
+bool CAssetsDB::BuildHolderCounts()
 {
-    FlushStateToDisk();
+    LogPrintf("%s: Counting the asset holders of the asset index...\n", __func__);
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ADDRESS_ASSET_QUANTITY_FLAG, std::make_pair(address, std::string())));
+    for (char flag : {ASSET_ADDRESS_QUANTITY_FLAG, ADDRESS_ASSET_QUANTITY_FLAG}) {
+        const char countFlag = flag == ASSET_ADDRESS_QUANTITY_FLAG ? ASSET_HOLDER_COUNT_FLAG : ADDRESS_ASSET_COUNT_FLAG;
 
-    if (fGetTotal) {
-        totalEntries = 0;
-        while (pcursor->Valid()) {
+        // Entries are sorted by their first name, so every count is complete when the name changes
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(flag, std::make_pair(std::string(), std::string())));
+
+        CDBBatch batch(*this);
+        std::string strCurrent;
+        int64_t nCount = 0;
+        while (true) {
             boost::this_thread::interruption_point();
 
             std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_QUANTITY_FLAG && key.second.first == address) {
-                totalEntries++;
+            bool fEntry = pcursor->Valid() && pcursor->GetKey(key) && key.first == flag;
+            if (nCount > 0 && (!fEntry || key.second.first != strCurrent)) {
+                batch.Write(std::make_pair(countFlag, strCurrent), nCount);
+                nCount = 0;
+                if (batch.SizeEstimate() > 1 << 20) {
+                    if (!WriteBatch(batch))
+                        return false;
+                    batch.Clear();
+                }
             }
+            if (!fEntry)
+                break;
+
+            strCurrent = key.second.first;
+            nCount++;
             pcursor->Next();
         }
-        return true;
+        if (!WriteBatch(batch))
+            return false;
     }
 
-    size_t skip = 0;
-    if (start >= 0) {
-        skip = start;
+    return Write(HOLDER_COUNTS_BUILT_FLAG, true, true);
+}
+
+/** Serializes after every (flag, (first, *)) key and before the entries of the next name */
+struct CDirEndKey
+{
+    char flag;
+    const std::string& first;
+
+    CDirEndKey(char flagIn, const std::string& firstIn) : flag(flagIn), first(firstIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        // Any second name starts with a single byte CompactSize length, so 0xff sorts after it
+        s << flag << first << (unsigned char)0xff;
     }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
+};
+
+/**
+ * Read up to count (flag, (first, second)) -> quantity entries of first into vecAmounts.
+ * With strAfter set the page starts right after that second name, so a deep page costs
+ * the same as the first one. Otherwise the first start entries are skipped, or with a
+ * negative start the page starts -start entries before the end.
+ */
+static bool ReadDirPage(CDBWrapper& db, const char flag, const std::string& first, std::vector<std::pair<std::string, CAmount> >& vecAmounts, const size_t count, const long start, const std::string& strAfter)
+{
+    typedef std::pair<char, std::pair<std::string, std::string> > DirKey;
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
 
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_QUANTITY_FLAG && key.second.first == address) {
-                table_size += 1;
-            }
+    auto fMatch = [&](DirKey& key) {
+        return pcursor->Valid() && pcursor->GetKey(key) && key.first == flag && key.second.first == first;
+    };
+
+    DirKey key;
+    size_t skip = 0;
+    if (!strAfter.empty()) {
+        pcursor->Seek(std::make_pair(flag, std::make_pair(first, strAfter)));
+        if (fMatch(key) && key.second.second == strAfter)
             pcursor->Next();
+    } else if (start >= 0) {
+        pcursor->Seek(std::make_pair(flag, std::make_pair(first, std::string())));
+        skip = start;
+    } else {
+        // Walk back from the end of the entries of first instead of counting them all
+        pcursor->Seek(CDirEndKey(flag, first));
+        if (pcursor->Valid())
+            pcursor->Prev();
+        else
+            pcursor->SeekToLast();
+
+        std::string strFirst;
+        bool fFound = false;
+        for (long i = 0; i < -start && fMatch(key); i++) {
+            boost::this_thread::interruption_point();
+            strFirst = key.second.second;
+            fFound = true;
+            pcursor->Prev();
         }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
+        if (!fFound)
+            return true;
+        pcursor->Seek(std::make_pair(flag, std::make_pair(first, strFirst)));
     }
 
-
     size_t loaded = 0;
     size_t offset = 0;
 
-    // Load assets
-    while (pcursor->Valid() && loaded < count && loaded < MAX_DATABASE_RESULTS) {
+    while (loaded < count && loaded < MAX_DATABASE_RESULTS && fMatch(key)) {
         boost::this_thread::interruption_point();
 
-        std::pair<char, std::pair<std::string, std::string> > key;
-        if (pcursor->GetKey(key) && key.first == ADDRESS_ASSET_QUANTITY_FLAG && key.second.first == address) {
-                if (offset < skip) {
-                    offset += 1;
-                }
-                else {
-                    CAmount amount;
-                    if (pcursor->GetValue(amount)) {
-                        vecAssetAmount.emplace_back(std::make_pair(key.second.second, amount));
-                        loaded += 1;
-                    } else {
-                        return error("%s: failed to Address Asset Quanity", __func__);
-                    }
-                }
-            pcursor->Next();
+        if (offset < skip) {
+            offset += 1;
         } else {
-            break;
+            CAmount amount;
+            if (pcursor->GetValue(amount)) {
+                vecAmounts.emplace_back(std::make_pair(key.second.second, amount));
+                loaded += 1;
+            } else {
+                return error("%s: failed to read quantity of %s", __func__, first);
+            }
         }
+        pcursor->Next();
     }
 
     return true;
 }
 
-// Can get to total count of addresses that belong to a certain asset_name, or get you the list of all address that belong to a certain asset_name
-bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start)
+bool CAssetsDB::AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start, const std::string& strAfterAsset)
 {
     FlushStateToDisk();
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-    pcursor->Seek(std::make_pair(ASSET_ADDRESS_QUANTITY_FLAG, std::make_pair(assetName, std::string())));
-
     if (fGetTotal) {
-        totalEntries = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
-
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName) {
-                totalEntries += 1;
-            }
-            pcursor->Next();
-        }
+        int64_t nCount = 0;
+        totalEntries = Read(std::make_pair(ADDRESS_ASSET_COUNT_FLAG, address), nCount) ? nCount : 0;
         return true;
     }
 
-    size_t skip = 0;
-    if (start >= 0) {
-        skip = start;
-    }
-    else {
-        // compute table size for backwards offset
-        long table_size = 0;
-        while (pcursor->Valid()) {
-            boost::this_thread::interruption_point();
-
-            std::pair<char, std::pair<std::string, std::string> > key;
-            if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName) {
-                table_size += 1;
-            }
-            pcursor->Next();
-        }
-        skip = table_size + start;
-        pcursor->SeekToFirst();
-    }
-
-    size_t loaded = 0;
-    size_t offset = 0;
+    return ReadDirPage(*this, ADDRESS_ASSET_QUANTITY_FLAG, address, vecAssetAmount, count, start, strAfterAsset);
+}
 
-    // Load assets
-    while (pcursor->Valid() && loaded < count && loaded < MAX_DATABASE_RESULTS) {
-        boost::this_thread::interruption_point();
+// Can get to total count of addresses that belong to a certain asset_name, or get you the list of all address that belong to a certain asset_name
+bool CAssetsDB::AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start, const std::string& strAfterAddress)
+{
+    FlushStateToDisk();
 
-        std::pair<char, std::pair<std::string, std::string> > key;
-        if (pcursor->GetKey(key) && key.first == ASSET_ADDRESS_QUANTITY_FLAG && key.second.first == assetName) {
-            if (offset < skip) {
-                offset += 1;
-            }
-            else {
-                CAmount amount;
-                if (pcursor->GetValue(amount)) {
-                    vecAddressAmount.emplace_back(std::make_pair(key.second.second, amount));
-                    loaded += 1;
-                } else {
-                    return error("%s: failed to Asset Address Quanity", __func__);
-                }
-            }
-            pcursor->Next();
-        } else {
-            break;
-        }
+    if (fGetTotal) {
+        int64_t nCount = 0;
+        totalEntries = Read(std::make_pair(ASSET_HOLDER_COUNT_FLAG, assetName), nCount) ? nCount : 0;
+        return true;
     }
 
-    return true;
+    return ReadDirPage(*this, ASSET_ADDRESS_QUANTITY_FLAG, assetName, vecAddressAmount, count, start, strAfterAddress);
 }
 
 bool CAssetsDB::AssetDir(std::vector<CDatabasedAssetData>& assets)
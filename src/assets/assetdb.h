@@ -91,8 +91,17 @@ public:
     bool AssetDir(std::vector<CDatabasedAssetData>& assets, const std::string filter, const size_t count, const long start);
     bool AssetDir(std::vector<CDatabasedAssetData>& assets);
 
-    bool AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start);
-    bool AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start);
+    /** Count the holders of every asset and the assets of every address, for asset indexes built before the counts were maintained */
+    bool BuildHolderCounts();
+
+    // Totals are read from the maintained counts. Passing the last name of the previous page as
+    // strAfterAsset/strAfterAddress continues from there without stepping over the skipped entries.
+    bool AddressDir(std::vector<std::pair<std::string, CAmount> >& vecAssetAmount, int& totalEntries, const bool& fGetTotal, const std::string& address, const size_t count, const long start, const std::string& strAfterAsset = "");
+    bool AssetAddressDir(std::vector<std::pair<std::string, CAmount> >& vecAddressAmount, int& totalEntries, const bool& fGetTotal, const std::string& assetName, const size_t count, const long start, const std::string& strAfterAddress = "");
+
+private:
+    /** Write (quantity set) or erase an asset/address entry and update the entry count of first in the same batch */
+    bool WriteDirEntry(const char flag, const char countFlag, const std::string& first, const std::string& second, const CAmount* quantity);
 };
 
 
@@ -2822,182 +2822,183 @@ bool CAssetsCache::DumpCacheToDatabase()
     }
 }
 
-// This function will put all current cache data into the global passets cache.
+// This function will put all current cache data into the cache it was layered on, or the global passets cache.
 //! Do not call this function on the passets pointer
 bool CAssetsCache::Flush()
 {
+    CAssetsCache* pTarget = pBase ? pBase : passets;
 
-    if (!passets)
+    if (!pTarget)
         return error("%s: Couldn't find passets pointer while trying to flush assets cache", __func__);
 
     try {
         for (auto &item : setNewAssetsToAdd) {
-            if (passets->setNewAssetsToRemove.count(item))
-                passets->setNewAssetsToRemove.erase(item);
-            passets->setNewAssetsToAdd.insert(item);
+            if (pTarget->setNewAssetsToRemove.count(item))
+                pTarget->setNewAssetsToRemove.erase(item);
+            pTarget->setNewAssetsToAdd.insert(item);
         }
 
         for (auto &item : setNewAssetsToRemove) {
-            if (passets->setNewAssetsToAdd.count(item))
-                passets->setNewAssetsToAdd.erase(item);
-            passets->setNewAssetsToRemove.insert(item);
+            if (pTarget->setNewAssetsToAdd.count(item))
+                pTarget->setNewAssetsToAdd.erase(item);
+            pTarget->setNewAssetsToRemove.insert(item);
         }
 
         for (auto &item : mapAssetsAddressAmount)
-            passets->mapAssetsAddressAmount[item.first] = item.second;
+            pTarget->mapAssetsAddressAmount[item.first] = item.second;
 
         for (auto &item : mapReissuedAssetData)
-            passets->mapReissuedAssetData[item.first] = item.second;
+            pTarget->mapReissuedAssetData[item.first] = item.second;
 
         for (auto &item : setNewOwnerAssetsToAdd) {
-            if (passets->setNewOwnerAssetsToRemove.count(item))
-                passets->setNewOwnerAssetsToRemove.erase(item);
-            passets->setNewOwnerAssetsToAdd.insert(item);
+            if (pTarget->setNewOwnerAssetsToRemove.count(item))
+                pTarget->setNewOwnerAssetsToRemove.erase(item);
+            pTarget->setNewOwnerAssetsToAdd.insert(item);
         }
 
         for (auto &item : setNewOwnerAssetsToRemove) {
-            if (passets->setNewOwnerAssetsToAdd.count(item))
-                passets->setNewOwnerAssetsToAdd.erase(item);
-            passets->setNewOwnerAssetsToRemove.insert(item);
+            if (pTarget->setNewOwnerAssetsToAdd.count(item))
+                pTarget->setNewOwnerAssetsToAdd.erase(item);
+            pTarget->setNewOwnerAssetsToRemove.insert(item);
         }
 
         for (auto &item : setNewReissueToAdd) {
-            if (passets->setNewReissueToRemove.count(item))
-                passets->setNewReissueToRemove.erase(item);
-            passets->setNewReissueToAdd.insert(item);
+            if (pTarget->setNewReissueToRemove.count(item))
+                pTarget->setNewReissueToRemove.erase(item);
+            pTarget->setNewReissueToAdd.insert(item);
         }
 
         for (auto &item : setNewReissueToRemove) {
-            if (passets->setNewReissueToAdd.count(item))
-                passets->setNewReissueToAdd.erase(item);
-            passets->setNewReissueToRemove.insert(item);
+            if (pTarget->setNewReissueToAdd.count(item))
+                pTarget->setNewReissueToAdd.erase(item);
+            pTarget->setNewReissueToRemove.insert(item);
         }
 
         for (auto &item : setNewTransferAssetsToAdd) {
-            if (passets->setNewTransferAssetsToRemove.count(item))
-                passets->setNewTransferAssetsToRemove.erase(item);
-            passets->setNewTransferAssetsToAdd.insert(item);
+            if (pTarget->setNewTransferAssetsToRemove.count(item))
+                pTarget->setNewTransferAssetsToRemove.erase(item);
+            pTarget->setNewTransferAssetsToAdd.insert(item);
         }
 
         for (auto &item : setNewTransferAssetsToRemove) {
-            if (passets->setNewTransferAssetsToAdd.count(item))
-                passets->setNewTransferAssetsToAdd.erase(item);
-            passets->setNewTransferAssetsToRemove.insert(item);
+            if (pTarget->setNewTransferAssetsToAdd.count(item))
+                pTarget->setNewTransferAssetsToAdd.erase(item);
+            pTarget->setNewTransferAssetsToRemove.insert(item);
         }
 
         for (auto &item : vSpentAssets) {
-            passets->vSpentAssets.emplace_back(item);
+            pTarget->vSpentAssets.emplace_back(item);
         }
 
         for (auto &item : vUndoAssetAmount) {
-            passets->vUndoAssetAmount.emplace_back(item);
+            pTarget->vUndoAssetAmount.emplace_back(item);
         }
 
         for(auto &item : setNewQualifierAddressToAdd) {
-            if (passets->setNewQualifierAddressToRemove.count(item)) {
-                passets->setNewQualifierAddressToRemove.erase(item);
+            if (pTarget->setNewQualifierAddressToRemove.count(item)) {
+                pTarget->setNewQualifierAddressToRemove.erase(item);
             }
 
-            if (passets->setNewQualifierAddressToAdd.count(item)) {
-                passets->setNewQualifierAddressToAdd.erase(item);
+            if (pTarget->setNewQualifierAddressToAdd.count(item)) {
+                pTarget->setNewQualifierAddressToAdd.erase(item);
             }
 
-            passets->setNewQualifierAddressToAdd.insert(item);
+            pTarget->setNewQualifierAddressToAdd.insert(item);
         }
 
         for(auto &item : setNewQualifierAddressToRemove) {
-            if (passets->setNewQualifierAddressToAdd.count(item)) {
-                passets->setNewQualifierAddressToAdd.erase(item);
+            if (pTarget->setNewQualifierAddressToAdd.count(item)) {
+                pTarget->setNewQualifierAddressToAdd.erase(item);
             }
 
-            if (passets->setNewQualifierAddressToRemove.count(item)) {
-                passets->setNewQualifierAddressToRemove.erase(item);
+            if (pTarget->setNewQualifierAddressToRemove.count(item)) {
+                pTarget->setNewQualifierAddressToRemove.erase(item);
             }
 
-            passets->setNewQualifierAddressToRemove.insert(item);
+            pTarget->setNewQualifierAddressToRemove.insert(item);
         }
 
         for(auto &item : setNewRestrictedAddressToAdd) {
-            if (passets->setNewRestrictedAddressToRemove.count(item)) {
-                passets->setNewRestrictedAddressToRemove.erase(item);
+            if (pTarget->setNewRestrictedAddressToRemove.count(item)) {
+                pTarget->setNewRestrictedAddressToRemove.erase(item);
             }
 
-            if (passets->setNewRestrictedAddressToAdd.count(item)) {
-                passets->setNewRestrictedAddressToAdd.erase(item);
+            if (pTarget->setNewRestrictedAddressToAdd.count(item)) {
+                pTarget->setNewRestrictedAddressToAdd.erase(item);
             }
 
-            passets->setNewRestrictedAddressToAdd.insert(item);
+            pTarget->setNewRestrictedAddressToAdd.insert(item);
         }
 
         for(auto &item : setNewRestrictedAddressToRemove) {
-            if (passets->setNewRestrictedAddressToAdd.count(item)) {
-                passets->setNewRestrictedAddressToAdd.erase(item);
+            if (pTarget->setNewRestrictedAddressToAdd.count(item)) {
+                pTarget->setNewRestrictedAddressToAdd.erase(item);
             }
 
-            if (passets->setNewRestrictedAddressToRemove.count(item)) {
-                passets->setNewRestrictedAddressToRemove.erase(item);
+            if (pTarget->setNewRestrictedAddressToRemove.count(item)) {
+                pTarget->setNewRestrictedAddressToRemove.erase(item);
             }
 
-            passets->setNewRestrictedAddressToRemove.insert(item);
+            pTarget->setNewRestrictedAddressToRemove.insert(item);
         }
 
         for(auto &item : setNewRestrictedGlobalToAdd) {
-            if (passets->setNewRestrictedGlobalToRemove.count(item)) {
-                passets->setNewRestrictedGlobalToRemove.erase(item);
+            if (pTarget->setNewRestrictedGlobalToRemove.count(item)) {
+                pTarget->setNewRestrictedGlobalToRemove.erase(item);
             }
 
-            if (passets->setNewRestrictedGlobalToAdd.count(item)) {
-                passets->setNewRestrictedGlobalToAdd.erase(item);
+            if (pTarget->setNewRestrictedGlobalToAdd.count(item)) {
+                pTarget->setNewRestrictedGlobalToAdd.erase(item);
             }
 
-            passets->setNewRestrictedGlobalToAdd.insert(item);
+            pTarget->setNewRestrictedGlobalToAdd.insert(item);
         }
 
         for(auto &item : setNewRestrictedGlobalToRemove) {
-            if (passets->setNewRestrictedGlobalToAdd.count(item)) {
-                passets->setNewRestrictedGlobalToAdd.erase(item);
+            if (pTarget->setNewRestrictedGlobalToAdd.count(item)) {
+                pTarget->setNewRestrictedGlobalToAdd.erase(item);
             }
 
-            if (passets->setNewRestrictedGlobalToRemove.count(item)) {
-                passets->setNewRestrictedGlobalToRemove.erase(item);
+            if (pTarget->setNewRestrictedGlobalToRemove.count(item)) {
+                pTarget->setNewRestrictedGlobalToRemove.erase(item);
             }
 
-            passets->setNewRestrictedGlobalToRemove.insert(item);
+            pTarget->setNewRestrictedGlobalToRemove.insert(item);
         }
 
         for (auto &item : setNewRestrictedVerifierToAdd) {
-            if (passets->setNewRestrictedVerifierToRemove.count(item)) {
-                passets->setNewRestrictedVerifierToRemove.erase(item);
+            if (pTarget->setNewRestrictedVerifierToRemove.count(item)) {
+                pTarget->setNewRestrictedVerifierToRemove.erase(item);
             }
 
-            if (passets->setNewRestrictedVerifierToAdd.count(item)) {
-                passets->setNewRestrictedVerifierToAdd.erase(item);
+            if (pTarget->setNewRestrictedVerifierToAdd.count(item)) {
+                pTarget->setNewRestrictedVerifierToAdd.erase(item);
             }
 
-            passets->setNewRestrictedVerifierToAdd.insert(item);
+            pTarget->setNewRestrictedVerifierToAdd.insert(item);
         }
 
         for (auto &item : setNewRestrictedVerifierToRemove) {
-            if (passets->setNewRestrictedVerifierToAdd.count(item)) {
-                passets->setNewRestrictedVerifierToAdd.erase(item);
+            if (pTarget->setNewRestrictedVerifierToAdd.count(item)) {
+                pTarget->setNewRestrictedVerifierToAdd.erase(item);
             }
 
-            if (passets->setNewRestrictedVerifierToRemove.count(item)) {
-                passets->setNewRestrictedVerifierToRemove.erase(item);
+            if (pTarget->setNewRestrictedVerifierToRemove.count(item)) {
+                pTarget->setNewRestrictedVerifierToRemove.erase(item);
             }
 
-            passets->setNewRestrictedVerifierToRemove.insert(item);
+            pTarget->setNewRestrictedVerifierToRemove.insert(item);
         }
 
         for (auto &item : mapRootQualifierAddressesAdd) {
             for (auto asset : item.second) {
-                passets->mapRootQualifierAddressesAdd[item.first].insert(asset);
+                pTarget->mapRootQualifierAddressesAdd[item.first].insert(asset);
             }
         }
 
         for (auto &item : mapRootQualifierAddressesRemove) {
             for (auto asset : item.second) {
-                passets->mapRootQualifierAddressesAdd[item.first].insert(asset);
+                pTarget->mapRootQualifierAddressesAdd[item.first].insert(asset);
             }
         }
 
@@ -3344,6 +3345,15 @@ bool IsScriptNewRestrictedAsset(const CScript &scriptPubKey, int &nStartingIndex
 }
 
 
+//! Returns the next cache to search after layer, walking down the layered caches until the global passets cache is reached
+static CAssetsCache* GetNextCacheLayer(const CAssetsCache* layer)
+{
+    if (layer == passets)
+        return nullptr;
+
+    return layer->pBase ? layer->pBase : passets;
+}
+
 //! Returns a boolean on if the asset exists
 bool CAssetsCache::CheckIfAssetExists(const std::string& name, bool fForceDuplicateCheck)
 {
@@ -3363,8 +3373,10 @@ bool CAssetsCache::CheckIfAssetExists(const std::string& name, bool fForceDuplic
     }
 
     // Check the dirty caches first and see if it was recently added or removed
-    if (passets->setNewAssetsToRemove.count(cachedAsset)) {
-        return false;
+    for (CAssetsCache* layer = GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        if (layer->setNewAssetsToRemove.count(cachedAsset)) {
+            return false;
+        }
     }
 
     if (setNewAssetsToAdd.count(cachedAsset)) {
@@ -3376,12 +3388,14 @@ bool CAssetsCache::CheckIfAssetExists(const std::string& name, bool fForceDuplic
         }
     }
 
-    if (passets->setNewAssetsToAdd.count(cachedAsset)) {
-        if (fForceDuplicateCheck) {
-            return true;
-        }
-        else {
-            LogPrintf("%s : Found asset %s in setNewAssetsToAdd but force duplicate check wasn't true\n", __func__, name);
+    for (CAssetsCache* layer = GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        if (layer->setNewAssetsToAdd.count(cachedAsset)) {
+            if (fForceDuplicateCheck) {
+                return true;
+            }
+            else {
+                LogPrintf("%s : Found asset %s in setNewAssetsToAdd but force duplicate check wasn't true\n", __func__, name);
+            }
         }
     }
 
@@ -3430,9 +3444,11 @@ bool CAssetsCache::GetAssetMetaDataIfExists(const std::string &name, CNewAsset &
     }
 
     // Check the map that contains the reissued asset data. If it is in this map, it hasn't been saved to disk yet
-    if (passets->mapReissuedAssetData.count(name)) {
-        asset = passets->mapReissuedAssetData.at(name);
-        return true;
+    for (CAssetsCache* layer = GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        if (layer->mapReissuedAssetData.count(name)) {
+            asset = layer->mapReissuedAssetData.at(name);
+            return true;
+        }
     }
 
     // Create objects that will be used to check the dirty cache
@@ -3447,9 +3463,11 @@ bool CAssetsCache::GetAssetMetaDataIfExists(const std::string &name, CNewAsset &
     }
 
     // Check the dirty caches first and see if it was recently added or removed
-    if (passets->setNewAssetsToRemove.count(cachedAsset)) {
-        LogPrintf("%s : Found in new assets to Remove - Returning False\n", __func__);
-        return false;
+    for (CAssetsCache* layer = GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        if (layer->setNewAssetsToRemove.count(cachedAsset)) {
+            LogPrintf("%s : Found in new assets to Remove - Returning False\n", __func__);
+            return false;
+        }
     }
 
     auto setIterator = setNewAssetsToAdd.find(cachedAsset);
@@ -3460,12 +3478,14 @@ bool CAssetsCache::GetAssetMetaDataIfExists(const std::string &name, CNewAsset &
         return true;
     }
 
-    setIterator = passets->setNewAssetsToAdd.find(cachedAsset);
-    if (setIterator != passets->setNewAssetsToAdd.end()) {
-        asset = setIterator->asset;
-        nHeight = setIterator->blockHeight;
-        blockHash = setIterator->blockHash;
-        return true;
+    for (CAssetsCache* layer = GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewAssetsToAdd.find(cachedAsset);
+        if (setIterator != layer->setNewAssetsToAdd.end()) {
+            asset = setIterator->asset;
+            nHeight = setIterator->blockHeight;
+            blockHash = setIterator->blockHash;
+            return true;
+        }
     }
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
@@ -3745,10 +3765,12 @@ bool GetBestAssetAddressAmount(CAssetsCache& cache, const std::string& assetName
         if (cache.mapAssetsAddressAmount.count(pair))
             return true;
 
-        // If the caches map has the pair, return true because the map already contains the best dirty amount
-        if (passets->mapAssetsAddressAmount.count(pair)) {
-            cache.mapAssetsAddressAmount[pair] = passets->mapAssetsAddressAmount.at(pair);
-            return true;
+        // If a cache it was layered on has the pair, copy it up because that map contains the best dirty amount
+        for (CAssetsCache* layer = GetNextCacheLayer(&cache); layer; layer = GetNextCacheLayer(layer)) {
+            if (layer->mapAssetsAddressAmount.count(pair)) {
+                cache.mapAssetsAddressAmount[pair] = layer->mapAssetsAddressAmount.at(pair);
+                return true;
+            }
         }
 
         // If the database contains the assets address amount, insert it into the database and return true
@@ -4608,14 +4630,16 @@ bool CAssetsCache::GetAssetVerifierStringIfExists(const std::string &name, CNull
         return false;
     }
 
-    setIterator = passets->setNewRestrictedVerifierToRemove.find(tempCacheVerifier);
-    // Check the dirty caches first and see if it was recently added or removed
-    if (setIterator != passets->setNewRestrictedVerifierToRemove.end()) {
-        if (setIterator->fUndoingRessiue) {
-            verifierString.verifier_string = setIterator->verifier;
-            return true;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedVerifierToRemove.find(tempCacheVerifier);
+        // Check the dirty caches first and see if it was recently added or removed
+        if (setIterator != layer->setNewRestrictedVerifierToRemove.end()) {
+            if (setIterator->fUndoingRessiue) {
+                verifierString.verifier_string = setIterator->verifier;
+                return true;
+            }
+            return false;
         }
-        return false;
     }
 
     setIterator = setNewRestrictedVerifierToAdd.find(tempCacheVerifier);
@@ -4624,10 +4648,12 @@ bool CAssetsCache::GetAssetVerifierStringIfExists(const std::string &name, CNull
         return true;
     }
 
-    setIterator = passets->setNewRestrictedVerifierToAdd.find(tempCacheVerifier);
-    if (setIterator != passets->setNewRestrictedVerifierToAdd.end()) {
-        verifierString.verifier_string = setIterator->verifier;
-        return true;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedVerifierToAdd.find(tempCacheVerifier);
+        if (setIterator != layer->setNewRestrictedVerifierToAdd.end()) {
+            verifierString.verifier_string = setIterator->verifier;
+            return true;
+        }
     }
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
@@ -4672,11 +4698,12 @@ bool CAssetsCache::CheckForAddressQualifier(const std::string &qualifier_name, c
         return setIterator->type == QualifierType::REMOVE_QUALIFIER;
     }
 
-
-    setIterator = passets->setNewQualifierAddressToRemove.find(cachedQualifierAddress);
-    if (setIterator != passets->setNewQualifierAddressToRemove.end()) {
-        // Undoing a remove qualifier command, means that we are adding the qualifier to the address
-        return setIterator->type == QualifierType::REMOVE_QUALIFIER;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewQualifierAddressToRemove.find(cachedQualifierAddress);
+        if (setIterator != layer->setNewQualifierAddressToRemove.end()) {
+            // Undoing a remove qualifier command, means that we are adding the qualifier to the address
+            return setIterator->type == QualifierType::REMOVE_QUALIFIER;
+        }
     }
 
     setIterator = setNewQualifierAddressToAdd.find(cachedQualifierAddress);
@@ -4685,11 +4712,12 @@ bool CAssetsCache::CheckForAddressQualifier(const std::string &qualifier_name, c
         return setIterator->type == QualifierType::ADD_QUALIFIER;
     }
 
-
-    setIterator = passets->setNewQualifierAddressToAdd.find(cachedQualifierAddress);
-    if (setIterator != passets->setNewQualifierAddressToAdd.end()) {
-        // Return true if we are adding the qualifier, and false if we are removing it
-        return setIterator->type == QualifierType::ADD_QUALIFIER;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewQualifierAddressToAdd.find(cachedQualifierAddress);
+        if (setIterator != layer->setNewQualifierAddressToAdd.end()) {
+            // Return true if we are adding the qualifier, and false if we are removing it
+            return setIterator->type == QualifierType::ADD_QUALIFIER;
+        }
     }
 
     auto tempCache = CAssetCacheRootQualifierChecker(qualifier_name, address);
@@ -4699,9 +4727,11 @@ bool CAssetsCache::CheckForAddressQualifier(const std::string &qualifier_name, c
         }
     }
 
-    if (passets->mapRootQualifierAddressesAdd.count(tempCache)) {
-        if (passets->mapRootQualifierAddressesAdd[tempCache].size()) {
-            return true;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        if (layer->mapRootQualifierAddressesAdd.count(tempCache)) {
+            if (layer->mapRootQualifierAddressesAdd[tempCache].size()) {
+                return true;
+            }
         }
     }
 
@@ -4729,6 +4759,18 @@ bool CAssetsCache::CheckForAddressQualifier(const std::string &qualifier_name, c
     return false;
 }
 
+uint64_t CAssetsCache::GetAddressQualifierFlags(const std::vector<std::string>& vecQualifierNames, const std::string& address, bool fSkipTempCache)
+{
+    assert(vecQualifierNames.size() <= 64);
+
+    uint64_t nFlags = 0;
+    for (size_t i = 0; i < vecQualifierNames.size(); i++) {
+        if (CheckForAddressQualifier(vecQualifierNames[i], address, fSkipTempCache))
+            nFlags |= uint64_t(1) << i;
+    }
+    return nFlags;
+}
+
 
 bool CAssetsCache::CheckForAddressRestriction(const std::string &restricted_name, const std::string& address, bool fSkipTempCache)
 {
@@ -4751,10 +4793,12 @@ bool CAssetsCache::CheckForAddressRestriction(const std::string &restricted_name
         return setIterator->type == RestrictedType::UNFREEZE_ADDRESS;
     }
 
-    setIterator = passets->setNewRestrictedAddressToRemove.find(cachedRestrictedAddress);
-    if (setIterator != passets->setNewRestrictedAddressToRemove.end()) {
-        // Undoing a unfreeze, means that we are adding back a freeze
-        return setIterator->type == RestrictedType::UNFREEZE_ADDRESS;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedAddressToRemove.find(cachedRestrictedAddress);
+        if (setIterator != layer->setNewRestrictedAddressToRemove.end()) {
+            // Undoing a unfreeze, means that we are adding back a freeze
+            return setIterator->type == RestrictedType::UNFREEZE_ADDRESS;
+        }
     }
 
     setIterator = setNewRestrictedAddressToAdd.find(cachedRestrictedAddress);
@@ -4763,10 +4807,12 @@ bool CAssetsCache::CheckForAddressRestriction(const std::string &restricted_name
         return setIterator->type == RestrictedType::FREEZE_ADDRESS;
     }
 
-    setIterator = passets->setNewRestrictedAddressToAdd.find(cachedRestrictedAddress);
-    if (setIterator != passets->setNewRestrictedAddressToAdd.end()) {
-        // Return true if we are freezing the address
-        return setIterator->type == RestrictedType::FREEZE_ADDRESS;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedAddressToAdd.find(cachedRestrictedAddress);
+        if (setIterator != layer->setNewRestrictedAddressToAdd.end()) {
+            // Return true if we are freezing the address
+            return setIterator->type == RestrictedType::FREEZE_ADDRESS;
+        }
     }
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
@@ -4810,10 +4856,12 @@ bool CAssetsCache::CheckForGlobalRestriction(const std::string &restricted_name,
         return setIterator->type == RestrictedType::GLOBAL_UNFREEZE;
     }
 
-    setIterator = passets->setNewRestrictedGlobalToRemove.find(cachedRestrictedGlobal);
-    if (setIterator != passets->setNewRestrictedGlobalToRemove.end()) {
-        // Undoing a removal of a global unfreeze, means that is will become frozen
-        return setIterator->type == RestrictedType::GLOBAL_UNFREEZE;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedGlobalToRemove.find(cachedRestrictedGlobal);
+        if (setIterator != layer->setNewRestrictedGlobalToRemove.end()) {
+            // Undoing a removal of a global unfreeze, means that is will become frozen
+            return setIterator->type == RestrictedType::GLOBAL_UNFREEZE;
+        }
     }
 
     setIterator = setNewRestrictedGlobalToAdd.find(cachedRestrictedGlobal);
@@ -4822,10 +4870,12 @@ bool CAssetsCache::CheckForGlobalRestriction(const std::string &restricted_name,
         return setIterator->type == RestrictedType::GLOBAL_FREEZE;
     }
 
-    setIterator = passets->setNewRestrictedGlobalToAdd.find(cachedRestrictedGlobal);
-    if (setIterator != passets->setNewRestrictedGlobalToAdd.end()) {
-        // Return true if we are adding a freeze command
-        return setIterator->type == RestrictedType::GLOBAL_FREEZE;
+    for (CAssetsCache* layer = fSkipTempCache ? passets : GetNextCacheLayer(this); layer; layer = GetNextCacheLayer(layer)) {
+        setIterator = layer->setNewRestrictedGlobalToAdd.find(cachedRestrictedGlobal);
+        if (setIterator != layer->setNewRestrictedGlobalToAdd.end()) {
+            // Return true if we are adding a freeze command
+            return setIterator->type == RestrictedType::GLOBAL_FREEZE;
+        }
     }
 
     // Check the cache, if it doesn't exist in the cache. Try and read it from database
@@ -4871,7 +4921,15 @@ std::string GetStrippedVerifierString(const std::string& verifier)
     return str_without_qualifier_tags;
 }
 
-bool CheckVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport)
+/** A verifier string that passed CheckVerifierString, compiled for checking addresses against it */
+struct CCompiledVerifierString
+{
+    //! The qualifiers of the verifier string with their '#', bit i of a valuation belongs to vecQualifiers[i]
+    std::vector<std::string> vecQualifiers;
+    LibBoolEE::Compiled formula;
+};
+
+static bool CompileVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, LibBoolEE::Compiled& formula, std::string& strError, ErrorReport* errorReport)
 {
     // If verifier string is true, always return true
     if (verifier == "true") {
@@ -4905,8 +4963,8 @@ bool CheckVerifierString(const std::string& verifier, std::set<std::string>& set
     // Extract the qualifiers from the verifier string
     ExtractVerifierStringQualifiers(strippedVerifier, setFoundQualifiers);
 
-    // Create an object that stores if an address contains a qualifier
-    LibBoolEE::Vals vals;
+    // The variables of the verifier string, in the order of their bits in a valuation
+    std::vector<std::string> vars;
 
     // If the check address is empty
 
@@ -4928,11 +4986,12 @@ bool CheckVerifierString(const std::string& verifier, std::set<std::string>& set
             return false;
         }
 
-        vals.insert(std::make_pair(qualifier, true));
+        vars.push_back(qualifier);
     }
 
     try {
-        LibBoolEE::resolve(verifier, vals, errorReport);
+        // Compiling fails exactly where resolving the verifier string would
+        formula = LibBoolEE::compile(verifier, vars, errorReport);
         return true;
     } catch (const std::runtime_error& run_error) {
         if (errorReport) {
@@ -4947,6 +5006,32 @@ bool CheckVerifierString(const std::string& verifier, std::set<std::string>& set
     }
 }
 
+bool CheckVerifierString(const std::string& verifier, std::set<std::string>& setFoundQualifiers, std::string& strError, ErrorReport* errorReport)
+{
+    LibBoolEE::Compiled formula;
+    return CompileVerifierString(verifier, setFoundQualifiers, formula, strError, errorReport);
+}
+
+/** The compiled form of a verifier string that passes CheckVerifierString, or nullptr if it fails */
+static std::shared_ptr<const CCompiledVerifierString> GetCompiledVerifierString(const std::string& verifier, std::string& strError, ErrorReport* errorReport)
+{
+    if (passetsCompiledVerifierCache && passetsCompiledVerifierCache->Exists(verifier))
+        return passetsCompiledVerifierCache->Get(verifier);
+
+    // Only verifier strings that pass are cached, so failures report their errors every time
+    std::set<std::string> setFoundQualifiers;
+    auto compiled = std::make_shared<CCompiledVerifierString>();
+    if (!CompileVerifierString(verifier, setFoundQualifiers, compiled->formula, strError, errorReport))
+        return nullptr;
+
+    for (const auto& qualifier : setFoundQualifiers)
+        compiled->vecQualifiers.emplace_back(QUALIFIER_CHAR + qualifier);
+
+    if (passetsCompiledVerifierCache)
+        passetsCompiledVerifierCache->Put(verifier, compiled);
+    return compiled;
+}
+
 bool VerifyNullAssetDataFlag(const int& flag, std::string& strError)
 {
     // Check the flag
@@ -5144,14 +5229,13 @@ bool ContextualCheckVerifierString(CAssetsCache* cache, const std::string& verif
     if (verifier == "true")
         return true;
 
-    // Check against the non contextual changes first
-    std::set<std::string> setFoundQualifiers;
-    if (!CheckVerifierString(verifier, setFoundQualifiers, strError, errorReport))
+    // Check against the non contextual changes first, these are only done once per verifier string
+    std::shared_ptr<const CCompiledVerifierString> compiled = GetCompiledVerifierString(verifier, strError, errorReport);
+    if (!compiled)
         return false;
 
     // Loop through each qualifier and make sure that the asset exists
-    for(auto qualifier : setFoundQualifiers) {
-        std::string search = QUALIFIER_CHAR + qualifier;
+    for (const auto& search : compiled->vecQualifiers) {
         if (!cache->CheckIfAssetExists(search, true)) {
             if (errorReport) {
                 errorReport->type = ErrorReport::ErrorType::AssetDoesntExist;
@@ -5168,50 +5252,22 @@ bool ContextualCheckVerifierString(CAssetsCache* cache, const std::string& verif
     if (check_address.empty())
         return true;
 
-    // Create an object that stores if an address contains a qualifier
-    LibBoolEE::Vals vals;
-
-    // Add the qualifiers into the vals object
-    for (auto qualifier : setFoundQualifiers) {
-        std::string search = QUALIFIER_CHAR + qualifier;
-
-        // Check to see if the address contains the qualifier
-        bool has_qualifier = cache->CheckForAddressQualifier(search, check_address, true);
-
-        // Add the true or false value into the vals
-        vals.insert(std::make_pair(qualifier, has_qualifier));
-    }
-
-    try {
-        bool ret = LibBoolEE::resolve(verifier, vals, errorReport);
-        if (!ret) {
-            if (errorReport) {
-                if (errorReport->type == ErrorReport::ErrorType::NotSetError) {
-                    errorReport->type = ErrorReport::ErrorType::FailedToVerifyAgainstAddress;
-                    errorReport->vecUserData.emplace_back(check_address);
-                    errorReport->strDevData = "bad-txns-null-verifier-address-failed-verification";
-                }
-            }
-
-            error("%s : The address %s failed to verify against: %s. Is null %d", __func__, check_address, verifier, errorReport ? 0 : 1);
-            strError = "bad-txns-null-verifier-address-failed-verification";
-        }
-        return ret;
-
-    } catch (const std::runtime_error& run_error) {
-
+    // Check which of the qualifiers the address has, and evaluate the verifier string against them
+    uint64_t nQualifierFlags = cache->GetAddressQualifierFlags(compiled->vecQualifiers, check_address, true);
+    bool ret = compiled->formula.evaluate(nQualifierFlags);
+    if (!ret) {
         if (errorReport) {
             if (errorReport->type == ErrorReport::ErrorType::NotSetError) {
-                errorReport->type = ErrorReport::ErrorType::InvalidSyntax;
+                errorReport->type = ErrorReport::ErrorType::FailedToVerifyAgainstAddress;
+                errorReport->vecUserData.emplace_back(check_address);
+                errorReport->strDevData = "bad-txns-null-verifier-address-failed-verification";
             }
-
-            errorReport->vecUserData.emplace_back(run_error.what());
-            errorReport->strDevData = "bad-txns-null-verifier-failed-contexual-syntax-check";
         }
 
-        strError = "bad-txns-null-verifier-failed-contexual-syntax-check";
-        return error("%s : Verifier string failed to resolve. Please check string syntax - exception: %s\n", __func__, run_error.what());
+        error("%s : The address %s failed to verify against: %s. Is null %d", __func__, check_address, verifier, errorReport ? 0 : 1);
+        strError = "bad-txns-null-verifier-address-failed-verification";
     }
+    return ret;
 }
 
 bool ContextualCheckTransferAsset(CAssetsCache* assetCache, const CAssetTransfer& transfer, const std::string& address, std::string& strError)
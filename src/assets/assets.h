@@ -176,7 +176,17 @@ public :
     std::map<CAssetCacheRootQualifierChecker, std::set<std::string> > mapRootQualifierAddressesAdd;
     std::map<CAssetCacheRootQualifierChecker, std::set<std::string> > mapRootQualifierAddressesRemove;
 
-    CAssetsCache() : CAssets()
+    //! The cache this one was layered on, nullptr means the passets global cache
+    CAssetsCache* pBase;
+
+    CAssetsCache() : CAssets(), pBase(nullptr)
+    {
+        SetNull();
+        ClearDirtyCache();
+    }
+
+    //! Create an empty cache on top of base. Lookups fall through to base, and Flush() merges the changes back into it
+    explicit CAssetsCache(CAssetsCache* base) : CAssets(), pBase(base)
     {
         SetNull();
         ClearDirtyCache();
@@ -184,6 +194,8 @@ public :
 
     CAssetsCache(const CAssetsCache& cache) : CAssets(cache)
     {
+        this->pBase = cache.pBase;
+
         //! Copy dirty cache also
         this->vSpentAssets = cache.vSpentAssets;
         this->vUndoAssetAmount = cache.vUndoAssetAmount;
@@ -229,6 +241,7 @@ public :
     {
         this->mapAssetsAddressAmount = cache.mapAssetsAddressAmount;
         this->mapReissuedAssetData = cache.mapReissuedAssetData;
+        this->pBase = cache.pBase;
 
         //! Copy dirty cache also
         this->vSpentAssets = cache.vSpentAssets;
@@ -313,6 +326,8 @@ public :
 
     //! Return true if the address has the given qualifier assigned to it
     bool CheckForAddressQualifier(const std::string &qualifier_name, const std::string& address, bool fSkipTempCache = false);
+    /** Bit i of the result is set if the address has qualifier vecQualifierNames[i], at most 64 qualifiers */
+    uint64_t GetAddressQualifierFlags(const std::vector<std::string>& vecQualifierNames, const std::string& address, bool fSkipTempCache = false);
 
     //! Return true if the address is marked as frozen
     bool CheckForAddressRestriction(const std::string &restricted_name, const std::string& address, bool fSkipTempCache = false);
@@ -327,7 +342,7 @@ public :
     size_t GetCacheSize() const;
     size_t GetCacheSizeV2() const;
 
-    //! Flush all new cache entries into the passets global cache
+    //! Flush all new cache entries into the cache this one was layered on, or the passets global cache
     bool Flush();
 
     //! Write asset cache data to database
@@ -10,6 +10,7 @@
 #include <boost/thread.hpp>
 
 static const char SNAPSHOTCHECK_FLAG = 'C'; // Snapshot Check
+static const char SNAPSHOTCHUNK_FLAG = 'O'; // Snapshot owners chunk
 
 CAssetSnapshotDBEntry::CAssetSnapshotDBEntry()
 {
@@ -47,63 +48,74 @@ bool CAssetSnapshotDB::AddAssetOwnershipSnapshot(
         return false;
     }
 
-    std::set<std::pair<std::string, CAmount>> ownersAndAmounts;
     std::vector<std::pair<std::string, CAmount>> tempOwnersAndAmounts;
-    int totalEntryCount;
+    std::vector<std::pair<std::string, CAmount>> chunkOwnersAndAmounts;
 
-    if (!passetsdb->AssetAddressDir(tempOwnersAndAmounts, totalEntryCount, true, p_assetName, INT_MAX, 0)) {
-        LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Failed to retrieve assets directory for '%s'\n", p_assetName.c_str());
-        return false;
-    }
+    //  The snapshot entry is written last, after all of its chunks
+    CAssetSnapshotDBEntry snapshotEntry(p_assetName, p_height, std::set<std::pair<std::string, CAmount>>());
 
-    //  Retrieve all of the addresses/amounts in batches
-    const int MAX_RETRIEVAL_COUNT = 100;
+    //  Retrieve all of the addresses/amounts in batches, each one continuing after the last address of the previous one.
+    //  Every batch is written as a chunk of the snapshot so the full owner list is never held in memory.
     bool errorsOccurred = false;
+    std::string lastAddress;
+
+    while (true) {
+        int totalEntryCount;
 
-    for (int retrievalOffset = 0; retrievalOffset < totalEntryCount; retrievalOffset += MAX_RETRIEVAL_COUNT) {
         //  Retrieve the specified segment of addresses
-        if (!passetsdb->AssetAddressDir(tempOwnersAndAmounts, totalEntryCount, false, p_assetName, MAX_RETRIEVAL_COUNT, retrievalOffset)) {
+        if (!passetsdb->AssetAddressDir(tempOwnersAndAmounts, totalEntryCount, false, p_assetName, SNAPSHOT_CHUNK_SIZE, 0, lastAddress)) {
             LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Failed to retrieve assets directory for '%s'\n", p_assetName.c_str());
             errorsOccurred = true;
             break;
         }
 
-        //  Verify that some addresses were returned
+        //  An empty segment means every address has been retrieved
         if (tempOwnersAndAmounts.size() == 0) {
-            LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: No addresses were retrieved.\n");
-            continue;
+            break;
         }
+        lastAddress = tempOwnersAndAmounts.back().first;
 
-        //  Move these into the main set
+        //  Move these into the chunk
         for (auto const & currPair : tempOwnersAndAmounts) {
             //  Verify that the address is valid
             CTxDestination dest = DecodeDestination(currPair.first);
             if (IsValidDestination(dest)) {
-                ownersAndAmounts.insert(currPair);
+                chunkOwnersAndAmounts.push_back(currPair);
             }
             else {
                 LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Address '%s' is invalid.\n", currPair.first.c_str());
             }
         }
 
+        if (chunkOwnersAndAmounts.size() > 0) {
+            if (!Write(std::make_pair(SNAPSHOTCHUNK_FLAG, std::make_pair(snapshotEntry.heightAndName, snapshotEntry.nChunks)), chunkOwnersAndAmounts)) {
+                errorsOccurred = true;
+                break;
+            }
+            snapshotEntry.nChunks++;
+            snapshotEntry.nOwners += chunkOwnersAndAmounts.size();
+        }
+
+        bool fLastSegment = tempOwnersAndAmounts.size() < (size_t)SNAPSHOT_CHUNK_SIZE;
         tempOwnersAndAmounts.clear();
+        chunkOwnersAndAmounts.clear();
+        if (fLastSegment)
+            break;
     }
 
     if (errorsOccurred) {
         LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Errors occurred while acquiring ownership info for asset '%s'.\n", p_assetName.c_str());
         return false;
     }
-    if (ownersAndAmounts.size() == 0) {
+    if (snapshotEntry.nOwners == 0) {
         LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: No owners exist for asset '%s'.\n", p_assetName.c_str());
         return false;
     }
 
     //  Write the snapshot to the database. We don't care if we overwrite, because it should be identical.
-    CAssetSnapshotDBEntry snapshotEntry(p_assetName, p_height, ownersAndAmounts);
-
     if (Write(std::make_pair(SNAPSHOTCHECK_FLAG, snapshotEntry.heightAndName), snapshotEntry)) {
         LogPrint(BCLog::REWARDS, "AddAssetOwnershipSnapshot: Successfully added snapshot for '%s' at height %d (ownerCount = %d).\n",
-            p_assetName.c_str(), p_height, ownersAndAmounts.size());
+            p_assetName.c_str(), p_height, snapshotEntry.nOwners);
         return true;
     }
     return false;
@@ -130,6 +142,41 @@ bool CAssetSnapshotDB::RetrieveOwnershipSnapshot(
     return succeeded;
 }
 
+bool CAssetSnapshotDB::RetrieveOwnershipSnapshotChunk(
+    const CAssetSnapshotDBEntry & p_snapshotEntry, int p_chunk,
+    std::vector<std::pair<std::string, CAmount>> & p_ownersAndAmounts)
+{
+    p_ownersAndAmounts.clear();
+    return Read(std::make_pair(SNAPSHOTCHUNK_FLAG, std::make_pair(p_snapshotEntry.heightAndName, p_chunk)), p_ownersAndAmounts);
+}
+
+bool CAssetSnapshotDB::ForEachOwnershipSnapshotChunk(
+    const CAssetSnapshotDBEntry & p_snapshotEntry,
+    const std::function<bool(const std::vector<std::pair<std::string, CAmount>> &)> & p_func)
+{
+    //  Snapshots written before chunking carry all of their owners
+    if (p_snapshotEntry.nChunks == 0) {
+        std::vector<std::pair<std::string, CAmount>> ownersAndAmounts(
+            p_snapshotEntry.ownersAndAmounts.begin(), p_snapshotEntry.ownersAndAmounts.end());
+        p_func(ownersAndAmounts);
+        return true;
+    }
+
+    std::vector<std::pair<std::string, CAmount>> ownersAndAmounts;
+    for (int chunk = 0; chunk < p_snapshotEntry.nChunks; chunk++) {
+        boost::this_thread::interruption_point();
+
+        if (!RetrieveOwnershipSnapshotChunk(p_snapshotEntry, chunk, ownersAndAmounts)) {
+            LogPrint(BCLog::REWARDS, "%s : Failed to retrieve chunk %d of snapshot '%s'\n",
+                __func__, chunk, p_snapshotEntry.heightAndName.c_str());
+            return false;
+        }
+        if (!p_func(ownersAndAmounts))
+            break;
+    }
+    return true;
+}
+
 bool CAssetSnapshotDB::RemoveOwnershipSnapshot(
     const std::string & p_assetName, int p_height)
 {
@@ -140,6 +187,13 @@ bool CAssetSnapshotDB::RemoveOwnershipSnapshot(
         __func__,
         heightAndName.c_str());
 
+    CAssetSnapshotDBEntry snapshotEntry;
+    if (Read(std::make_pair(SNAPSHOTCHECK_FLAG, heightAndName), snapshotEntry)) {
+        for (int chunk = 0; chunk < snapshotEntry.nChunks; chunk++) {
+            Erase(std::make_pair(SNAPSHOTCHUNK_FLAG, std::make_pair(heightAndName, chunk)));
+        }
+    }
+
     bool succeeded = Erase(std::make_pair(SNAPSHOTCHECK_FLAG, heightAndName), true);
 
     LogPrint(BCLog::REWARDS, "%s : Removal of snapshot for '%s' %s!\n",
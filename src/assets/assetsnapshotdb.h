@@ -5,21 +5,31 @@
 #ifndef ASSETSNAPSHOTDB_H
 #define ASSETSNAPSHOTDB_H
 
+#include <functional>
 #include <set>
+#include <vector>
 
 #include <dbwrapper.h>
 #include "amount.h"
 
+//  Number of owners stored together in one chunk of a snapshot
+static const int SNAPSHOT_CHUNK_SIZE = 1000;
+
 class CAssetSnapshotDBEntry
 {
 public:
     int height;
     std::string assetName;
+    //  Only filled for snapshots written before they were stored in chunks
     std::set<std::pair<std::string, CAmount>> ownersAndAmounts;
 
     //  Used as the DB key for the snapshot
     std::string heightAndName;
 
+    //  The owners are stored in nChunks separate entries of at most SNAPSHOT_CHUNK_SIZE owners
+    int32_t nChunks;
+    int64_t nOwners;
+
     CAssetSnapshotDBEntry();
     CAssetSnapshotDBEntry(
         const std::string & p_assetName, const int p_snapshotHeight,
@@ -33,6 +43,9 @@ public:
         ownersAndAmounts.clear();
 
         heightAndName = "";
+
+        nChunks = 0;
+        nOwners = 0;
     }
 
     bool operator<(const CAssetSnapshotDBEntry &rhs) const
@@ -50,6 +63,18 @@ public:
         READWRITE(assetName);
         READWRITE(ownersAndAmounts);
         READWRITE(heightAndName);
+        //  Snapshots written before chunking end here
+        if (ser_action.ForRead()) {
+            if (!s.empty()) {
+                ::Unserialize(s, nChunks);
+                ::Unserialize(s, nOwners);
+            } else {
+                nOwners = ownersAndAmounts.size();
+            }
+        } else {
+            ::Serialize(s, nChunks);
+            ::Serialize(s, nOwners);
+        }
     }
 };
 
@@ -64,11 +89,21 @@ public:
     bool AddAssetOwnershipSnapshot(
         const std::string & p_assetName, int p_height);
 
-    //  Read all of the entries at a specified height
+    //  Read the snapshot at a specified height, without its owners unless it predates chunking
     bool RetrieveOwnershipSnapshot(
         const std::string & p_assetName, int p_height,
         CAssetSnapshotDBEntry & p_snapshotEntry);
 
+    //  Read the owners of one chunk of a snapshot
+    bool RetrieveOwnershipSnapshotChunk(
+        const CAssetSnapshotDBEntry & p_snapshotEntry, int p_chunk,
+        std::vector<std::pair<std::string, CAmount>> & p_ownersAndAmounts);
+
+    //  Call p_func with the owners of every chunk in order, stopping when it returns false
+    bool ForEachOwnershipSnapshotChunk(
+        const CAssetSnapshotDBEntry & p_snapshotEntry,
+        const std::function<bool(const std::vector<std::pair<std::string, CAmount>> &)> & p_func);
+
     //  Remove the asset snapshot at the specified height
     bool RemoveOwnershipSnapshot(
         const std::string & p_assetName, int p_height);
@@ -19,8 +19,13 @@
 #include "assetsnapshotdb.h"
 #include "wallet/wallet.h"
 
+#include <future>
+
 std::map<uint256, CRewardSnapshot> mapRewardSnapshots;
 
+static CCriticalSection cs_distributionProgress;
+static std::map<uint256, CDistributionProgress> mapDistributionProgress;
+
 uint256 CRewardSnapshot::GetHash() const
 {
     return SerializeHash(*this, SER_GETHASH);
@@ -41,10 +46,19 @@ bool AddDistributeRewardSnapshot(CRewardSnapshot& p_rewardSnapshot)
     return true;
 }
 
-bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vector<OwnerAndAmount>& vecDistributionList)
+CDistributionListGenerator::CDistributionListGenerator(const CRewardSnapshot& p_rewardSnapshot)
+    : rewardSnapshot(p_rewardSnapshot)
 {
-    vecDistributionList.clear();
+    modifiedPaymentInAssetUnits = p_rewardSnapshot.nDistributionAmount;
+    totalAmtOwned = 0;
+    nOwners = 0;
+    nOwnersProcessed = 0;
+    nChunk = 0;
+    nChunkPos = 0;
+}
 
+bool CDistributionListGenerator::Init()
+{
     if (passets == nullptr) {
         LogPrint(BCLog::REWARDS, "%s: Invalid assets cache!\n", __func__);
         return false;
@@ -59,17 +73,13 @@ bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vect
     }
 
     //  Get details on the specified source asset
-    CNewAsset distributionAsset;
     //UNUSED_VAR bool srcIsIndivisible = false;
     CAmount srcUnitDivisor = COIN;  //  Default to divisor for RVH
     const int8_t COIN_DIGITS_PAST_DECIMAL = 8;
 
-    //  This value is in indivisible units of the source asset
-    CAmount modifiedPaymentInAssetUnits = p_rewardSnapshot.nDistributionAmount;
-
-    if (p_rewardSnapshot.strDistributionAsset != "RVH") {
-        if (!passets->GetAssetMetaDataIfExists(p_rewardSnapshot.strDistributionAsset, distributionAsset)) {
-            LogPrint(BCLog::REWARDS, "%s: Failed to retrieve asset details for '%s'\n", __func__, p_rewardSnapshot.strDistributionAsset.c_str());
+    if (rewardSnapshot.strDistributionAsset != "RVH") {
+        if (!passets->GetAssetMetaDataIfExists(rewardSnapshot.strDistributionAsset, distributionAsset)) {
+            LogPrint(BCLog::REWARDS, "%s: Failed to retrieve asset details for '%s'\n", __func__, rewardSnapshot.strDistributionAsset.c_str());
             return false;
         }
 
@@ -84,20 +94,20 @@ bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vect
         modifiedPaymentInAssetUnits /= srcDivisor;
 
         LogPrint(BCLog::REWARDS, "%s: Distribution asset '%s' has units %d and divisor %d\n", __func__,
-                 p_rewardSnapshot.strDistributionAsset.c_str(), distributionAsset.units, srcUnitDivisor);
+                 rewardSnapshot.strDistributionAsset.c_str(), distributionAsset.units, srcUnitDivisor);
     }
     else {
         LogPrint(BCLog::REWARDS, "%s: Distribution is RVH with divisor %d\n", __func__, srcUnitDivisor);
     }
 
     LogPrint(BCLog::REWARDS, "%s: Scaled payment amount in %s is %d\n", __func__,
-             p_rewardSnapshot.strDistributionAsset.c_str(), modifiedPaymentInAssetUnits);
+             rewardSnapshot.strDistributionAsset.c_str(), modifiedPaymentInAssetUnits);
 
     //  Get details on the ownership asset
     CNewAsset ownershipAsset;
     CAmount tgtUnitDivisor = 0;
-    if (!passets->GetAssetMetaDataIfExists(p_rewardSnapshot.strOwnershipAsset, ownershipAsset)) {
-        LogPrint(BCLog::REWARDS, "%s: Failed to retrieve asset details for '%s'\n", __func__, p_rewardSnapshot.strOwnershipAsset.c_str());
+    if (!passets->GetAssetMetaDataIfExists(rewardSnapshot.strOwnershipAsset, ownershipAsset)) {
+        LogPrint(BCLog::REWARDS, "%s: Failed to retrieve asset details for '%s'\n", __func__, rewardSnapshot.strOwnershipAsset.c_str());
         return false;
     }
 
@@ -105,37 +115,36 @@ bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vect
     tgtUnitDivisor = static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - ownershipAsset.units));
 
     LogPrint(BCLog::REWARDS, "%s: Ownership asset '%s' has units %d and divisor %d\n", __func__,
-             p_rewardSnapshot.strOwnershipAsset.c_str(), ownershipAsset.units, tgtUnitDivisor);
+             rewardSnapshot.strOwnershipAsset.c_str(), ownershipAsset.units, tgtUnitDivisor);
 
     //  Remove exception addresses & amounts from the list
-    std::set<std::string> exceptionAddressSet;
-    boost::split(exceptionAddressSet, p_rewardSnapshot.strExceptionAddresses, boost::is_any_of(ADDRESS_COMMA_DELIMITER));
-
-    std::set<OwnerAndAmount> nonExceptionOwnerships;
-    CAmount totalAmtOwned = 0;
+    boost::split(exceptionAddressSet, rewardSnapshot.strExceptionAddresses, boost::is_any_of(ADDRESS_COMMA_DELIMITER));
 
-    CAssetSnapshotDBEntry snapshotEntry;
-    if (!pAssetSnapshotDb->RetrieveOwnershipSnapshot(p_rewardSnapshot.strOwnershipAsset, p_rewardSnapshot.nHeight, snapshotEntry)) {
+    if (!pAssetSnapshotDb->RetrieveOwnershipSnapshot(rewardSnapshot.strOwnershipAsset, rewardSnapshot.nHeight, snapshotEntry)) {
         LogPrint(BCLog::REWARDS, "%s: Failed to retrieve ownership snapshot list!\n", __func__);
         return false;
     }
 
-    for (auto const & currPair : snapshotEntry.ownersAndAmounts) {
-        //  Ignore exception and burn addresses
-        if (
-                exceptionAddressSet.find(currPair.first) == exceptionAddressSet.end()
-                && !Params().IsBurnAddress(currPair.first)
-                ) {
-            //  Address is valid so add it to the payment list
-            nonExceptionOwnerships.insert(OwnerAndAmount(currPair.first, currPair.second));
-            totalAmtOwned += currPair.second;
-        }
+    //  The payments depend on the total amount owned, so total it in a first pass over the snapshot
+    bool fRead = pAssetSnapshotDb->ForEachOwnershipSnapshotChunk(snapshotEntry,
+        [this](const std::vector<std::pair<std::string, CAmount>> & ownersAndAmounts) {
+            for (auto const & currPair : ownersAndAmounts) {
+                if (IsPaid(currPair.first)) {
+                    totalAmtOwned += currPair.second;
+                    nOwners++;
+                }
+            }
+            return true;
+        });
+    if (!fRead) {
+        LogPrint(BCLog::REWARDS, "%s: Failed to retrieve ownership snapshot list!\n", __func__);
+        return false;
     }
 
     //  Make sure we have some addresses to pay to
-    if (nonExceptionOwnerships.size() == 0) {
+    if (nOwners == 0) {
         LogPrint(BCLog::REWARDS, "%s: Ownership of '%s' includes only exception/burn addresses.\n", __func__,
-                 p_rewardSnapshot.strOwnershipAsset.c_str());
+                 rewardSnapshot.strOwnershipAsset.c_str());
         return false;
     }
 
@@ -145,33 +154,111 @@ bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vect
     LogPrint(BCLog::REWARDS, "%s: Total payout amount %d\n", __func__,
              modifiedPaymentInAssetUnits);
 
-    CAmount totalSentAsRewards = 0;
-    //  Loop through asset owners
-    for (auto & ownership : nonExceptionOwnerships) {
-        // Get percentage of total ownership
-        long double percent = (long double)ownership.amount / (long double)totalAmtOwned;
-        // Caculate the reward with potentional unit inaccurancies e.g with units 4, 90054100 satoshis = 0.90054100
-        CAmount rewardAmt = percent * modifiedPaymentInAssetUnits * static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
-        // Remove all none accurate units e.g with units 4 90054100 => 9005
-        rewardAmt /= static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
-        // Replace all none accurate units back with zeros e.g with units 4 9005 => 90050000 satoshis = 0.90050000
-        rewardAmt *= static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
+    return true;
+}
+
+bool CDistributionListGenerator::IsPaid(const std::string& p_address) const
+{
+    //  Ignore exception and burn addresses
+    return exceptionAddressSet.find(p_address) == exceptionAddressSet.end() && !Params().IsBurnAddress(p_address);
+}
+
+CAmount CDistributionListGenerator::ComputeReward(CAmount p_amountOwned) const
+{
+    const int8_t COIN_DIGITS_PAST_DECIMAL = 8;
+
+    // Get percentage of total ownership
+    long double percent = (long double)p_amountOwned / (long double)totalAmtOwned;
+    // Caculate the reward with potentional unit inaccurancies e.g with units 4, 90054100 satoshis = 0.90054100
+    CAmount rewardAmt = percent * modifiedPaymentInAssetUnits * static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
+    // Remove all none accurate units e.g with units 4 90054100 => 9005
+    rewardAmt /= static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
+    // Replace all none accurate units back with zeros e.g with units 4 9005 => 90050000 satoshis = 0.90050000
+    rewardAmt *= static_cast<CAmount>(pow(10, COIN_DIGITS_PAST_DECIMAL - distributionAsset.units));
+
+    return rewardAmt;
+}
 
-        totalSentAsRewards += rewardAmt;
+bool CDistributionListGenerator::ReadChunk(int p_chunk)
+{
+    nChunkPos = 0;
+
+    //  Snapshots written before chunking are a single chunk
+    if (snapshotEntry.nChunks == 0) {
+        chunk.assign(snapshotEntry.ownersAndAmounts.begin(), snapshotEntry.ownersAndAmounts.end());
+        return true;
+    }
+
+    return pAssetSnapshotDb->RetrieveOwnershipSnapshotChunk(snapshotEntry, p_chunk, chunk);
+}
+
+bool CDistributionListGenerator::NextBatch(std::vector<OwnerAndAmount>& p_batch, size_t p_maxPayments)
+{
+    p_batch.clear();
+
+    const int nChunks = std::max(snapshotEntry.nChunks, 1);
+    while (p_batch.size() < p_maxPayments) {
+        if (nChunkPos == chunk.size()) {
+            if (nChunk == nChunks)
+                break;
+            if (!ReadChunk(nChunk)) {
+                LogPrint(BCLog::REWARDS, "%s: Failed to retrieve chunk %d of the ownership snapshot!\n", __func__, nChunk);
+                return false;
+            }
+            nChunk++;
+            continue;
+        }
+
+        const std::pair<std::string, CAmount>& ownership = chunk[nChunkPos++];
+        if (!IsPaid(ownership.first))
+            continue;
+        nOwnersProcessed++;
+
+        CAmount rewardAmt = ComputeReward(ownership.second);
 
         LogPrint(BCLog::REWARDS, "%s: Found ownership address for '%s': '%s' owns %d => reward %d\n", __func__,
-                 p_rewardSnapshot.strOwnershipAsset.c_str(), ownership.address.c_str(),
-                 ownership.amount, rewardAmt);
+                 rewardSnapshot.strOwnershipAsset.c_str(), ownership.first.c_str(),
+                 ownership.second, rewardAmt);
 
         //  Save it into our list if the reward payment is above zero
         if (rewardAmt > 0)
-            vecDistributionList.push_back(OwnerAndAmount(ownership.address, rewardAmt));
+            p_batch.push_back(OwnerAndAmount(ownership.first, rewardAmt));
     }
 
-    CAmount change = totalAmtOwned - totalSentAsRewards;
-    if (change > 0) {
-        LogPrint(BCLog::REWARDS, "%s: Found change amount of %u\n", __func__, change);
-    }
+    return true;
+}
+
+bool GetDistributionProgress(const uint256& p_rewardSnapshotHash, CDistributionProgress& p_progress)
+{
+    LOCK(cs_distributionProgress);
+    auto it = mapDistributionProgress.find(p_rewardSnapshotHash);
+    if (it == mapDistributionProgress.end())
+        return false;
+    p_progress = it->second;
+    return true;
+}
+
+static void SetDistributionProgress(const uint256& p_rewardSnapshotHash, CDistributionProgress& p_progress)
+{
+    p_progress.nLastUpdate = GetTime();
+    LOCK(cs_distributionProgress);
+    mapDistributionProgress[p_rewardSnapshotHash] = p_progress;
+}
+
+bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vector<OwnerAndAmount>& vecDistributionList)
+{
+    vecDistributionList.clear();
+
+    CDistributionListGenerator generator(p_rewardSnapshot);
+    if (!generator.Init())
+        return false;
+
+    std::vector<OwnerAndAmount> batch;
+    do {
+        if (!generator.NextBatch(batch, MAX_PAYMENTS_PER_TRANSACTION))
+            return false;
+        vecDistributionList.insert(vecDistributionList.end(), batch.begin(), batch.end());
+    } while (!batch.empty());
 
     return true;
 }
@@ -190,26 +277,35 @@ void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewar
         return;
     }
 
-    //  Retrieve the asset snapshot entry for the target asset at the specified height
-    CAssetSnapshotDBEntry snapshotEntry;
-
-    if (!pAssetSnapshotDb->RetrieveOwnershipSnapshot(p_rewardSnapshot.strOwnershipAsset, p_rewardSnapshot.nHeight, snapshotEntry)) {
-        LogPrint(BCLog::REWARDS, "Failed to retrieve ownership snapshot!\n");
+    //  Stream the payments, one transaction worth at a time
+    CDistributionListGenerator generator(p_rewardSnapshot);
+    if (!generator.Init()) {
+        LogPrint(BCLog::REWARDS, "Failed to generate payment details!\n");
         return;
     }
 
-    //  Generate payment transactions and store in the payments DB
+    auto rewardSnapshotHash = p_rewardSnapshot.GetHash();
+    CDistributionProgress progress;
+    progress.nOwners = generator.GetOwners();
+
     std::vector<OwnerAndAmount> paymentDetails;
-    if (!GenerateDistributionList(p_rewardSnapshot, paymentDetails)) {
+    std::vector<OwnerAndAmount> nextPaymentDetails;
+    if (!generator.NextBatch(paymentDetails, MAX_PAYMENTS_PER_TRANSACTION)) {
         LogPrint(BCLog::REWARDS, "Failed to generate payment details!\n");
         return;
     }
 
-    int nNumberOfTransactions = ((int)paymentDetails.size() / MAX_PAYMENTS_PER_TRANSACTION) + 1;
-    CRewardSnapshot copyRewardSnapshot = p_rewardSnapshot;
-    for (int i = 0; i < nNumberOfTransactions; i++) {
+    for (int i = 0; !paymentDetails.empty(); i++) {
+        //  The payments of the next transaction are worked out on another thread while this one is
+        //  looked up or created. The transactions themselves are created one after the other, as
+        //  they all spend from this wallet.
+        std::future<bool> nextReady = std::async(std::launch::async, [&generator, &nextPaymentDetails] {
+            return generator.NextBatch(nextPaymentDetails, MAX_PAYMENTS_PER_TRANSACTION);
+        });
+        progress.nTransactions = i + 1;
+
         uint256 txid;
-        if (pDistributeSnapshotDb->GetDistributeTransaction(p_rewardSnapshot.GetHash(), i, txid)) {
+        if (pDistributeSnapshotDb->GetDistributeTransaction(rewardSnapshotHash, i, txid)) {
             CTransactionRef txRef;
             uint256 hashBlock;
             auto walletTx = p_wallet->GetWalletTx(txid);
@@ -217,13 +313,16 @@ void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewar
                 int depth = walletTx->GetDepthInMainChain();
                 if (depth < 0) {
                     LogPrint(BCLog::REWARDS, "Failed distribution: Tx conflict with another tx: %s: number of block back %d!\n", txid.GetHex(), depth);
+                    SetDistributionProgress(rewardSnapshotHash, progress);
                     return;
                 } else if (depth == 0) {
                     LogPrint(BCLog::REWARDS, "Tx is in the mempool! %s\n", txid.GetHex());
+                    progress.nTransactionsPending++;
+                    SetDistributionProgress(rewardSnapshotHash, progress);
                     return;
                 } else if (depth > 0) {
                     LogPrint(BCLog::REWARDS, "Tx is in a block %s!\n", txid.GetHex());
-                    continue;
+                    progress.nTransactionsConfirmed++;
                 }
             } else {
                 LogPrint(BCLog::REWARDS, "Failed to get wallet Tx: %s\n", txid.GetHex());
@@ -231,16 +330,30 @@ void DistributeRewardSnapshot(CWallet * p_wallet, const CRewardSnapshot& p_rewar
         } else {
             LogPrint(BCLog::REWARDS, "Didn't find transaction in database creating new transaction: %s %s %d %d\n", p_rewardSnapshot.strOwnershipAsset, p_rewardSnapshot.strDistributionAsset, p_rewardSnapshot.nDistributionAmount, i);
             // Create a new transaction and database it
-            int start = i * MAX_PAYMENTS_PER_TRANSACTION;
             uint256 retTxid;
             std::string change = "";
-            if (!BuildTransaction(p_wallet, p_rewardSnapshot, paymentDetails, start, change, retTxid)) {
+            if (!BuildTransaction(p_wallet, p_rewardSnapshot, paymentDetails, 0, change, retTxid)) {
                 LogPrint(BCLog::REWARDS, "Failed to build Tx: distribute: %s, amount: %d\n", p_rewardSnapshot.strDistributionAsset, p_rewardSnapshot.nDistributionAmount);
+                SetDistributionProgress(rewardSnapshotHash, progress);
                 return;
             }
-            pDistributeSnapshotDb->AddDistributeTransaction(p_rewardSnapshot.GetHash(), i, retTxid);
+            pDistributeSnapshotDb->AddDistributeTransaction(rewardSnapshotHash, i, retTxid);
+            progress.nTransactionsCreated++;
         }
+
+        if (!nextReady.get()) {
+            LogPrint(BCLog::REWARDS, "Failed to generate payment details!\n");
+            SetDistributionProgress(rewardSnapshotHash, progress);
+            return;
+        }
+        paymentDetails.swap(nextPaymentDetails);
+        progress.nOwnersProcessed = generator.GetOwnersProcessed();
+        SetDistributionProgress(rewardSnapshotHash, progress);
     }
+
+    progress.nOwnersProcessed = generator.GetOwnersProcessed();
+    progress.fComplete = progress.nTransactionsConfirmed == progress.nTransactions;
+    SetDistributionProgress(rewardSnapshotHash, progress);
 }
 
 bool BuildTransaction(
@@ -9,6 +9,7 @@
 #include "amount.h"
 #include "tinyformat.h"
 #include "assettypes.h"
+#include "assetsnapshotdb.h"
 
 #include <string>
 #include <set>
@@ -147,6 +148,71 @@ enum {
     FAILED_
 };
 
+//  Walks the ownership snapshot of a reward one chunk at a time and hands out its payments in order,
+//  so neither the owners nor the payments of an asset with many holders are held in memory at once
+class CDistributionListGenerator
+{
+public:
+    explicit CDistributionListGenerator(const CRewardSnapshot& p_rewardSnapshot);
+
+    //  Load the asset details and total the amount owned by the addresses being paid. Requires cs_main.
+    bool Init();
+
+    //  Replace p_batch with the next (at most) p_maxPayments payments. p_batch is left empty once every owner has been paid.
+    bool NextBatch(std::vector<OwnerAndAmount>& p_batch, size_t p_maxPayments);
+
+    int64_t GetOwners() const { return nOwners; }
+    int64_t GetOwnersProcessed() const { return nOwnersProcessed; }
+
+private:
+    bool IsPaid(const std::string& p_address) const;
+    CAmount ComputeReward(CAmount p_amountOwned) const;
+    bool ReadChunk(int p_chunk);
+
+    CRewardSnapshot rewardSnapshot;
+    CAssetSnapshotDBEntry snapshotEntry;
+    std::set<std::string> exceptionAddressSet;
+    CNewAsset distributionAsset;
+
+    //  This value is in indivisible units of the source asset
+    CAmount modifiedPaymentInAssetUnits;
+    CAmount totalAmtOwned;
+    int64_t nOwners;
+    int64_t nOwnersProcessed;
+
+    //  Position of the next owner in the snapshot
+    int nChunk;
+    size_t nChunkPos;
+    std::vector<std::pair<std::string, CAmount>> chunk;
+};
+
+//  Progress of the last pass over a reward distribution, reported by getdistributestatus
+struct CDistributionProgress
+{
+    int64_t nOwners;
+    int64_t nOwnersProcessed;
+    int nTransactions;
+    int nTransactionsConfirmed;
+    int nTransactionsPending;
+    int nTransactionsCreated;
+    bool fComplete;
+    int64_t nLastUpdate;
+
+    CDistributionProgress()
+    {
+        nOwners = 0;
+        nOwnersProcessed = 0;
+        nTransactions = 0;
+        nTransactionsConfirmed = 0;
+        nTransactionsPending = 0;
+        nTransactionsCreated = 0;
+        fComplete = false;
+        nLastUpdate = 0;
+    }
+};
+
+bool GetDistributionProgress(const uint256& p_rewardSnapshotHash, CDistributionProgress& p_progress);
+
 bool GenerateDistributionList(const CRewardSnapshot& p_rewardSnapshot, std::vector<OwnerAndAmount>& vecDistributionList);
 bool AddDistributeRewardSnapshot(CRewardSnapshot& p_rewardSnapshot);
 
@@ -0,0 +1,67 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "pow.h"
+#include "streams.h"
+#include "util.h"
+#include "validation.h"
+
+#include "bench/data/block813851.raw.h"
+
+// Size of a full "headers" message
+static const size_t HEADER_BATCH_SIZE = 2000;
+
+// Builds a headers message worth of X16R headers from the header of the recorded block, each with a
+// different nonce and parent so that every header selects its own algorithm order.
+static std::vector<CBlockHeader> CreateHeaderBatch()
+{
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    std::vector<CBlockHeader> headers;
+    CBlockHeader header = block.GetBlockHeader();
+    header.nTime = 1600000000;
+    for (size_t i = 0; i < HEADER_BATCH_SIZE; i++) {
+        header.nNonce = i;
+        header.hashPrevBlock = header.GetHash();
+        headers.push_back(header);
+    }
+    return headers;
+}
+
+// What ProcessNewBlockHeaders used to do under cs_main: hash and check one header after the other
+static void HeaderBatchSerial(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::vector<CBlockHeader> headers = CreateHeaderBatch();
+
+    while (state.KeepRunning()) {
+        for (const CBlockHeader& header : headers) {
+            CheckProofOfWork(header.GetHash(), header.nBits, consensusParams);
+        }
+    }
+}
+
+static void HeaderBatchPreVerify(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    std::vector<CBlockHeader> headers = CreateHeaderBatch();
+    std::vector<CHeaderPoWResult> results;
+
+    StartHeaderCheckThreads(GetNumCores());
+    while (state.KeepRunning()) {
+        PreVerifyBlockHeaders(headers, consensusParams, results);
+    }
+}
+
+BENCHMARK(HeaderBatchSerial);
+BENCHMARK(HeaderBatchPreVerify);
@@ -5,6 +5,7 @@
 
 #include "bench.h"
 #include "random.h"
+#include "bls/bls_batchverifier.h"
 #include "bls/bls_worker.h"
 #include "utiltime.h"
 
@@ -349,6 +350,80 @@ static void BLSVerify_BatchedParallel(benchmark::State& state)
     }
 }
 
+struct SigShareLoadEntry {
+    int nodeId;
+    std::pair<uint256, uint16_t> key;
+    uint256 msgHash;
+    CBLSSignature sig;
+    CBLSPublicKey pubKey;
+};
+
+// The sig shares a smartnode verifies under InstantSend load: many signing sessions of one quorum at the same time,
+// each with shares of most members, relayed by a few peers. The share of invalidCount members is signed with the
+// wrong key.
+static void BuildSigShareLoad(size_t sessionCount, size_t memberCount, size_t sharesPerSession, int nodeCount,
+                              size_t invalidCount, std::vector<SigShareLoadEntry>& shares)
+{
+    BLSSecretKeyVector secKeys(memberCount);
+    BLSPublicKeyVector pubKeys(memberCount);
+    for (size_t i = 0; i < memberCount; i++) {
+        secKeys[i].MakeNewKey();
+        pubKeys[i] = secKeys[i].GetPublicKey();
+    }
+    CBLSSecretKey wrongKey;
+    wrongKey.MakeNewKey();
+
+    for (size_t i = 0; i < sessionCount; i++) {
+        uint256 signHash = GetRandHash();
+        for (size_t j = 0; j < sharesPerSession; j++) {
+            size_t member = (i + j) % memberCount;
+            bool invalid = i == 0 && j < invalidCount;
+            shares.push_back({GetRandInt(nodeCount), std::make_pair(signHash, (uint16_t)member), signHash,
+                              (invalid ? wrongKey : secKeys[member]).Sign(signHash), pubKeys[member]});
+        }
+    }
+}
+
+static void BLSVerify_SigShareLoad(benchmark::State& state, bool parallel, size_t invalidCount)
+{
+    std::vector<SigShareLoadEntry> shares;
+    BuildSigShareLoad(32, 50, 30, 8, invalidCount, shares);
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        CBLSBatchVerifier<int, std::pair<uint256, uint16_t>> batchVerifier(false, true);
+        for (const auto& share : shares) {
+            batchVerifier.PushMessage(share.nodeId, share.key, share.msgHash, share.sig, share.pubKey);
+        }
+        if (parallel) {
+            batchVerifier.VerifyParallel(blsWorker, 16);
+        } else {
+            batchVerifier.Verify();
+        }
+        assert(batchVerifier.badMessages.size() == invalidCount);
+    }
+}
+
+static void BLSVerify_SigShareLoadSerial(benchmark::State& state)
+{
+    BLSVerify_SigShareLoad(state, false, 0);
+}
+
+static void BLSVerify_SigShareLoadParallel(benchmark::State& state)
+{
+    BLSVerify_SigShareLoad(state, true, 0);
+}
+
+static void BLSVerify_SigShareLoadSerialInvalid(benchmark::State& state)
+{
+    BLSVerify_SigShareLoad(state, false, 1);
+}
+
+static void BLSVerify_SigShareLoadParallelInvalid(benchmark::State& state)
+{
+    BLSVerify_SigShareLoad(state, true, 1);
+}
+
 BENCHMARK(BLSPubKeyAggregate_Normal)
 BENCHMARK(BLSSecKeyAggregate_Normal)
 BENCHMARK(BLSSign_Normal)
@@ -361,3 +436,7 @@ BENCHMARK(BLSVerify_LargeAggregatedBlock10000)
 BENCHMARK(BLSVerify_LargeAggregatedBlock1000PreVerified)
 BENCHMARK(BLSVerify_Batched)
 BENCHMARK(BLSVerify_BatchedParallel)
+BENCHMARK(BLSVerify_SigShareLoadSerial)
+BENCHMARK(BLSVerify_SigShareLoadParallel)
+BENCHMARK(BLSVerify_SigShareLoadSerialInvalid)
+BENCHMARK(BLSVerify_SigShareLoadParallelInvalid)
@@ -12,10 +12,12 @@
 #include "random.h"
 #include "uint256.h"
 #include "utiltime.h"
+#include "crypto/common.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
 #include "crypto/sha512.h"
+#include "cryptonote/slow-hash.h"
 
 /* Number of bytes to hash per iteration */
 static const uint64_t BUFFER_SIZE = 1000*1000;
@@ -162,6 +164,75 @@ static void HASH_DSHA256_2048b_single(benchmark::State& state)
         CHash256().Write(in.data(), in.size()).Finalize(&in[0]);
 }
 
+/* X16R over an 80 byte header for 1000 nonces on the same parent */
+static void HASH_X16R(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80,0);
+    uint256 prevBlockHash = uint256S("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+    while (state.KeepRunning()) {
+        for (uint32_t nonce = 0; nonce < 1000; nonce++) {
+            WriteLE32(&in[76], nonce);
+            HashX16R(in.begin(), in.end(), prevBlockHash);
+        }
+    }
+}
+
+static void HASH_X16R_Context(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80,0);
+    const HashX16RContext context(uint256S("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"));
+    while (state.KeepRunning()) {
+        for (uint32_t nonce = 0; nonce < 1000; nonce++) {
+            WriteLE32(&in[76], nonce);
+            context.Hash(in.begin(), in.end());
+        }
+    }
+}
+
+static void HASH_X16R_Batch(benchmark::State& state)
+{
+    std::vector<uint8_t> in(80 * X16R_BATCH_LANES, 0);
+    const HashX16RContext context(uint256S("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"));
+    uint256 hashes[X16R_BATCH_LANES];
+    while (state.KeepRunning()) {
+        for (uint32_t nonce = 0; nonce < 1000; nonce += X16R_BATCH_LANES) {
+            for (int i = 0; i < X16R_BATCH_LANES; i++) {
+                WriteLE32(&in[80 * i + 76], nonce + i);
+            }
+            context.HashBatch(in.data(), 80, hashes);
+        }
+    }
+}
+
+/* CryptoNight variants as used by cnHash, allocating per call vs. the per-thread scratchpad */
+template<uint32_t page_size, uint32_t iterations, size_t aes_rounds>
+static void CNHash(benchmark::State& state, bool fCached)
+{
+    std::vector<char> in(80, 0);
+    char hash[32];
+    while (state.KeepRunning()) {
+        if (fCached) {
+            crypto::cn_slow_hash(in.data(), hash, in.size(), 1, page_size, iterations, aes_rounds);
+        } else {
+            crypto::cn_slow_hash_uncached(in.data(), hash, in.size(), 1, page_size, iterations, aes_rounds);
+        }
+        in[0] = hash[0];
+    }
+}
+
+static void HASH_CNDark_Uncached(benchmark::State& state) { CNHash<CN_DARK_PAGE_SIZE, CN_DARK_ITERATIONS, CN_DARK_AES_ROUNDS>(state, false); }
+static void HASH_CNDark(benchmark::State& state) { CNHash<CN_DARK_PAGE_SIZE, CN_DARK_ITERATIONS, CN_DARK_AES_ROUNDS>(state, true); }
+static void HASH_CNDarklite_Uncached(benchmark::State& state) { CNHash<CN_DARK_PAGE_SIZE, CN_DARK_ITERATIONS, CN_DARK_LITE_AES_ROUNDS>(state, false); }
+static void HASH_CNDarklite(benchmark::State& state) { CNHash<CN_DARK_PAGE_SIZE, CN_DARK_ITERATIONS, CN_DARK_LITE_AES_ROUNDS>(state, true); }
+static void HASH_CNFast_Uncached(benchmark::State& state) { CNHash<CN_FAST_PAGE_SIZE, CN_FAST_ITERATIONS, CN_FAST_AES_ROUNDS>(state, false); }
+static void HASH_CNFast(benchmark::State& state) { CNHash<CN_FAST_PAGE_SIZE, CN_FAST_ITERATIONS, CN_FAST_AES_ROUNDS>(state, true); }
+static void HASH_CNLite_Uncached(benchmark::State& state) { CNHash<CN_LITE_PAGE_SIZE, CN_LITE_ITERATIONS, CN_LITE_AES_ROUNDS>(state, false); }
+static void HASH_CNLite(benchmark::State& state) { CNHash<CN_LITE_PAGE_SIZE, CN_LITE_ITERATIONS, CN_LITE_AES_ROUNDS>(state, true); }
+static void HASH_CNTurtle_Uncached(benchmark::State& state) { CNHash<CN_TURTLE_PAGE_SIZE, CN_TURTLE_ITERATIONS, CN_TURTLE_AES_ROUNDS>(state, false); }
+static void HASH_CNTurtle(benchmark::State& state) { CNHash<CN_TURTLE_PAGE_SIZE, CN_TURTLE_ITERATIONS, CN_TURTLE_AES_ROUNDS>(state, true); }
+static void HASH_CNTurtlelite_Uncached(benchmark::State& state) { CNHash<CN_TURTLE_PAGE_SIZE, CN_TURTLE_ITERATIONS, CN_TURTLE_LITE_AES_ROUNDS>(state, false); }
+static void HASH_CNTurtlelite(benchmark::State& state) { CNHash<CN_TURTLE_PAGE_SIZE, CN_TURTLE_ITERATIONS, CN_TURTLE_LITE_AES_ROUNDS>(state, true); }
+
 BENCHMARK(HASH_RIPEMD160);
 BENCHMARK(HASH_SHA1);
 BENCHMARK(HASH_SHA256);
@@ -180,5 +251,22 @@ BENCHMARK(HASH_DSHA256_0512b_single);
 BENCHMARK(HASH_DSHA256_1024b_single);
 BENCHMARK(HASH_DSHA256_2048b_single);
 
+BENCHMARK(HASH_X16R);
+BENCHMARK(HASH_X16R_Context);
+BENCHMARK(HASH_X16R_Batch);
+
+BENCHMARK(HASH_CNDark_Uncached);
+BENCHMARK(HASH_CNDark);
+BENCHMARK(HASH_CNDarklite_Uncached);
+BENCHMARK(HASH_CNDarklite);
+BENCHMARK(HASH_CNFast_Uncached);
+BENCHMARK(HASH_CNFast);
+BENCHMARK(HASH_CNLite_Uncached);
+BENCHMARK(HASH_CNLite);
+BENCHMARK(HASH_CNTurtle_Uncached);
+BENCHMARK(HASH_CNTurtle);
+BENCHMARK(HASH_CNTurtlelite_Uncached);
+BENCHMARK(HASH_CNTurtlelite);
+
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
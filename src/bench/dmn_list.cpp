@@ -0,0 +1,105 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "evo/deterministicmns.h"
+#include "evo/evodb.h"
+#include "random.h"
+
+static const int DMN_BENCH_BLOCKS = 5000;
+static const int DMN_BENCH_MNS = 400;
+
+/** A chain whose smartnode list changes in every block, stored in an in-memory evo database */
+struct DMNBenchChain
+{
+    CEvoDB evoDb{1 << 20, true, true};
+    std::vector<uint256> vHashes;
+    std::vector<CBlockIndex> vIndex;
+
+    DMNBenchChain() : vHashes(DMN_BENCH_BLOCKS), vIndex(DMN_BENCH_BLOCKS)
+    {
+        SelectParams(CBaseChainParams::MAIN);
+        FastRandomContext rng(true);
+
+        for (int i = 0; i < DMN_BENCH_BLOCKS; i++) {
+            vHashes[i] = rng.rand256();
+            vIndex[i].phashBlock = &vHashes[i];
+            vIndex[i].nHeight = i;
+            vIndex[i].pprev = i ? &vIndex[i - 1] : nullptr;
+        }
+    }
+
+    // Write the diffs the way ProcessBlock does: one MN registers per block until there are DMN_BENCH_MNS, and
+    // two random MNs get paid in every block
+    void Write(int nSnapshotPeriod)
+    {
+        FastRandomContext rng(true);
+        CDeterministicMNManager dmnman(evoDb, nSnapshotPeriod);
+        LOCK(dmnman.cs);
+
+        CDeterministicMNList list(vHashes[0], -1, 0);
+        for (int i = 1; i < DMN_BENCH_BLOCKS; i++) {
+            CDeterministicMNList newList = list;
+            newList.SetBlockHash(vHashes[i]);
+            newList.SetHeight(i);
+            if (i <= DMN_BENCH_MNS) {
+                auto dmn = std::make_shared<CDeterministicMN>();
+                dmn->proTxHash = rng.rand256();
+                dmn->internalId = newList.GetTotalRegisteredCount();
+                dmn->collateralOutpoint = COutPoint(dmn->proTxHash, 0);
+                auto state = std::make_shared<CDeterministicMNState>();
+                state->nRegisteredHeight = i;
+                state->keyIDOwner = CKeyID(uint160(std::vector<unsigned char>(dmn->proTxHash.begin(), dmn->proTxHash.begin() + 20)));
+                dmn->pdmnState = state;
+                newList.AddMN(dmn);
+                newList.SetTotalRegisteredCount(newList.GetTotalRegisteredCount() + 1);
+            }
+            for (int j = 0; j < 2; j++) {
+                auto dmn = newList.GetMNByInternalId(rng.randrange(newList.GetTotalRegisteredCount()));
+                auto state = std::make_shared<CDeterministicMNState>(*dmn->pdmnState);
+                state->nLastPaidHeight = i;
+                newList.UpdateMN(dmn, state);
+            }
+            dmnman.WriteList(&vIndex[i], list, newList);
+            list = newList;
+        }
+    }
+};
+
+// Lists of random heights, as protx list and the verification of old quorum commitments request them. Every
+// query replays on average half a snapshot period of diffs, minus what the list cache already holds.
+static void DMNListQueries(benchmark::State& state, int nSnapshotPeriod, size_t nListCacheSize)
+{
+    DMNBenchChain chain;
+    chain.Write(nSnapshotPeriod);
+
+    FastRandomContext rng(true);
+    CDeterministicMNManager dmnman(chain.evoDb, nSnapshotPeriod, nListCacheSize);
+    while (state.KeepRunning()) {
+        CDeterministicMNList list = dmnman.GetListForBlock(&chain.vIndex[1 + rng.randrange(DMN_BENCH_BLOCKS - 1)]);
+        assert(list.GetAllMNsCount() > 0);
+    }
+}
+
+static void DMNList_RandomHeight_NoCache(benchmark::State& state)
+{
+    DMNListQueries(state, DEFAULT_DMN_SNAPSHOT_PERIOD, 1);
+}
+
+static void DMNList_RandomHeight(benchmark::State& state)
+{
+    DMNListQueries(state, DEFAULT_DMN_SNAPSHOT_PERIOD, DEFAULT_DMN_LIST_CACHE);
+}
+
+static void DMNList_RandomHeight_Dense(benchmark::State& state)
+{
+    DMNListQueries(state, DEFAULT_DMN_SNAPSHOT_PERIOD / 8, DEFAULT_DMN_LIST_CACHE);
+}
+
+BENCHMARK(DMNList_RandomHeight_NoCache);
+BENCHMARK(DMNList_RandomHeight);
+BENCHMARK(DMNList_RandomHeight_Dense);
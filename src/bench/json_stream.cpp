@@ -0,0 +1,84 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "core_io.h"
+#include "primitives/block.h"
+#include "rpc/jsonstream.h"
+#include "streams.h"
+
+#include "bench/data/block813851.raw.h"
+
+#include <univalue.h>
+
+static CBlock LoadBenchBlock()
+{
+    SelectParams(CBaseChainParams::MAIN);
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    return block;
+}
+
+static UniValue TxToJSON(const CTransaction& tx)
+{
+    UniValue objTx(UniValue::VOBJ);
+    TxToUniv(tx, uint256(), objTx);
+    return objTx;
+}
+
+// The transactions of a block the way getblock with verbosity 2 produced them: the whole tree is
+// built, then written into one string. Nothing can be sent before the end.
+static void JSONStream_Tree(benchmark::State& state)
+{
+    CBlock block = LoadBenchBlock();
+    while (state.KeepRunning()) {
+        UniValue txs(UniValue::VARR);
+        for (const auto& tx : block.vtx)
+            txs.push_back(TxToJSON(*tx));
+        std::string strJSON = txs.write();
+        assert(!strJSON.empty());
+    }
+}
+
+// The same output through a JSONStreamWriter. Only one transaction tree and one chunk are held
+// at a time.
+static void JSONStream_Stream(benchmark::State& state)
+{
+    CBlock block = LoadBenchBlock();
+    size_t nBytes = 0;
+    while (state.KeepRunning()) {
+        JSONStreamWriter writer([&nBytes](const char* data, size_t len) { nBytes += len; });
+        writer.BeginArray();
+        for (const auto& tx : block.vtx)
+            writer.Value(TxToJSON(*tx));
+        writer.EndArray();
+        writer.Flush();
+    }
+    assert(nBytes > 0);
+}
+
+// Time until the first chunk is ready to be sent, to compare with JSONStream_Tree
+static void JSONStream_FirstChunk(benchmark::State& state)
+{
+    CBlock block = LoadBenchBlock();
+    while (state.KeepRunning()) {
+        bool fFirstChunk = false;
+        JSONStreamWriter writer([&fFirstChunk](const char* data, size_t len) { fFirstChunk = true; });
+        writer.BeginArray();
+        for (const auto& tx : block.vtx) {
+            writer.Value(TxToJSON(*tx));
+            if (fFirstChunk)
+                break;
+        }
+    }
+}
+
+BENCHMARK(JSONStream_Tree);
+BENCHMARK(JSONStream_Stream);
+BENCHMARK(JSONStream_FirstChunk);
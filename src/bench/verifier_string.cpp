@@ -0,0 +1,60 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "LibBoolEE.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+// A typical restricted asset verifier string, already stripped of whitespace and '#'
+static const std::string VERIFIER_STRING = "KYC&(US|CA|EU.DE)&!BANNED|ACCREDITED&!BANNED";
+
+static std::vector<std::string> GetVerifierQualifiers()
+{
+    std::set<std::string> setQualifiers;
+    ExtractVerifierStringQualifiers(VERIFIER_STRING, setQualifiers);
+    return std::vector<std::string>(setQualifiers.begin(), setQualifiers.end());
+}
+
+// Checking one address the way it was done for every restricted asset transfer: parse the verifier
+// string again and build a fresh valuation map from the address qualifiers
+static void VerifierString_Resolve(benchmark::State& state)
+{
+    std::vector<std::string> vecQualifiers = GetVerifierQualifiers();
+    uint64_t nFlags = 0;
+    while (state.KeepRunning()) {
+        LibBoolEE::Vals vals;
+        for (size_t i = 0; i < vecQualifiers.size(); i++)
+            vals.insert(std::make_pair(vecQualifiers[i], (nFlags >> i) & 1));
+        LibBoolEE::resolve(VERIFIER_STRING, vals);
+        nFlags++;
+    }
+}
+
+// Checking one address against the cached compiled verifier string with a qualifier bitset
+static void VerifierString_Compiled(benchmark::State& state)
+{
+    std::vector<std::string> vecQualifiers = GetVerifierQualifiers();
+    LibBoolEE::Compiled formula = LibBoolEE::compile(VERIFIER_STRING, vecQualifiers);
+    uint64_t nFlags = 0;
+    while (state.KeepRunning()) {
+        formula.evaluate(nFlags);
+        nFlags++;
+    }
+}
+
+// The one time cost of compiling a verifier string before it is cached
+static void VerifierString_Compile(benchmark::State& state)
+{
+    std::vector<std::string> vecQualifiers = GetVerifierQualifiers();
+    while (state.KeepRunning()) {
+        LibBoolEE::compile(VERIFIER_STRING, vecQualifiers);
+    }
+}
+
+BENCHMARK(VerifierString_Resolve);
+BENCHMARK(VerifierString_Compiled);
+BENCHMARK(VerifierString_Compile);
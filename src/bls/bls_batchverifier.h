@@ -7,7 +7,9 @@
 #define RAVENCASH_CRYPTO_BLS_BATCHVERIFIER_H
 
 #include "bls.h"
+#include "bls_worker.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -115,6 +117,62 @@ public:
         }
     }
 
+    // Verifies the messages in sub-batches on the worker threads. The number of sub-batches grows with the number of
+    // messages, so that every sub-batch has at least minSubBatchSize of them, up to one per thread. Light load is thus
+    // still verified as one aggregated batch. All messages for the same hash go into the same sub-batch, as the hash
+    // only needs to be mapped to the curve and paired once per batch. Sub-batches that fail fall back to per-source
+    // (and per-message) verification on their own, without affecting the others.
+    void VerifyParallel(CBLSWorker& worker, size_t minSubBatchSize)
+    {
+        size_t subBatchCount = std::min(messages.size() / std::max(minSubBatchSize, (size_t)1), worker.GetThreadCount() + 1);
+        if (subBatchCount <= 1) {
+            Verify();
+            return;
+        }
+
+        typedef std::vector<std::pair<SourceId, MessageMapIterator>> MessageGroup;
+        std::map<uint256, MessageGroup> byMessageHash;
+        for (const auto& p : messagesBySource) {
+            for (const auto& msgIt : p.second) {
+                byMessageHash[msgIt->second.msgHash].emplace_back(p.first, msgIt);
+            }
+        }
+
+        // biggest groups first, each into the sub-batch with the fewest messages so far
+        std::vector<const MessageGroup*> groups;
+        groups.reserve(byMessageHash.size());
+        for (const auto& p : byMessageHash) {
+            groups.emplace_back(&p.second);
+        }
+        std::sort(groups.begin(), groups.end(), [](const MessageGroup* a, const MessageGroup* b) {
+            return a->size() > b->size();
+        });
+
+        std::vector<CBLSBatchVerifier> subBatches(subBatchCount, CBLSBatchVerifier(secureVerification, perMessageFallback));
+        std::vector<size_t> subBatchSizes(subBatchCount, 0);
+        for (const auto* group : groups) {
+            size_t i = std::min_element(subBatchSizes.begin(), subBatchSizes.end()) - subBatchSizes.begin();
+            for (const auto& p : *group) {
+                const auto& msg = p.second->second;
+                subBatches[i].PushMessage(p.first, msg.msgId, msg.msgHash, msg.sig, msg.pubKey);
+            }
+            subBatchSizes[i] += group->size();
+        }
+
+        std::vector<std::function<void()>> jobs;
+        for (auto& subBatch : subBatches) {
+            if (!subBatch.messages.empty()) {
+                jobs.emplace_back([&subBatch]() { subBatch.Verify(); });
+            }
+        }
+        worker.RunParallel(jobs);
+
+        for (const auto& subBatch : subBatches) {
+            badSources.insert(subBatch.badSources.begin(), subBatch.badSources.end());
+            badMessages.insert(subBatch.badMessages.begin(), subBatch.badMessages.end());
+        }
+    }
+
 private:
     // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
     // unnecessary copies
@@ -888,6 +888,37 @@ bool CBLSWorker::IsAsyncVerifyInProgress()
     return sigVerifyBatchesInProgress != 0;
 }
 
+size_t CBLSWorker::GetThreadCount()
+{
+    return (size_t)workerPool.size();
+}
+
+void CBLSWorker::RunParallel(const std::vector<std::function<void()>>& jobs)
+{
+    if (jobs.empty()) {
+        return;
+    }
+    if (workerPool.size() == 0) {
+        for (const auto& job : jobs) {
+            job();
+        }
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(jobs.size() - 1);
+    for (size_t i = 1; i < jobs.size(); i++) {
+        futures.emplace_back(workerPool.push([&jobs, i](int threadId) {
+            jobs[i]();
+        }));
+    }
+    // do some of the work instead of only waiting for it
+    jobs[0]();
+    for (auto& f : futures) {
+        f.get();
+    }
+}
+
 // sigVerifyMutex must be held while calling
 void CBLSWorker::PushSigVerifyBatch()
 {
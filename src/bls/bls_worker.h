@@ -140,6 +140,11 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    size_t GetThreadCount();
+    // Runs the jobs on the worker threads and the calling thread, and returns when all of them are done. Without
+    // worker threads (e.g. in unit tests) they all run on the calling thread
+    void RunParallel(const std::vector<std::function<void()>>& jobs);
+
 private:
     void PushSigVerifyBatch();
 };
@@ -224,6 +224,10 @@ public:
     //! (memory only) Maximum nTime in the chain upto and including this block.
     unsigned int nTimeMax;
 
+    //! (memory only) Whether the proof of work of this block was checked when it was accepted, so reading and
+    //! connecting the block doesn't hash it again. The transactions are still checked against the merkle root.
+    bool fPoWChecked;
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -239,6 +243,7 @@ public:
         nStatus = 0;
         nSequenceId = 0;
         nTimeMax = 0;
+        fPoWChecked = false;
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
@@ -381,6 +386,8 @@ arith_uint256 GetBlockProof(const CBlockIndex& block);
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params&);
 /** Find the forking point between two chain tips. */
 const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb);
+/** Return a locator for a block from its ancestors alone, without looking at the active chain. */
+CBlockLocator GetLocator(const CBlockIndex* pindex);
 
 
 /** Used to marshal pointers into hashes for db storage. */
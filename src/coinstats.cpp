@@ -0,0 +1,144 @@
+// Copyright (c) 2010 Satoshi Nakamoto
+// Copyright (c) 2009-2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinstats.h"
+
+#include "assets/assets.h"
+#include "coins.h"
+#include "crypto/muhash.h"
+#include "hash.h"
+#include "serialize.h"
+#include "util.h"
+#include "validation.h"
+#include "version.h"
+
+#include <boost/thread.hpp>
+
+uint64_t GetBogoSize(const CScript& scriptPubKey)
+{
+    return 32 /* txid */ +
+           4 /* vout index */ +
+           4 /* height + coinbase */ +
+           8 /* amount */ +
+           2 /* scriptPubKey len */ +
+           scriptPubKey.size() /* scriptPubKey */;
+}
+
+static void TxOutSer(CDataStream& ss, const COutPoint& outpoint, const Coin& coin)
+{
+    ss << outpoint;
+    ss << static_cast<uint32_t>(coin.nHeight * 2 + coin.fCoinBase);
+    ss << coin.out;
+}
+
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    TxOutSer(ss, outpoint, coin);
+    muhash.Insert((const unsigned char*)ss.data(), ss.size());
+}
+
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    TxOutSer(ss, outpoint, coin);
+    muhash.Remove((const unsigned char*)ss.data(), ss.size());
+}
+
+bool GetScriptAssetAmount(const CScript& scriptPubKey, std::string& assetName, CAmount& nAmount)
+{
+    // Cheap check first, parsing copies the script
+    if (!scriptPubKey.IsAssetScript())
+        return false;
+
+    uint160 hashBytes;
+    return ParseAssetScript(scriptPubKey, hashBytes, assetName, nAmount);
+}
+
+static void ApplyHash(CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    ss << hash;
+    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
+    for (const auto& output : outputs) {
+        ss << VARINT(output.first + 1);
+        ss << output.second.out.scriptPubKey;
+        ss << VARINT(output.second.out.nValue);
+    }
+    ss << VARINT(0);
+}
+
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, CoinStatsHashType hash_type, bool fAssetTotals)
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    MuHash3072 muhash;
+    stats.hashBlock = pcursor->GetBestBlock();
+    {
+        LOCK(cs_main);
+        stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->nHeight;
+    }
+    ss << stats.hashBlock;
+    uint256 prevkey;
+    std::map<uint32_t, Coin> outputs;
+    std::map<std::string, CAmount> mapAssetTotals;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        COutPoint key;
+        Coin coin;
+        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+            if (stats.nTransactionOutputs == 0 || key.hash != prevkey) {
+                // Outputs are only collected for the serialized hash
+                if (!outputs.empty()) {
+                    ApplyHash(ss, prevkey, outputs);
+                    outputs.clear();
+                }
+                stats.nTransactions++;
+            }
+            prevkey = key.hash;
+
+            stats.nTransactionOutputs++;
+            stats.nTotalAmount += coin.out.nValue;
+            stats.nBogoSize += GetBogoSize(coin.out.scriptPubKey);
+
+            std::string assetName;
+            CAmount nAssetAmount;
+            if (GetScriptAssetAmount(coin.out.scriptPubKey, assetName, nAssetAmount)) {
+                stats.nAssetOutputs++;
+                mapAssetTotals[assetName] += nAssetAmount;
+            }
+
+            if (hash_type == CoinStatsHashType::MUHASH) {
+                ApplyCoinHash(muhash, key, coin);
+            } else if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+                outputs[key.n] = std::move(coin);
+            }
+        } else {
+            return error("%s: unable to read value", __func__);
+        }
+        pcursor->Next();
+    }
+    if (!outputs.empty()) {
+        ApplyHash(ss, prevkey, outputs);
+    }
+
+    if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+        stats.hashSerialized = ss.GetHash();
+    } else if (hash_type == CoinStatsHashType::MUHASH) {
+        muhash.Finalize(stats.hashSerialized);
+    }
+
+    for (const auto& asset : mapAssetTotals) {
+        if (asset.second != 0) stats.nAssets++;
+    }
+    if (fAssetTotals) {
+        stats.mapAssetTotals = std::move(mapAssetTotals);
+    }
+
+    stats.nDiskSize = view->EstimateSize();
+    return true;
+}
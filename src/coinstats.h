@@ -0,0 +1,65 @@
+// Copyright (c) 2010 Satoshi Nakamoto
+// Copyright (c) 2009-2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSTATS_H
+#define BITCOIN_COINSTATS_H
+
+#include "amount.h"
+#include "uint256.h"
+
+#include <map>
+#include <string>
+
+class CCoinsView;
+class COutPoint;
+class Coin;
+class CScript;
+class MuHash3072;
+
+enum class CoinStatsHashType {
+    HASH_SERIALIZED,
+    MUHASH,
+    NONE,
+};
+
+struct CCoinsStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint64_t nBogoSize;
+    uint256 hashSerialized;
+    uint64_t nDiskSize;
+    CAmount nTotalAmount;
+
+    //! Unspent outputs holding an asset, and the number of assets held by them
+    uint64_t nAssetOutputs;
+    uint64_t nAssets;
+    //! Amount of each asset held by unspent outputs, only filled in when asset totals are requested
+    std::map<std::string, CAmount> mapAssetTotals;
+
+    //! Whether the statistics were read from the coin stats index, which doesn't count transactions
+    bool fFromIndex;
+
+    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0),
+                    nAssetOutputs(0), nAssets(0), fFromIndex(false) {}
+};
+
+//! Size an unspent output with this script adds to the bogosize statistic
+uint64_t GetBogoSize(const CScript& scriptPubKey);
+
+//! Add an unspent output to, or remove it from, a rolling hash of the UTXO set
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
+
+//! Get the asset name and amount held by an output script. Returns false for outputs without assets.
+bool GetScriptAssetAmount(const CScript& scriptPubKey, std::string& assetName, CAmount& nAmount);
+
+//! Calculate statistics about the unspent transaction output set by scanning all of it
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, CoinStatsHashType hash_type, bool fAssetTotals);
+
+#endif // BITCOIN_COINSTATS_H
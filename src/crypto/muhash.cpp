@@ -0,0 +1,294 @@
+// Copyright (c) 2017-2020 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/muhash.h"
+
+#include "crypto/chacha20.h"
+#include "crypto/sha256.h"
+
+#include <limits>
+#include <string.h>
+
+namespace {
+
+using limb_t = Num3072::limb_t;
+using double_limb_t = Num3072::double_limb_t;
+constexpr int LIMB_SIZE = Num3072::LIMB_SIZE;
+constexpr int LIMBS = Num3072::LIMBS;
+constexpr limb_t LIMB_MAX = std::numeric_limits<limb_t>::max();
+/** 2^3072 - 1103717, the largest 3072-bit safe prime number, is used as the modulus. */
+constexpr limb_t MAX_PRIME_DIFF = 1103717;
+
+/** Reduce a 6144-bit product into a value below 2^3072, using 2^3072 = MAX_PRIME_DIFF (mod p). */
+void Reduce(limb_t (&out)[LIMBS], const limb_t (&tmp)[2 * LIMBS])
+{
+    limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)tmp[LIMBS + i] * MAX_PRIME_DIFF + tmp[i] + carry;
+        out[i] = (limb_t)t;
+        carry = (limb_t)(t >> LIMB_SIZE);
+    }
+    // The carry out of the top limb is again a multiple of 2^3072; fold it in until none is left.
+    while (carry) {
+        double_limb_t t = (double_limb_t)carry * MAX_PRIME_DIFF;
+        for (int i = 0; i < LIMBS && t; ++i) {
+            t += out[i];
+            out[i] = (limb_t)t;
+            t >>= LIMB_SIZE;
+        }
+        carry = (limb_t)t;
+    }
+}
+
+/** The modulus as limbs. */
+struct Modulus
+{
+    limb_t limbs[LIMBS];
+    Modulus()
+    {
+        limbs[0] = LIMB_MAX - MAX_PRIME_DIFF + 1;
+        for (int i = 1; i < LIMBS; ++i) limbs[i] = LIMB_MAX;
+    }
+};
+
+bool IsZero(const limb_t (&x)[LIMBS])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (x[i]) return false;
+    }
+    return true;
+}
+
+bool IsOne(const limb_t (&x)[LIMBS])
+{
+    if (x[0] != 1) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (x[i]) return false;
+    }
+    return true;
+}
+
+/** x >= y */
+bool GreaterOrEqual(const limb_t (&x)[LIMBS], const limb_t (&y)[LIMBS])
+{
+    for (int i = LIMBS - 1; i >= 0; --i) {
+        if (x[i] != y[i]) return x[i] > y[i];
+    }
+    return true;
+}
+
+/** x += y, returning the carry out of the top limb. */
+limb_t Add(limb_t (&x)[LIMBS], const limb_t (&y)[LIMBS])
+{
+    limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)x[i] + y[i] + carry;
+        x[i] = (limb_t)t;
+        carry = (limb_t)(t >> LIMB_SIZE);
+    }
+    return carry;
+}
+
+/** x -= y, returning whether it borrowed past the top limb. */
+bool Sub(limb_t (&x)[LIMBS], const limb_t (&y)[LIMBS])
+{
+    limb_t borrow = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t yi = y[i] + borrow;
+        // yi wrapped around only when y[i] == LIMB_MAX and there was a borrow, which always borrows again.
+        bool next = (yi < borrow) || (x[i] < yi);
+        x[i] -= yi;
+        borrow = next;
+    }
+    return borrow;
+}
+
+/** x = (top_bit * 2^3072 + x) / 2 */
+void ShiftRight(limb_t (&x)[LIMBS], limb_t top_bit)
+{
+    for (int i = 0; i < LIMBS - 1; ++i) {
+        x[i] = (x[i] >> 1) | (x[i + 1] << (LIMB_SIZE - 1));
+    }
+    x[LIMBS - 1] = (x[LIMBS - 1] >> 1) | (top_bit << (LIMB_SIZE - 1));
+}
+
+/** x = x / 2 (mod p), for x < p. */
+void HalveMod(limb_t (&x)[LIMBS], const Modulus& p)
+{
+    if (x[0] & 1) {
+        limb_t carry = Add(x, p.limbs);
+        ShiftRight(x, carry);
+    } else {
+        ShiftRight(x, 0);
+    }
+}
+
+/** x = x - y (mod p), for x, y < p. */
+void SubMod(limb_t (&x)[LIMBS], const limb_t (&y)[LIMBS], const Modulus& p)
+{
+    if (Sub(x, y)) Add(x, p.limbs);
+}
+
+} // namespace
+
+bool Num3072::IsOverflow() const
+{
+    if (this->limbs[0] <= LIMB_MAX - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (this->limbs[i] != LIMB_MAX) return false;
+    }
+    return true;
+}
+
+void Num3072::FullReduce()
+{
+    // Subtracting p is adding MAX_PRIME_DIFF and dropping the 2^3072 carry.
+    limb_t carry = MAX_PRIME_DIFF;
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)this->limbs[i] + carry;
+        this->limbs[i] = (limb_t)t;
+        carry = (limb_t)(t >> LIMB_SIZE);
+    }
+}
+
+Num3072 Num3072::GetInverse() const
+{
+    // Binary extended Euclid on (a, p), keeping x1 * a = u and x2 * a = v (mod p). The
+    // inputs are public set hashes, so this does not need to be constant time.
+    static const Modulus p;
+    Num3072 a = *this;
+    if (a.IsOverflow()) a.FullReduce();
+
+    Num3072 x1, x2;
+    memset(x2.limbs, 0, sizeof(x2.limbs));
+    limb_t u[LIMBS], v[LIMBS];
+    memcpy(u, a.limbs, sizeof(u));
+    memcpy(v, p.limbs, sizeof(v));
+    if (IsZero(u)) return x2;
+
+    while (!IsOne(u) && !IsOne(v)) {
+        while (!(u[0] & 1)) {
+            ShiftRight(u, 0);
+            HalveMod(x1.limbs, p);
+        }
+        while (!(v[0] & 1)) {
+            ShiftRight(v, 0);
+            HalveMod(x2.limbs, p);
+        }
+        if (GreaterOrEqual(u, v)) {
+            Sub(u, v);
+            SubMod(x1.limbs, x2.limbs, p);
+        } else {
+            Sub(v, u);
+            SubMod(x2.limbs, x1.limbs, p);
+        }
+    }
+    return IsOne(u) ? x1 : x2;
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    limb_t tmp[2 * LIMBS] = {0};
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t carry = 0;
+        for (int j = 0; j < LIMBS; ++j) {
+            double_limb_t t = (double_limb_t)this->limbs[i] * a.limbs[j] + tmp[i + j] + carry;
+            tmp[i + j] = (limb_t)t;
+            carry = (limb_t)(t >> LIMB_SIZE);
+        }
+        tmp[i + LIMBS] = carry;
+    }
+    Reduce(this->limbs, tmp);
+}
+
+void Num3072::Square()
+{
+    Multiply(*this);
+}
+
+void Num3072::SetToOne()
+{
+    this->limbs[0] = 1;
+    for (int i = 1; i < LIMBS; ++i) this->limbs[i] = 0;
+}
+
+void Num3072::Divide(const Num3072& a)
+{
+    if (this->IsOverflow()) this->FullReduce();
+
+    Num3072 inv = a.GetInverse();
+    this->Multiply(inv);
+    if (this->IsOverflow()) this->FullReduce();
+}
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        limb_t limb = 0;
+        for (size_t j = 0; j < sizeof(limb_t); ++j) {
+            limb |= (limb_t)data[i * sizeof(limb_t) + j] << (8 * j);
+        }
+        this->limbs[i] = limb;
+    }
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        for (size_t j = 0; j < sizeof(limb_t); ++j) {
+            out[i * sizeof(limb_t) + j] = (unsigned char)(this->limbs[i] >> (8 * j));
+        }
+    }
+}
+
+Num3072 MuHash3072::ToNum3072(const unsigned char* data, size_t len)
+{
+    unsigned char hashed_in[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data, len).Finalize(hashed_in);
+    unsigned char tmp[Num3072::BYTE_SIZE];
+    ChaCha20(hashed_in, sizeof(hashed_in)).Keystream(tmp, Num3072::BYTE_SIZE);
+    return Num3072(tmp);
+}
+
+MuHash3072::MuHash3072(const unsigned char* data, size_t len)
+{
+    m_numerator = ToNum3072(data, len);
+}
+
+void MuHash3072::Finalize(uint256& out)
+{
+    m_numerator.Divide(m_denominator);
+    m_denominator.SetToOne();  // Needed to keep the MuHash object valid
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    m_numerator.ToBytes(data);
+    CSHA256().Write(data, sizeof(data)).Finalize(out.begin());
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul)
+{
+    m_numerator.Multiply(mul.m_numerator);
+    m_denominator.Multiply(mul.m_denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& div)
+{
+    m_numerator.Multiply(div.m_denominator);
+    m_denominator.Multiply(div.m_numerator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::Insert(const unsigned char* data, size_t len)
+{
+    m_numerator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(const unsigned char* data, size_t len)
+{
+    m_denominator.Multiply(ToNum3072(data, len));
+    return *this;
+}
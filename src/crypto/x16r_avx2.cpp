@@ -0,0 +1,362 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// 4-way AVX2 implementations of the 64-bit-word X16R algorithms (blake512,
+// keccak512 and skein512). Each lane hashes an independent message, so the
+// miner can push four nonces through one algorithm step at a time. Only the
+// single-shot message sizes used by X16R are supported: the 80 byte block
+// header in the first round and 64 byte intermediate hashes afterwards.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace x16r_avx2 {
+namespace {
+
+__m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Add(__m256i x, __m256i y, __m256i z) { return Add(Add(x, y), z); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline AndNot(__m256i x, __m256i y) { return _mm256_andnot_si256(x, y); }
+__m256i inline RotL(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)); }
+__m256i inline RotR(__m256i x, int n) { return _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n)); }
+
+/** Gather 64-bit word `word` of each of the four `stride`-byte messages. */
+__m256i inline ReadLE4(const unsigned char* in, size_t stride, int word)
+{
+    return _mm256_set_epi64x(ReadLE64(in + 3 * stride + 8 * word), ReadLE64(in + 2 * stride + 8 * word),
+                             ReadLE64(in + stride + 8 * word), ReadLE64(in + 8 * word));
+}
+
+__m256i inline ReadBE4(const unsigned char* in, size_t stride, int word)
+{
+    return _mm256_set_epi64x(ReadBE64(in + 3 * stride + 8 * word), ReadBE64(in + 2 * stride + 8 * word),
+                             ReadBE64(in + stride + 8 * word), ReadBE64(in + 8 * word));
+}
+
+/** Scatter one 64-bit word per lane into four consecutive 64 byte outputs. */
+void inline WriteLE4(unsigned char* out, int word, __m256i v)
+{
+    alignas(32) uint64_t tmp[4];
+    _mm256_store_si256((__m256i*)tmp, v);
+    for (int i = 0; i < 4; i++) WriteLE64(out + 64 * i + 8 * word, tmp[i]);
+}
+
+void inline WriteBE4(unsigned char* out, int word, __m256i v)
+{
+    alignas(32) uint64_t tmp[4];
+    _mm256_store_si256((__m256i*)tmp, v);
+    for (int i = 0; i < 4; i++) WriteBE64(out + 64 * i + 8 * word, tmp[i]);
+}
+
+/////////////////////////////////////////////////////////////// BLAKE-512
+
+const uint64_t BLAKE_CB[16] = {
+    0x243F6A8885A308D3ull, 0x13198A2E03707344ull, 0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull,
+    0x452821E638D01377ull, 0xBE5466CF34E90C6Cull, 0xC0AC29B7C97C50DDull, 0x3F84D5B5B5470917ull,
+    0x9216D5D98979FB1Bull, 0xD1310BA698DFB5ACull, 0x2FFD72DBD01ADFB7ull, 0xB8E1AFED6A267E96ull,
+    0xBA7C9045F12C7F99ull, 0x24A19947B3916CF7ull, 0x0801F2E2858EFC16ull, 0x636920D871574E69ull,
+};
+
+const uint64_t BLAKE_IV[8] = {
+    0x6A09E667F3BCC908ull, 0xBB67AE8584CAA73Bull, 0x3C6EF372FE94F82Bull, 0xA54FF53A5F1D36F1ull,
+    0x510E527FADE682D1ull, 0x9B05688C2B3E6C1Full, 0x1F83D9ABFB41BD6Bull, 0x5BE0CD19137E2179ull,
+};
+
+const uint8_t BLAKE_SIGMA[10][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0},
+};
+
+void inline __attribute__((always_inline)) BlakeG(__m256i& a, __m256i& b, __m256i& c, __m256i& d, const __m256i* m, int x, int y)
+{
+    a = Add(a, b, Xor(m[x], K(BLAKE_CB[y])));
+    d = RotR(Xor(d, a), 32);
+    c = Add(c, d);
+    b = RotR(Xor(b, c), 25);
+    a = Add(a, b, Xor(m[y], K(BLAKE_CB[x])));
+    d = RotR(Xor(d, a), 16);
+    c = Add(c, d);
+    b = RotR(Xor(b, c), 11);
+}
+
+/** One BLAKE-512 round; R is a template parameter so the message schedule is resolved at compile time. */
+template<int R>
+void inline __attribute__((always_inline)) BlakeRound(__m256i* v, const __m256i* m)
+{
+    const uint8_t* s = BLAKE_SIGMA[R % 10];
+    BlakeG(v[0], v[4], v[8], v[12], m, s[0], s[1]);
+    BlakeG(v[1], v[5], v[9], v[13], m, s[2], s[3]);
+    BlakeG(v[2], v[6], v[10], v[14], m, s[4], s[5]);
+    BlakeG(v[3], v[7], v[11], v[15], m, s[6], s[7]);
+    BlakeG(v[0], v[5], v[10], v[15], m, s[8], s[9]);
+    BlakeG(v[1], v[6], v[11], v[12], m, s[10], s[11]);
+    BlakeG(v[2], v[7], v[8], v[13], m, s[12], s[13]);
+    BlakeG(v[3], v[4], v[9], v[14], m, s[14], s[15]);
+}
+
+/////////////////////////////////////////////////////////////// Keccak-512
+
+const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808Aull, 0x8000000080008000ull,
+    0x000000000000808Bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+    0x000000000000008Aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000Aull,
+    0x000000008000808Bull, 0x800000000000008Bull, 0x8000000000008089ull, 0x8000000000008003ull,
+    0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800Aull, 0x800000008000000Aull,
+    0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull,
+};
+
+void KeccakF1600(__m256i* a)
+{
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        const __m256i c0 = Xor(Xor(a[0], a[5]), Xor(Xor(a[10], a[15]), a[20]));
+        const __m256i c1 = Xor(Xor(a[1], a[6]), Xor(Xor(a[11], a[16]), a[21]));
+        const __m256i c2 = Xor(Xor(a[2], a[7]), Xor(Xor(a[12], a[17]), a[22]));
+        const __m256i c3 = Xor(Xor(a[3], a[8]), Xor(Xor(a[13], a[18]), a[23]));
+        const __m256i c4 = Xor(Xor(a[4], a[9]), Xor(Xor(a[14], a[19]), a[24]));
+        const __m256i d0 = Xor(c4, RotL(c1, 1));
+        const __m256i d1 = Xor(c0, RotL(c2, 1));
+        const __m256i d2 = Xor(c1, RotL(c3, 1));
+        const __m256i d3 = Xor(c2, RotL(c4, 1));
+        const __m256i d4 = Xor(c3, RotL(c0, 1));
+        // Rho and Pi: b[y, 2x + 3y] = rot(a[x, y] ^ d[x])
+        __m256i b[25];
+        b[0] = Xor(a[0], d0);
+        b[16] = RotL(Xor(a[5], d0), 36);
+        b[7] = RotL(Xor(a[10], d0), 3);
+        b[23] = RotL(Xor(a[15], d0), 41);
+        b[14] = RotL(Xor(a[20], d0), 18);
+        b[10] = RotL(Xor(a[1], d1), 1);
+        b[1] = RotL(Xor(a[6], d1), 44);
+        b[17] = RotL(Xor(a[11], d1), 10);
+        b[8] = RotL(Xor(a[16], d1), 45);
+        b[24] = RotL(Xor(a[21], d1), 2);
+        b[20] = RotL(Xor(a[2], d2), 62);
+        b[11] = RotL(Xor(a[7], d2), 6);
+        b[2] = RotL(Xor(a[12], d2), 43);
+        b[18] = RotL(Xor(a[17], d2), 15);
+        b[9] = RotL(Xor(a[22], d2), 61);
+        b[5] = RotL(Xor(a[3], d3), 28);
+        b[21] = RotL(Xor(a[8], d3), 55);
+        b[12] = RotL(Xor(a[13], d3), 25);
+        b[3] = RotL(Xor(a[18], d3), 21);
+        b[19] = RotL(Xor(a[23], d3), 56);
+        b[15] = RotL(Xor(a[4], d4), 27);
+        b[6] = RotL(Xor(a[9], d4), 20);
+        b[22] = RotL(Xor(a[14], d4), 39);
+        b[13] = RotL(Xor(a[19], d4), 8);
+        b[4] = RotL(Xor(a[24], d4), 14);
+        // Chi
+        a[0] = Xor(b[0], AndNot(b[1], b[2]));
+        a[1] = Xor(b[1], AndNot(b[2], b[3]));
+        a[2] = Xor(b[2], AndNot(b[3], b[4]));
+        a[3] = Xor(b[3], AndNot(b[4], b[0]));
+        a[4] = Xor(b[4], AndNot(b[0], b[1]));
+        a[5] = Xor(b[5], AndNot(b[6], b[7]));
+        a[6] = Xor(b[6], AndNot(b[7], b[8]));
+        a[7] = Xor(b[7], AndNot(b[8], b[9]));
+        a[8] = Xor(b[8], AndNot(b[9], b[5]));
+        a[9] = Xor(b[9], AndNot(b[5], b[6]));
+        a[10] = Xor(b[10], AndNot(b[11], b[12]));
+        a[11] = Xor(b[11], AndNot(b[12], b[13]));
+        a[12] = Xor(b[12], AndNot(b[13], b[14]));
+        a[13] = Xor(b[13], AndNot(b[14], b[10]));
+        a[14] = Xor(b[14], AndNot(b[10], b[11]));
+        a[15] = Xor(b[15], AndNot(b[16], b[17]));
+        a[16] = Xor(b[16], AndNot(b[17], b[18]));
+        a[17] = Xor(b[17], AndNot(b[18], b[19]));
+        a[18] = Xor(b[18], AndNot(b[19], b[15]));
+        a[19] = Xor(b[19], AndNot(b[15], b[16]));
+        a[20] = Xor(b[20], AndNot(b[21], b[22]));
+        a[21] = Xor(b[21], AndNot(b[22], b[23]));
+        a[22] = Xor(b[22], AndNot(b[23], b[24]));
+        a[23] = Xor(b[23], AndNot(b[24], b[20]));
+        a[24] = Xor(b[24], AndNot(b[20], b[21]));
+        // Iota
+        a[0] = Xor(a[0], K(KECCAK_RC[round]));
+    }
+}
+
+/////////////////////////////////////////////////////////////// Skein-512
+
+const uint64_t SKEIN_IV[8] = {
+    0x4903ADFF749C51CEull, 0x0D95DE399746DF03ull, 0x8FD1934127C79BCEull, 0x9A255629FF352CB1ull,
+    0x5DB62599DF6CA7B0ull, 0xEABE394CA9D5C3F4ull, 0x991112C71A75B523ull, 0xAE18A40B660FCC33ull,
+};
+
+void inline __attribute__((always_inline)) SkeinMix(__m256i& x0, __m256i& x1, int rc)
+{
+    x0 = Add(x0, x1);
+    x1 = Xor(RotL(x1, rc), x0);
+}
+
+/** Threefish-512 key injection for subkey S. */
+template<int S>
+void inline __attribute__((always_inline)) SkeinInjectKey(__m256i* p, const __m256i* k, const uint64_t* t)
+{
+    p[0] = Add(p[0], k[(S + 0) % 9]);
+    p[1] = Add(p[1], k[(S + 1) % 9]);
+    p[2] = Add(p[2], k[(S + 2) % 9]);
+    p[3] = Add(p[3], k[(S + 3) % 9]);
+    p[4] = Add(p[4], k[(S + 4) % 9]);
+    p[5] = Add(p[5], k[(S + 5) % 9], K(t[S % 3]));
+    p[6] = Add(p[6], k[(S + 6) % 9], K(t[(S + 1) % 3]));
+    p[7] = Add(p[7], k[(S + 7) % 9], K(S));
+}
+
+/** Eight Threefish-512 rounds: subkeys S and S + 1, each followed by four mix/permute rounds. */
+template<int S>
+void inline __attribute__((always_inline)) SkeinRounds8(__m256i* p, const __m256i* k, const uint64_t* t)
+{
+    SkeinInjectKey<S>(p, k, t);
+    SkeinMix(p[0], p[1], 46); SkeinMix(p[2], p[3], 36); SkeinMix(p[4], p[5], 19); SkeinMix(p[6], p[7], 37);
+    SkeinMix(p[2], p[1], 33); SkeinMix(p[4], p[7], 27); SkeinMix(p[6], p[5], 14); SkeinMix(p[0], p[3], 42);
+    SkeinMix(p[4], p[1], 17); SkeinMix(p[6], p[3], 49); SkeinMix(p[0], p[5], 36); SkeinMix(p[2], p[7], 39);
+    SkeinMix(p[6], p[1], 44); SkeinMix(p[0], p[7],  9); SkeinMix(p[2], p[5], 54); SkeinMix(p[4], p[3], 56);
+    SkeinInjectKey<S + 1>(p, k, t);
+    SkeinMix(p[0], p[1], 39); SkeinMix(p[2], p[3], 30); SkeinMix(p[4], p[5], 34); SkeinMix(p[6], p[7], 24);
+    SkeinMix(p[2], p[1], 13); SkeinMix(p[4], p[7], 50); SkeinMix(p[6], p[5], 10); SkeinMix(p[0], p[3], 17);
+    SkeinMix(p[4], p[1], 25); SkeinMix(p[6], p[3], 29); SkeinMix(p[0], p[5], 39); SkeinMix(p[2], p[7], 43);
+    SkeinMix(p[6], p[1],  8); SkeinMix(p[0], p[7], 35); SkeinMix(p[2], p[5], 56); SkeinMix(p[4], p[3], 22);
+}
+
+/** Threefish-512 in the UBI chaining mode used by Skein-512; h is updated in place. */
+void SkeinUBI(__m256i* h, const __m256i* m, uint64_t t0, uint64_t t1)
+{
+    __m256i k[9];
+    k[8] = K(0x1BD11BDAA9FC1A22ull);
+    for (int i = 0; i < 8; i++) {
+        k[i] = h[i];
+        k[8] = Xor(k[8], h[i]);
+    }
+    const uint64_t t[3] = {t0, t1, t0 ^ t1};
+
+    __m256i p[8];
+    for (int i = 0; i < 8; i++) p[i] = m[i];
+
+    SkeinRounds8<0>(p, k, t);
+    SkeinRounds8<2>(p, k, t);
+    SkeinRounds8<4>(p, k, t);
+    SkeinRounds8<6>(p, k, t);
+    SkeinRounds8<8>(p, k, t);
+    SkeinRounds8<10>(p, k, t);
+    SkeinRounds8<12>(p, k, t);
+    SkeinRounds8<14>(p, k, t);
+    SkeinRounds8<16>(p, k, t);
+    SkeinInjectKey<18>(p, k, t);
+
+    for (int i = 0; i < 8; i++) h[i] = Xor(m[i], p[i]);
+}
+
+/** Skein tweak word 1 for a block of the given type, as computed by sph_skein. */
+uint64_t inline SkeinT1(uint64_t etype) { return etype << 55; }
+
+} // namespace
+
+void Blake512_4way(unsigned char* out, const unsigned char* in, size_t len)
+{
+    // A 64 or 80 byte message plus its padding fits in a single 128 byte block.
+    __m256i m[16];
+    unsigned char block[4][128];
+    for (int i = 0; i < 4; i++) {
+        memset(block[i], 0, sizeof(block[i]));
+        memcpy(block[i], in + i * len, len);
+        block[i][len] = 0x80;
+        block[i][111] |= 0x01;
+        WriteBE64(block[i] + 120, (uint64_t)len << 3);
+    }
+    for (int w = 0; w < 16; w++) m[w] = ReadBE4(&block[0][0], 128, w);
+
+    __m256i v[16];
+    for (int i = 0; i < 8; i++) v[i] = K(BLAKE_IV[i]);
+    for (int i = 0; i < 4; i++) v[8 + i] = K(BLAKE_CB[i]);
+    v[12] = K(((uint64_t)len << 3) ^ BLAKE_CB[4]);
+    v[13] = K(((uint64_t)len << 3) ^ BLAKE_CB[5]);
+    v[14] = K(BLAKE_CB[6]);
+    v[15] = K(BLAKE_CB[7]);
+
+    BlakeRound<0>(v, m); BlakeRound<1>(v, m); BlakeRound<2>(v, m); BlakeRound<3>(v, m);
+    BlakeRound<4>(v, m); BlakeRound<5>(v, m); BlakeRound<6>(v, m); BlakeRound<7>(v, m);
+    BlakeRound<8>(v, m); BlakeRound<9>(v, m); BlakeRound<10>(v, m); BlakeRound<11>(v, m);
+    BlakeRound<12>(v, m); BlakeRound<13>(v, m); BlakeRound<14>(v, m); BlakeRound<15>(v, m);
+
+    for (int i = 0; i < 8; i++) {
+        WriteBE4(out, i, Xor(K(BLAKE_IV[i]), Xor(v[i], v[i + 8])));
+    }
+}
+
+void Keccak512_4way(unsigned char* out, const unsigned char* in, size_t len)
+{
+    static const size_t RATE = 72;
+    __m256i a[25];
+    for (int i = 0; i < 25; i++) a[i] = _mm256_setzero_si256();
+
+    size_t pos = 0;
+    while (len - pos >= RATE) {
+        for (size_t w = 0; w < RATE / 8; w++) a[w] = Xor(a[w], ReadLE4(in + pos, len, w));
+        KeccakF1600(a);
+        pos += RATE;
+    }
+
+    unsigned char block[4][RATE];
+    for (int i = 0; i < 4; i++) {
+        memset(block[i], 0, RATE);
+        memcpy(block[i], in + i * len + pos, len - pos);
+        block[i][len - pos] = 0x01;
+        block[i][RATE - 1] |= 0x80;
+    }
+    for (size_t w = 0; w < RATE / 8; w++) a[w] = Xor(a[w], ReadLE4(&block[0][0], RATE, w));
+    KeccakF1600(a);
+
+    for (int i = 0; i < 8; i++) WriteLE4(out, i, a[i]);
+}
+
+void Skein512_4way(unsigned char* out, const unsigned char* in, size_t len)
+{
+    __m256i h[8], m[8];
+    for (int i = 0; i < 8; i++) h[i] = K(SKEIN_IV[i]);
+
+    // Every block but the last is a plain message block; the last one is
+    // zero padded and flagged as final. X16R inputs are at most two blocks.
+    uint64_t processed = 0;
+    uint64_t first = 128;
+    while (len - processed > 64) {
+        for (int w = 0; w < 8; w++) m[w] = ReadLE4(in + processed, len, w);
+        processed += 64;
+        SkeinUBI(h, m, processed, SkeinT1(96 + first));
+        first = 0;
+    }
+
+    unsigned char block[4][64];
+    for (int i = 0; i < 4; i++) {
+        memset(block[i], 0, 64);
+        memcpy(block[i], in + i * len + processed, len - processed);
+    }
+    for (int w = 0; w < 8; w++) m[w] = ReadLE4(&block[0][0], 64, w);
+    SkeinUBI(h, m, len, SkeinT1(352 + first));
+
+    // Output transform: a single all-zero block encoding counter 0.
+    for (int w = 0; w < 8; w++) m[w] = _mm256_setzero_si256();
+    SkeinUBI(h, m, 8, SkeinT1(510));
+
+    for (int i = 0; i < 8; i++) WriteLE4(out, i, h[i]);
+}
+
+} // namespace x16r_avx2
+
+#endif
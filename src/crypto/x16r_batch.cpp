@@ -0,0 +1,130 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/x16r_batch.h"
+#include "crypto/common.h"
+
+#include "crypto/sph_blake.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace x16r_avx2
+{
+void Blake512_4way(unsigned char* out, const unsigned char* in, size_t len);
+void Keccak512_4way(unsigned char* out, const unsigned char* in, size_t len);
+void Skein512_4way(unsigned char* out, const unsigned char* in, size_t len);
+}
+
+namespace
+{
+
+X16RBatchTransform transforms[16] = {};
+
+template<typename Ctx, void (*Init)(void*), void (*Update)(void*, const void*, size_t), void (*Close)(void*, void*)>
+void ScalarReference(unsigned char* out, const unsigned char* in, size_t len)
+{
+    Ctx ctx;
+    for (int i = 0; i < X16R_BATCH_LANES; i++) {
+        Init(&ctx);
+        Update(&ctx, in + i * len, len);
+        Close(&ctx, out + i * 64);
+    }
+}
+
+/** Compare every selected kernel against its sph implementation for both X16R input sizes. */
+bool SelfTest()
+{
+    X16RBatchTransform reference[16] = {};
+    reference[0] = ScalarReference<sph_blake512_context, sph_blake512_init, sph_blake512, sph_blake512_close>;
+    reference[4] = ScalarReference<sph_keccak512_context, sph_keccak512_init, sph_keccak512, sph_keccak512_close>;
+    reference[5] = ScalarReference<sph_skein512_context, sph_skein512_init, sph_skein512, sph_skein512_close>;
+
+    unsigned char in[X16R_BATCH_LANES * 80];
+    for (size_t i = 0; i < sizeof(in); i++) in[i] = (unsigned char)(i * 7 + 1);
+
+    for (int algo = 0; algo < 16; algo++) {
+        if (!transforms[algo]) continue;
+        if (!reference[algo]) return false;
+        for (size_t len : {64, 80}) {
+            unsigned char out[X16R_BATCH_LANES * 64], expected[X16R_BATCH_LANES * 64];
+            transforms[algo](out, in, len);
+            reference[algo](expected, in, len);
+            if (!std::equal(out, out + sizeof(out), expected)) return false;
+        }
+    }
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+// We can't use cpuid.h's __get_cpuid as it does not support subleafs.
+void inline cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+#ifdef __GNUC__
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+#else
+  __asm__ ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(leaf), "2"(subleaf));
+#endif
+}
+
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+
+std::string X16RBatchAutoDetect()
+{
+    std::string ret = "scalar";
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    bool have_avx = false;
+    bool have_avx2 = false;
+    bool enabled_avx = false;
+
+    (void)AVXEnabled;
+    (void)have_avx;
+    (void)have_avx2;
+    (void)enabled_avx;
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    have_avx = (ecx >> 28) & 1;
+    if (((ecx >> 27) & 1) && have_avx) {
+        enabled_avx = AVXEnabled();
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && have_avx && enabled_avx) {
+        transforms[0] = x16r_avx2::Blake512_4way;
+        transforms[4] = x16r_avx2::Keccak512_4way;
+        transforms[5] = x16r_avx2::Skein512_4way;
+        ret = "avx2(4way blake,keccak,skein)";
+    }
+#endif
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
+
+X16RBatchTransform X16RBatchGetTransform(int algo)
+{
+    return transforms[algo];
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_X16R_BATCH_H
+#define BITCOIN_CRYPTO_X16R_BATCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** Number of messages hashed together by the X16R batch kernels. */
+static const int X16R_BATCH_LANES = 4;
+
+/** Hash X16R_BATCH_LANES messages of len bytes each (64 or 80) with a single
+ *  X16R algorithm.
+ *  output:  pointer to a X16R_BATCH_LANES*64 byte output buffer
+ *  input:   pointer to X16R_BATCH_LANES consecutive len byte messages
+ */
+typedef void (*X16RBatchTransform)(unsigned char* output, const unsigned char* input, size_t len);
+
+/** Autodetect the vectorised X16R kernels supported by this CPU.
+ *  Returns a description of the selected implementation.
+ */
+std::string X16RBatchAutoDetect();
+
+/** The batch kernel for X16R algorithm index algo (0-15), or nullptr if that
+ *  algorithm is only available through the scalar sph implementation.
+ */
+X16RBatchTransform X16RBatchGetTransform(int algo);
+
+#endif // BITCOIN_CRYPTO_X16R_BATCH_H
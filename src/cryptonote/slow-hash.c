@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -22,6 +23,22 @@
 
 #if defined(_MSC_VER)
 #include <malloc.h>
+#define THREADV __declspec(thread)
+#else
+#define THREADV __thread
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define CN_USE_MMAP
+#define CN_HUGE_PAGE_SIZE 2097152
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define CN_USE_AESNI
 #endif
 
 #define AES_BLOCK_SIZE  16
@@ -191,7 +208,83 @@ static inline void xor_blocks_dst(const uint8_t* a, const uint8_t* b, uint8_t* d
     ((uint64_t*) dst)[1] = ((uint64_t*) a)[1] ^ ((uint64_t*) b)[1];
 }
 
-void cn_slow_hash(const char* input, char* output, int len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds)
+/*
+ * Per-thread scratchpad arena. cn_slow_hash is called for every header hash, so
+ * the scratchpad (up to CN_PAGE_SIZE bytes) and the software AES context are
+ * allocated once per thread and reused. Where the platform allows it the
+ * scratchpad is backed by huge pages to cut down on TLB misses in the main loop.
+ */
+static THREADV uint8_t *hp_state = NULL;
+static THREADV size_t hp_size = 0;
+static THREADV int hp_mapped = 0;
+static THREADV oaes_ctx *hp_aes_ctx = NULL;
+
+static void free_scratchpad(void)
+{
+  if (hp_state == NULL)
+    return;
+#if defined(CN_USE_MMAP)
+  if (hp_mapped)
+    munmap(hp_state, hp_size);
+  else
+#endif
+    free(hp_state);
+  hp_state = NULL;
+  hp_size = 0;
+  hp_mapped = 0;
+}
+
+void cn_slow_hash_allocate_state(uint32_t page_size)
+{
+  if (hp_state != NULL && hp_size >= page_size)
+    return;
+
+  free_scratchpad();
+
+  /* Size the arena for the largest variant so switching variants never reallocates */
+  size_t size = page_size > CN_PAGE_SIZE ? page_size : CN_PAGE_SIZE;
+
+#if defined(CN_USE_MMAP)
+  size = (size + CN_HUGE_PAGE_SIZE - 1) & ~((size_t)CN_HUGE_PAGE_SIZE - 1);
+#if defined(MAP_HUGETLB)
+  void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+  if (p == MAP_FAILED)
+#else
+  void *p = MAP_FAILED;
+#endif
+  {
+    /* No reserved huge pages, fall back to regular pages and ask for transparent huge pages */
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+    if (p != MAP_FAILED)
+      madvise(p, size, MADV_HUGEPAGE);
+#endif
+  }
+  if (p != MAP_FAILED) {
+    hp_state = (uint8_t *)p;
+    hp_size = size;
+    hp_mapped = 1;
+    return;
+  }
+#endif
+
+  hp_state = (uint8_t *)malloc(size);
+  if (hp_state == NULL) {
+    fprintf(stderr, "Cryptonight failed to allocate a %zu byte scratchpad", size);
+    _exit(1);
+  }
+  hp_size = size;
+  hp_mapped = 0;
+}
+
+void cn_slow_hash_free_state(void)
+{
+  free_scratchpad();
+  if (hp_aes_ctx != NULL)
+    oaes_free((OAES_CTX **) &hp_aes_ctx);
+}
+
+static void cn_slow_hash_soft(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds, uint8_t *long_state, oaes_ctx *aes_ctx)
 {
   union cn_slow_hash_state state;
   uint8_t text[INIT_SIZE_BYTE];
@@ -199,23 +292,12 @@ void cn_slow_hash(const char* input, char* output, int len, int variant, uint32_
   uint8_t b[AES_BLOCK_SIZE * 2];
   uint8_t c[AES_BLOCK_SIZE];
   uint8_t aes_key[AES_KEY_SIZE];
-  oaes_ctx* aes_ctx;
 
   size_t init_rounds = (page_size / INIT_SIZE_BYTE);
 
-#if defined(_MSC_VER)
-  uint8_t *long_state = (uint8_t *)_malloca(page_size);
-#else
-#if defined(__APPLE__)
-  uint8_t *long_state = (uint8_t *)calloc(page_size, sizeof(uint8_t));
-#else
-  uint8_t *long_state = (uint8_t *)malloc(page_size);
-#endif
-#endif
   hash_process(&state.hs, (const uint8_t*) input, len);
   memcpy(text, state.init, INIT_SIZE_BYTE);
   memcpy(aes_key, state.hs.b, AES_KEY_SIZE);
-  aes_ctx = (oaes_ctx*) oaes_alloc();
   size_t i, j;
 
   VARIANT1_INIT();
@@ -290,6 +372,202 @@ void cn_slow_hash(const char* input, char* output, int len, int variant, uint32_
   hash_permutation(&state.hs);
   /*memcpy(hash, &state, 32);*/
   extra_hashes[state.hs.b[0] & 3](&state, 200, output);
+}
+
+#if defined(CN_USE_AESNI)
+#define CN_AESNI_TARGET __attribute__((target("aes,sse2")))
+
+static int cn_check_aesni(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return 0;
+  return (ecx & bit_AES) != 0;
+}
+
+static CN_AESNI_TARGET inline void aes_256_assist1(__m128i* t1, __m128i* t2)
+{
+  __m128i t4;
+  *t2 = _mm_shuffle_epi32(*t2, 0xff);
+  t4 = _mm_slli_si128(*t1, 0x04);
+  *t1 = _mm_xor_si128(*t1, t4);
+  t4 = _mm_slli_si128(t4, 0x04);
+  *t1 = _mm_xor_si128(*t1, t4);
+  t4 = _mm_slli_si128(t4, 0x04);
+  *t1 = _mm_xor_si128(*t1, t4);
+  *t1 = _mm_xor_si128(*t1, *t2);
+}
+
+static CN_AESNI_TARGET inline void aes_256_assist2(__m128i* t1, __m128i* t3)
+{
+  __m128i t2, t4;
+  t4 = _mm_aeskeygenassist_si128(*t1, 0x00);
+  t2 = _mm_shuffle_epi32(t4, 0xaa);
+  t4 = _mm_slli_si128(*t3, 0x04);
+  *t3 = _mm_xor_si128(*t3, t4);
+  t4 = _mm_slli_si128(t4, 0x04);
+  *t3 = _mm_xor_si128(*t3, t4);
+  t4 = _mm_slli_si128(t4, 0x04);
+  *t3 = _mm_xor_si128(*t3, t4);
+  *t3 = _mm_xor_si128(*t3, t2);
+}
+
+/* Expands the first ten round keys of the AES-256 key schedule, which is all aesb_pseudo_round uses */
+static CN_AESNI_TARGET void aes_expand_key(const uint8_t *key, __m128i *ek)
+{
+  __m128i t1, t2, t3;
+
+  t1 = _mm_loadu_si128((const __m128i*) key);
+  t3 = _mm_loadu_si128((const __m128i*) (key + 16));
+
+  ek[0] = t1;
+  ek[1] = t3;
+
+  t2 = _mm_aeskeygenassist_si128(t3, 0x01);
+  aes_256_assist1(&t1, &t2);
+  ek[2] = t1;
+  aes_256_assist2(&t1, &t3);
+  ek[3] = t3;
+
+  t2 = _mm_aeskeygenassist_si128(t3, 0x02);
+  aes_256_assist1(&t1, &t2);
+  ek[4] = t1;
+  aes_256_assist2(&t1, &t3);
+  ek[5] = t3;
+
+  t2 = _mm_aeskeygenassist_si128(t3, 0x04);
+  aes_256_assist1(&t1, &t2);
+  ek[6] = t1;
+  aes_256_assist2(&t1, &t3);
+  ek[7] = t3;
+
+  t2 = _mm_aeskeygenassist_si128(t3, 0x08);
+  aes_256_assist1(&t1, &t2);
+  ek[8] = t1;
+  aes_256_assist2(&t1, &t3);
+  ek[9] = t3;
+}
+
+/* Same as aesb_pseudo_round applied to all INIT_SIZE_BLK blocks of text */
+static CN_AESNI_TARGET inline void aes_pseudo_round_blocks(uint8_t *text, const __m128i *ek)
+{
+  size_t j, r;
+  __m128i d[INIT_SIZE_BLK];
+  for (j = 0; j < INIT_SIZE_BLK; j++)
+    d[j] = _mm_loadu_si128((const __m128i*) &text[j * AES_BLOCK_SIZE]);
+  for (r = 0; r < 10; r++)
+    for (j = 0; j < INIT_SIZE_BLK; j++)
+      d[j] = _mm_aesenc_si128(d[j], ek[r]);
+  for (j = 0; j < INIT_SIZE_BLK; j++)
+    _mm_storeu_si128((__m128i*) &text[j * AES_BLOCK_SIZE], d[j]);
+}
+
+static CN_AESNI_TARGET void cn_slow_hash_aesni(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds, uint8_t *long_state)
+{
+  union cn_slow_hash_state state;
+  uint8_t text[INIT_SIZE_BYTE];
+  uint8_t a[AES_BLOCK_SIZE];
+  uint8_t b[AES_BLOCK_SIZE * 2];
+  uint8_t c[AES_BLOCK_SIZE];
+  __m128i expanded_key[10];
+
+  size_t init_rounds = (page_size / INIT_SIZE_BYTE);
+
+  hash_process(&state.hs, (const uint8_t*) input, len);
+  memcpy(text, state.init, INIT_SIZE_BYTE);
+  size_t i, j;
+
+  VARIANT1_INIT();
+  VARIANT2_INIT(b, state);
+
+  aes_expand_key(state.hs.b, expanded_key);
+  for (i = 0; i < init_rounds; i++) {
+    aes_pseudo_round_blocks(text, expanded_key);
+    memcpy(&long_state[i * INIT_SIZE_BYTE], text, INIT_SIZE_BYTE);
+  }
+
+  for (i = 0; i < 16; i++) {
+    a[i] = state.k[i] ^ state.k[32 + i];
+    b[i] = state.k[16 + i] ^ state.k[48 + i];
+  }
+
+  for (i = 0; i < iterations; i++) {
+    /* Iteration 1 */
+    j = e2i(a, aes_rounds);
+    _mm_storeu_si128((__m128i*) c, _mm_aesenc_si128(_mm_loadu_si128((const __m128i*) &long_state[j * AES_BLOCK_SIZE]),
+                                                     _mm_loadu_si128((const __m128i*) a)));
+    VARIANT2_SHUFFLE_ADD(long_state, j * AES_BLOCK_SIZE, a, b);
+    xor_blocks_dst(c, b, &long_state[j * AES_BLOCK_SIZE]);
+    VARIANT1_1((uint8_t*)&long_state[j * AES_BLOCK_SIZE]);
+    /* Iteration 2 */
+    j = e2i(c, aes_rounds);
+
+    uint64_t* dst = (uint64_t*)&long_state[j * AES_BLOCK_SIZE];
+
+    uint64_t t[2];
+    t[0] = dst[0];
+    t[1] = dst[1];
+
+    VARIANT2_INTEGER_MATH(t, c);
+
+    uint64_t hi;
+    uint64_t lo = mul128(((uint64_t*)c)[0], t[0], &hi);
+
+    VARIANT2_2();
+    VARIANT2_SHUFFLE_ADD(long_state, j * AES_BLOCK_SIZE, a, b);
+
+    ((uint64_t*)a)[0] += hi;
+    ((uint64_t*)a)[1] += lo;
+
+    dst[0] = ((uint64_t*)a)[0];
+    dst[1] = ((uint64_t*)a)[1];
+
+    ((uint64_t*)a)[0] ^= t[0];
+    ((uint64_t*)a)[1] ^= t[1];
+
+    VARIANT1_2((uint8_t*)&long_state[j * AES_BLOCK_SIZE]);
+    copy_block(b + AES_BLOCK_SIZE, b);
+    copy_block(b, c);
+  }
+
+  memcpy(text, state.init, INIT_SIZE_BYTE);
+  aes_expand_key(&state.hs.b[32], expanded_key);
+  for (i = 0; i < init_rounds; i++) {
+    for (j = 0; j < INIT_SIZE_BLK; j++) {
+      xor_blocks(&text[j * AES_BLOCK_SIZE], &long_state[i * INIT_SIZE_BYTE + j * AES_BLOCK_SIZE]);
+    }
+    aes_pseudo_round_blocks(text, expanded_key);
+  }
+  memcpy(state.init, text, INIT_SIZE_BYTE);
+  hash_permutation(&state.hs);
+  extra_hashes[state.hs.b[0] & 3](&state, 200, output);
+}
+#endif
+
+void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds)
+{
+  cn_slow_hash_allocate_state(page_size);
+
+#if defined(CN_USE_AESNI)
+  static int use_aesni = -1;
+  if (use_aesni < 0)
+    use_aesni = cn_check_aesni();
+  if (use_aesni) {
+    cn_slow_hash_aesni(input, output, len, variant, page_size, iterations, aes_rounds, hp_state);
+    return;
+  }
+#endif
+
+  if (hp_aes_ctx == NULL)
+    hp_aes_ctx = (oaes_ctx*) oaes_alloc();
+  cn_slow_hash_soft(input, output, len, variant, page_size, iterations, aes_rounds, hp_state, hp_aes_ctx);
+}
+
+void cn_slow_hash_uncached(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds)
+{
+  uint8_t *long_state = (uint8_t *)malloc(page_size);
+  oaes_ctx *aes_ctx = (oaes_ctx*) oaes_alloc();
+  cn_slow_hash_soft(input, output, len, variant, page_size, iterations, aes_rounds, long_state, aes_ctx);
   oaes_free((OAES_CTX **) &aes_ctx);
   free(long_state);
 }
@@ -48,6 +48,12 @@ extern "C" {
 #pragma pack(pop)
 
   void cn_slow_hash(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds);
+  /** Reference path that allocates the scratchpad and AES context on every call (used by the benchmarks) */
+  void cn_slow_hash_uncached(const char* input, char* output, uint32_t len, int variant, uint32_t page_size, uint32_t iterations, size_t aes_rounds);
+  /** Make sure the calling thread's scratchpad can hold page_size bytes */
+  void cn_slow_hash_allocate_state(uint32_t page_size);
+  /** Release the calling thread's scratchpad and AES context */
+  void cn_slow_hash_free_state(void);
   void cn_fast_hash(const char* input, char* output, uint32_t len);
 
 //-----------------------------------------------------------------------------------
@@ -101,6 +107,12 @@ extern "C" {
   }
 
 } // extern
+
+/** Releases the per-thread cn_slow_hash scratchpad when the owning thread exits */
+struct cn_slow_hash_state_guard {
+  ~cn_slow_hash_state_guard() { cn_slow_hash_free_state(); }
+};
+
 } // namespace
 
 #endif
\ No newline at end of file
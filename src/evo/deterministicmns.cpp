@@ -513,8 +513,10 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
     mnInternalIdMap = mnInternalIdMap.erase(dmn->internalId);
 }
 
-CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
-    evoDb(_evoDb)
+CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb, int _nSnapshotPeriod, size_t nListCacheSize) :
+    evoDb(_evoDb),
+    nSnapshotPeriod(std::max(_nSnapshotPeriod, 1)),
+    mnListsLRU(std::max(nListCacheSize, (size_t)1))
 {
 }
 
@@ -548,18 +550,7 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
 
         newList.SetBlockHash(block.GetHash());
         oldList = GetListForBlock(pindex->pprev);
-        diff = oldList.BuildDiff(newList);
-
-        evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
-        if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || oldList.GetHeight() == -1) {
-            evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            mnListsCache.emplace(newList.GetBlockHash(), newList);
-            LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
-                __func__, nHeight, newList.GetAllMNsCount());
-        }
-
-        diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+        diff = WriteList(pindex, oldList, newList);
     } catch (const std::exception& e) {
         LogPrintf("CDeterministicMNManager::%s -- internal error: %s\n", __func__, e.what());
         return _state.DoS(100, false, REJECT_INVALID, "failed-dmn-block");
@@ -606,6 +597,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
 
         mnListsCache.erase(blockHash);
         mnListDiffsCache.erase(blockHash);
+        mnListsLRU.erase(blockHash);
     }
 
     if (diff.HasChanges()) {
@@ -912,56 +904,99 @@ void CDeterministicMNManager::DecreasePoSePenalties(CDeterministicMNList& mnList
     }
 }
 
-CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex* pindex)
+CDeterministicMNListDiff CDeterministicMNManager::WriteList(const CBlockIndex* pindex, const CDeterministicMNList& oldList, const CDeterministicMNList& newList)
 {
-    LOCK(cs);
+    AssertLockHeld(cs);
+
+    CDeterministicMNListDiff diff = oldList.BuildDiff(newList);
+
+    evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
+    if ((pindex->nHeight % nSnapshotPeriod) == 0 || oldList.GetHeight() == -1) {
+        evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
+        mnListsCache.emplace(newList.GetBlockHash(), newList);
+        LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
+            __func__, pindex->nHeight, newList.GetAllMNsCount());
+    }
+
+    diff.nHeight = pindex->nHeight;
+    mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+    return diff;
+}
 
+CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex* pindex)
+{
     CDeterministicMNList snapshot;
-    std::list<const CBlockIndex*> listDiffIndexes;
-
-    while (true) {
-        // try using cache before reading from disk
-        auto itLists = mnListsCache.find(pindex->GetBlockHash());
-        if (itLists != mnListsCache.end()) {
-            snapshot = itLists->second;
-            break;
-        }
+    // diffs to apply on top of snapshot, newest first
+    std::vector<std::pair<const CBlockIndex*, CDeterministicMNListDiff>> vDiffs;
 
-        if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
-            break;
-        }
+    {
+        LOCK(cs);
 
-        // no snapshot found yet, check diffs
-        auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
-        if (itDiffs != mnListDiffsCache.end()) {
-            listDiffIndexes.emplace_front(pindex);
-            pindex = pindex->pprev;
-            continue;
-        }
+        while (true) {
+            // try using cache before reading from disk
+            auto itLists = mnListsCache.find(pindex->GetBlockHash());
+            if (itLists != mnListsCache.end()) {
+                snapshot = itLists->second;
+                break;
+            }
 
-        CDeterministicMNListDiff diff;
-        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
-            // no snapshot and no diff on disk means that it's the initial snapshot
-            snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
-            break;
-        }
+            if (mnListsLRU.get(pindex->GetBlockHash(), snapshot)) {
+                break;
+            }
+
+            if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
+                mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+                break;
+            }
+
+            // no snapshot found yet, check diffs
+            auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
+            if (itDiffs != mnListDiffsCache.end()) {
+                vDiffs.emplace_back(pindex, itDiffs->second);
+                pindex = pindex->pprev;
+                continue;
+            }
+
+            CDeterministicMNListDiff diff;
+            if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
+                // no snapshot and no diff on disk means that it's the initial snapshot
+                snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
+                mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+                break;
+            }
 
-        diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), std::move(diff));
-        listDiffIndexes.emplace_front(pindex);
-        pindex = pindex->pprev;
+            diff.nHeight = pindex->nHeight;
+            mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+            vDiffs.emplace_back(pindex, std::move(diff));
+            pindex = pindex->pprev;
+        }
     }
 
-    for (const auto& diffIndex : listDiffIndexes) {
-        const auto& diff = mnListDiffsCache.at(diffIndex->GetBlockHash());
+    // Lists only share immutable state, so the diffs are applied without holding cs. Replaying up to
+    // nSnapshotPeriod diffs would otherwise block every other caller, e.g. all the quorum code.
+    std::vector<CDeterministicMNList> vIntermediate;
+    for (auto it = vDiffs.rbegin(); it != vDiffs.rend(); ++it) {
+        const CBlockIndex* diffIndex = it->first;
+        const auto& diff = it->second;
         if (diff.HasChanges()) {
             snapshot = snapshot.ApplyDiff(diffIndex, diff);
         } else {
             snapshot.SetBlockHash(diffIndex->GetBlockHash());
             snapshot.SetHeight(diffIndex->nHeight);
         }
+        if (std::next(it) != vDiffs.rend() && diffIndex->nHeight % LIST_CACHE_INTERVAL == 0) {
+            vIntermediate.emplace_back(snapshot);
+        }
+    }
+
+    LOCK(cs);
+
+    // later queries near this block only need to replay the diffs from the closest intermediate list
+    for (auto& list : vIntermediate) {
+        mnListsLRU.insert(list.GetBlockHash(), list);
+    }
+    if (!vDiffs.empty()) {
+        mnListsLRU.insert(snapshot.GetBlockHash(), snapshot);
     }
 
     if (tipIndex) {
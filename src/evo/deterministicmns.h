@@ -14,6 +14,7 @@
 #include "simplifiedmns.h"
 #include <saltedhasher.h>
 #include "sync.h"
+#include "unordered_lru_cache.h"
 
 #include "immer/map.hpp"
 #include "immer/map_transient.hpp"
@@ -638,24 +639,34 @@ public:
     }
 };
 
+/** Default for -dmnsnapshotperiod, the number of blocks between two lists written to disk in full */
+static const int DEFAULT_DMN_SNAPSHOT_PERIOD = 576; // once per day
+/** Default for -dmnlistcache, the number of lists of older blocks kept in memory */
+static const int DEFAULT_DMN_LIST_CACHE = 256;
+
 class CDeterministicMNManager
 {
-    static const int  DISK_SNAPSHOT_PERIOD = 576; // once per day
+    static const int  DISK_SNAPSHOT_PERIOD = DEFAULT_DMN_SNAPSHOT_PERIOD;
     static const int DISK_SNAPSHOTS = 3;// keep cache for 3 disk snapshots to have 2 full days covered
     static const int LIST_DIFFS_CACHE_SIZE = DISK_SNAPSHOT_PERIOD * DISK_SNAPSHOTS;
+    // when a list is rebuilt from many diffs, keep the intermediate lists at multiples of this height
+    static const int LIST_CACHE_INTERVAL = 32;
 
 public:
     CCriticalSection cs;
 
 private:
     CEvoDB& evoDb;
+    const int nSnapshotPeriod;
 
     std::unordered_map<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache;
     std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache;
+    // lists rebuilt for older blocks (RPCs, historic quorums), least recently used ones are evicted first
+    unordered_lru_cache<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsLRU;
     const CBlockIndex* tipIndex{nullptr};
 
 public:
-    CDeterministicMNManager(CEvoDB& _evoDb);
+    CDeterministicMNManager(CEvoDB& _evoDb, int _nSnapshotPeriod = DEFAULT_DMN_SNAPSHOT_PERIOD, size_t nListCacheSize = DEFAULT_DMN_LIST_CACHE);
 
     bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fJustCheck);
     bool UndoBlock(const CBlock& block, const CBlockIndex* pindex);
@@ -667,6 +678,9 @@ public:
     void HandleQuorumCommitment(llmq::CFinalCommitment& qc, const CBlockIndex* pindexQuorum, CDeterministicMNList& mnList, bool debugLogs);
     void DecreasePoSePenalties(CDeterministicMNList& mnList);
 
+    // Writes the diff from oldList to newList, the list of pindex, and every nSnapshotPeriod blocks the full list
+    CDeterministicMNListDiff WriteList(const CBlockIndex* pindex, const CDeterministicMNList& oldList, const CDeterministicMNList& newList);
+
     CDeterministicMNList GetListForBlock(const CBlockIndex* pindex);
     CDeterministicMNList GetListAtChainTip();
 
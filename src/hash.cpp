@@ -4,6 +4,7 @@
 
 #include <primitives/block.h>
 #include "hash.h"
+#include "kawpow_context.h"
 #include "crypto/common.h"
 #include "crypto/hmac_sha512.h"
 #include "pubkey.h"
@@ -11,6 +12,8 @@
 
 #include <crypto/ethash/include/ethash/progpow.hpp>
 
+#include <chrono>
+
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
     return (x << r) | (x >> (32 - r));
@@ -251,15 +254,48 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
 }
 
 
-uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash)
+std::atomic<int64_t> algoHashTotal[16];
+std::atomic<uint64_t> algoHashHits[16];
+
+void HashX16RContext::HashBatch(const unsigned char* input, size_t len, uint256* output) const
 {
-    static ethash::epoch_context_ptr context{nullptr, nullptr};
+    HashContexts ctx;
+    // Round i writes its X16R_BATCH_LANES 64 byte results to hash[i & 1] and reads the other buffer.
+    unsigned char hash[2][X16R_BATCH_LANES * 64];
+
+    for (int i = 0; i < 16; i++) {
+        const int algo = algoOrder[i];
+        const unsigned char* in = (i == 0 ? input : hash[(i - 1) & 1]);
+        const size_t inLen = (i == 0 ? len : 64);
+        unsigned char* out = hash[i & 1];
+
+        const auto start = std::chrono::steady_clock::now();
+        X16RBatchTransform transform = X16RBatchGetTransform(algo);
+        if (transform) {
+            transform(out, in, inLen);
+        } else {
+            for (int j = 0; j < X16R_BATCH_LANES; j++) {
+                HashAlgo(algo, ctx, in + j * inLen, inLen, out + j * 64);
+            }
+        }
+        // A single step often takes less than a microsecond, keep full resolution here
+        algoHashTotal[algo] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        algoHashHits[algo] += X16R_BATCH_LANES;
+    }
 
-    // Get the context from the block height
-    const auto epoch_number = ethash::get_epoch_number(blockHeader.nHeight);
+    for (int j = 0; j < X16R_BATCH_LANES; j++) {
+        memcpy(output[j].begin(), hash[1] + j * 64, 32);
+    }
+}
 
+uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash)
+{
+    // Get the context from the block height. Contexts are shared between threads by the context
+    // manager, each thread keeps a reference to the last one it used to avoid taking the lock.
+    static thread_local CKAWPOWContextManager::ContextPtr context;
+    const auto epoch_number = ethash::get_epoch_number(blockHeader.nHeight);
     if (!context || context->epoch_number != epoch_number)
-        context = ethash::create_epoch_context(epoch_number);
+        context = GetKAWPOWContextManager().Get(epoch_number);
 
     // Build the header_hash
     uint256 nHeaderHash = blockHeader.GetKAWPOWHeaderHash();
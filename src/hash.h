@@ -10,6 +10,7 @@
 
 #include "crypto/ripemd160.h"
 #include "crypto/sha256.h"
+#include "crypto/x16r_batch.h"
 #include "prevector.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -18,6 +19,7 @@
 
 #include <crypto/ethash/helpers.hpp>
 
+#include <atomic>
 #include <vector>
 
 class CBlockHeader;
@@ -315,137 +317,180 @@ inline int GetHashSelection(const uint256 PrevBlockHash, int index) {
     return(hashSelection);
 }
 
-extern double algoHashTotal[16];
-extern int algoHashHits[16];
+/** Nanoseconds spent in each X16R algorithm by HashX16RContext::HashBatch. */
+extern std::atomic<int64_t> algoHashTotal[16];
+/** Number of messages hashed by each X16R algorithm in HashX16RContext::HashBatch. */
+extern std::atomic<uint64_t> algoHashHits[16];
 
-template<typename T1>
-inline uint256 HashX16R(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash)
+/**
+ * X16R hasher for headers sharing the same parent. The algorithm order only depends on
+ * hashPrevBlock, so it is computed once here and Hash() only runs the sixteen hash functions.
+ * Callers hashing many nonces on the same parent (the miner) should keep one of these around.
+ */
+class HashX16RContext
 {
-//      static std::chrono::duration<double>[16];
-    int hashSelection;
-
-    sph_blake512_context     ctx_blake;      //0
-    sph_bmw512_context       ctx_bmw;        //1
-    sph_groestl512_context   ctx_groestl;    //2
-    sph_jh512_context        ctx_jh;         //3
-    sph_keccak512_context    ctx_keccak;     //4
-    sph_skein512_context     ctx_skein;      //5
-    sph_luffa512_context     ctx_luffa;      //6
-    sph_cubehash512_context  ctx_cubehash;   //7
-    sph_shavite512_context   ctx_shavite;    //8
-    sph_simd512_context      ctx_simd;       //9
-    sph_echo512_context      ctx_echo;       //A
-    sph_hamsi512_context     ctx_hamsi;      //B
-    sph_fugue512_context     ctx_fugue;      //C
-    sph_shabal512_context    ctx_shabal;     //D
-    sph_whirlpool_context    ctx_whirlpool;  //E
-    sph_sha512_context       ctx_sha512;     //F
-
-
-
-    static unsigned char pblank[1];
-
-    uint512 hash[16];
-
-    for (int i=0;i<16;i++)
+private:
+    uint256 prevBlockHash;
+    int algoOrder[16];
+
+    // Only one of the sixteen algorithms is in use at a time
+    union HashContexts {
+        sph_blake512_context     blake;      //0
+        sph_bmw512_context       bmw;        //1
+        sph_groestl512_context   groestl;    //2
+        sph_jh512_context        jh;         //3
+        sph_keccak512_context    keccak;     //4
+        sph_skein512_context     skein;      //5
+        sph_luffa512_context     luffa;      //6
+        sph_cubehash512_context  cubehash;   //7
+        sph_shavite512_context   shavite;    //8
+        sph_simd512_context      simd;       //9
+        sph_echo512_context      echo;       //A
+        sph_hamsi512_context     hamsi;      //B
+        sph_fugue512_context     fugue;      //C
+        sph_shabal512_context    shabal;     //D
+        sph_whirlpool_context    whirlpool;  //E
+        sph_sha512_context       sha512;     //F
+    };
+
+    /** Run X16R algorithm algo (0-15) over one message. */
+    static void HashAlgo(int algo, HashContexts& ctx, const void* toHash, size_t lenToHash, void* out)
     {
-        const void *toHash;
-        int lenToHash;
-        if (i == 0) {
-            toHash = (pbegin == pend ? pblank : static_cast<const void*>(&pbegin[0]));
-            lenToHash = (pend - pbegin) * sizeof(pbegin[0]);
-        } else {
-            toHash = static_cast<const void*>(&hash[i-1]);
-            lenToHash = 64;
-        }
-
-        hashSelection = GetHashSelection(PrevBlockHash, i);
-
-        switch(hashSelection) {
+        switch(algo) {
             case 0:
-                sph_blake512_init(&ctx_blake);
-                sph_blake512 (&ctx_blake, toHash, lenToHash);
-                sph_blake512_close(&ctx_blake, static_cast<void*>(&hash[i]));
+                sph_blake512_init(&ctx.blake);
+                sph_blake512 (&ctx.blake, toHash, lenToHash);
+                sph_blake512_close(&ctx.blake, out);
                 break;
             case 1:
-                sph_bmw512_init(&ctx_bmw);
-                sph_bmw512 (&ctx_bmw, toHash, lenToHash);
-                sph_bmw512_close(&ctx_bmw, static_cast<void*>(&hash[i]));
+                sph_bmw512_init(&ctx.bmw);
+                sph_bmw512 (&ctx.bmw, toHash, lenToHash);
+                sph_bmw512_close(&ctx.bmw, out);
                 break;
             case 2:
-                sph_groestl512_init(&ctx_groestl);
-                sph_groestl512 (&ctx_groestl, toHash, lenToHash);
-                sph_groestl512_close(&ctx_groestl, static_cast<void*>(&hash[i]));
+                sph_groestl512_init(&ctx.groestl);
+                sph_groestl512 (&ctx.groestl, toHash, lenToHash);
+                sph_groestl512_close(&ctx.groestl, out);
                 break;
             case 3:
-                sph_jh512_init(&ctx_jh);
-                sph_jh512 (&ctx_jh, toHash, lenToHash);
-                sph_jh512_close(&ctx_jh, static_cast<void*>(&hash[i]));
+                sph_jh512_init(&ctx.jh);
+                sph_jh512 (&ctx.jh, toHash, lenToHash);
+                sph_jh512_close(&ctx.jh, out);
                 break;
             case 4:
-                sph_keccak512_init(&ctx_keccak);
-                sph_keccak512 (&ctx_keccak, toHash, lenToHash);
-                sph_keccak512_close(&ctx_keccak, static_cast<void*>(&hash[i]));
+                sph_keccak512_init(&ctx.keccak);
+                sph_keccak512 (&ctx.keccak, toHash, lenToHash);
+                sph_keccak512_close(&ctx.keccak, out);
                 break;
             case 5:
-                sph_skein512_init(&ctx_skein);
-                sph_skein512 (&ctx_skein, toHash, lenToHash);
-                sph_skein512_close(&ctx_skein, static_cast<void*>(&hash[i]));
+                sph_skein512_init(&ctx.skein);
+                sph_skein512 (&ctx.skein, toHash, lenToHash);
+                sph_skein512_close(&ctx.skein, out);
                 break;
             case 6:
-                sph_luffa512_init(&ctx_luffa);
-                sph_luffa512 (&ctx_luffa, toHash, lenToHash);
-                sph_luffa512_close(&ctx_luffa, static_cast<void*>(&hash[i]));
+                sph_luffa512_init(&ctx.luffa);
+                sph_luffa512 (&ctx.luffa, toHash, lenToHash);
+                sph_luffa512_close(&ctx.luffa, out);
                 break;
             case 7:
-                sph_cubehash512_init(&ctx_cubehash);
-                sph_cubehash512 (&ctx_cubehash, toHash, lenToHash);
-                sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&hash[i]));
+                sph_cubehash512_init(&ctx.cubehash);
+                sph_cubehash512 (&ctx.cubehash, toHash, lenToHash);
+                sph_cubehash512_close(&ctx.cubehash, out);
                 break;
             case 8:
-                sph_shavite512_init(&ctx_shavite);
-                sph_shavite512(&ctx_shavite, toHash, lenToHash);
-                sph_shavite512_close(&ctx_shavite, static_cast<void*>(&hash[i]));
+                sph_shavite512_init(&ctx.shavite);
+                sph_shavite512(&ctx.shavite, toHash, lenToHash);
+                sph_shavite512_close(&ctx.shavite, out);
                 break;
             case 9:
-                sph_simd512_init(&ctx_simd);
-                sph_simd512 (&ctx_simd, toHash, lenToHash);
-                sph_simd512_close(&ctx_simd, static_cast<void*>(&hash[i]));
+                sph_simd512_init(&ctx.simd);
+                sph_simd512 (&ctx.simd, toHash, lenToHash);
+                sph_simd512_close(&ctx.simd, out);
                 break;
             case 10:
-                sph_echo512_init(&ctx_echo);
-                sph_echo512 (&ctx_echo, toHash, lenToHash);
-                sph_echo512_close(&ctx_echo, static_cast<void*>(&hash[i]));
+                sph_echo512_init(&ctx.echo);
+                sph_echo512 (&ctx.echo, toHash, lenToHash);
+                sph_echo512_close(&ctx.echo, out);
                 break;
             case 11:
-                sph_hamsi512_init(&ctx_hamsi);
-                sph_hamsi512 (&ctx_hamsi, toHash, lenToHash);
-                sph_hamsi512_close(&ctx_hamsi, static_cast<void*>(&hash[i]));
+                sph_hamsi512_init(&ctx.hamsi);
+                sph_hamsi512 (&ctx.hamsi, toHash, lenToHash);
+                sph_hamsi512_close(&ctx.hamsi, out);
                 break;
             case 12:
-                sph_fugue512_init(&ctx_fugue);
-                sph_fugue512 (&ctx_fugue, toHash, lenToHash);
-                sph_fugue512_close(&ctx_fugue, static_cast<void*>(&hash[i]));
+                sph_fugue512_init(&ctx.fugue);
+                sph_fugue512 (&ctx.fugue, toHash, lenToHash);
+                sph_fugue512_close(&ctx.fugue, out);
                 break;
             case 13:
-                sph_shabal512_init(&ctx_shabal);
-                sph_shabal512 (&ctx_shabal, toHash, lenToHash);
-                sph_shabal512_close(&ctx_shabal, static_cast<void*>(&hash[i]));
+                sph_shabal512_init(&ctx.shabal);
+                sph_shabal512 (&ctx.shabal, toHash, lenToHash);
+                sph_shabal512_close(&ctx.shabal, out);
                 break;
             case 14:
-                sph_whirlpool_init(&ctx_whirlpool);
-                sph_whirlpool(&ctx_whirlpool, toHash, lenToHash);
-                sph_whirlpool_close(&ctx_whirlpool, static_cast<void*>(&hash[i]));
+                sph_whirlpool_init(&ctx.whirlpool);
+                sph_whirlpool(&ctx.whirlpool, toHash, lenToHash);
+                sph_whirlpool_close(&ctx.whirlpool, out);
                 break;
             case 15:
-                sph_sha512_init(&ctx_sha512);
-                sph_sha512 (&ctx_sha512, toHash, lenToHash);
-                sph_sha512_close(&ctx_sha512, static_cast<void*>(&hash[i]));
+                sph_sha512_init(&ctx.sha512);
+                sph_sha512 (&ctx.sha512, toHash, lenToHash);
+                sph_sha512_close(&ctx.sha512, out);
                 break;
         }
     }
 
-    return hash[15].trim256();
+public:
+    explicit HashX16RContext(const uint256& prevBlockHashIn) : prevBlockHash(prevBlockHashIn)
+    {
+        for (int i = 0; i < 16; i++) {
+            algoOrder[i] = GetHashSelection(prevBlockHash, i);
+        }
+    }
+
+    const uint256& GetPrevBlockHash() const { return prevBlockHash; }
+    int GetAlgo(int index) const { return algoOrder[index]; }
+
+    template<typename T1>
+    uint256 Hash(const T1 pbegin, const T1 pend) const
+    {
+        static unsigned char pblank[1];
+
+        HashContexts ctx;
+        uint512 hash[16];
+
+        for (int i=0;i<16;i++)
+        {
+            const void *toHash;
+            int lenToHash;
+            if (i == 0) {
+                toHash = (pbegin == pend ? pblank : static_cast<const void*>(&pbegin[0]));
+                lenToHash = (pend - pbegin) * sizeof(pbegin[0]);
+            } else {
+                toHash = static_cast<const void*>(&hash[i-1]);
+                lenToHash = 64;
+            }
+
+            HashAlgo(algoOrder[i], ctx, toHash, lenToHash, static_cast<void*>(&hash[i]));
+        }
+
+        return hash[15].trim256();
+    }
+
+    /**
+     * Hash X16R_BATCH_LANES messages of len bytes each, laid out back to back in input
+     * (consecutive nonces of one header for the miner), into output[0..X16R_BATCH_LANES-1].
+     * Algorithms with a vectorised kernel (see X16RBatchAutoDetect) process all lanes at
+     * once, the others run the sph implementation lane by lane. Time spent in each
+     * algorithm is added to algoHashTotal/algoHashHits.
+     */
+    void HashBatch(const unsigned char* input, size_t len, uint256* output) const;
+};
+
+template<typename T1>
+inline uint256 HashX16R(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash)
+{
+    return HashX16RContext(PrevBlockHash).Hash(pbegin, pend);
 }
 
 uint256 KAWPOWHash(const CBlockHeader& blockHeader, uint256& mix_hash);
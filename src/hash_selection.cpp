@@ -194,6 +194,9 @@ void coreHash(const void *toHash, uint512* hash, int lenToHash, int hashSelectio
 }
 
 void cnHash(uint512* toHash, uint512* hash, int lenToHash, int hashSelection) {
+	// cn_slow_hash keeps a scratchpad per thread, release it when the thread exits
+	static thread_local crypto::cn_slow_hash_state_guard cnStateGuard;
+	(void)cnStateGuard;
 	switch(hashSelection)
 	{
 	 case 0:
@@ -7,6 +7,7 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "httpserver.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "rpc/server.h"
 #include "random.h"
@@ -185,10 +186,47 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
-            UniValue result = tableRPC.execute(jreq);
+            // Let the command stream its result. Nothing is sent until the first chunk is full,
+            // so errors thrown before that still get a normal error reply.
+            JSONStreamWriter writer([req](const char* data, size_t len) {
+                if (!req->ChunkedReplyStarted()) {
+                    req->WriteHeader("Content-Type", "application/json");
+                }
+                req->WriteReplyChunk(data, len);
+            });
+            writer.BeginObject();
+            writer.Key("result");
+            jreq.pStreamWriter = &writer;
+
+            UniValue result;
+            try {
+                result = tableRPC.execute(jreq);
+            } catch (...) {
+                if (!req->ChunkedReplyStarted()) {
+                    throw;
+                }
+                // Part of the reply is already out, drop the connection so the client can tell
+                // the transfer failed instead of seeing a truncated body
+                LogPrintf("%s: error while streaming the reply to %s\n", __func__, jreq.strMethod);
+                req->AbortChunkedReply();
+                return false;
+            }
+
+            if (!writer.ExpectsValue()) {
+                // The command streamed its result, finish the reply object
+                writer.KeyValue("error", NullUniValue);
+                writer.KeyValue("id", jreq.id);
+                writer.EndObject();
+                writer.WriteRaw("\n");
+                writer.Flush();
+                req->EndChunkedReply();
+                RPCStatsAddBytesReturned(jreq.strMethod, writer.GetBytesFlushed());
+                return true;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            RPCStatsAddBytesReturned(jreq.strMethod, strReply.size());
 
         // array of requests
         } else if (valRequest.isArray())
@@ -208,6 +246,78 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     return true;
 }
 
+/** Serve the RPC statistics of getrpcstats in the Prometheus text format */
+static bool HTTPReq_Metrics(HTTPRequest* req, const std::string &)
+{
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "Metrics are only served for GET requests");
+        return false;
+    }
+    std::pair<bool, std::string> authHeader = req->GetHeader("authorization");
+    std::string strUser;
+    if (!authHeader.first || !RPCAuthorized(authHeader.second, strUser)) {
+        if (authHeader.first) {
+            LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", req->GetPeer().ToString());
+            MilliSleep(250);
+        }
+        req->WriteHeader("WWW-Authenticate", WWW_AUTH_HEADER_DATA);
+        req->WriteReply(HTTP_UNAUTHORIZED);
+        return false;
+    }
+
+    const std::vector<CRPCMethodStats> vStats = GetRPCStats();
+    std::string strMetrics;
+    auto metric = [&](const std::string& strName, const std::string& strType, const std::string& strHelp,
+                      const std::function<std::string(const CRPCMethodStats&)>& value) {
+        strMetrics += strprintf("# HELP %s %s\n# TYPE %s %s\n", strName, strHelp, strName, strType);
+        for (const CRPCMethodStats& stats : vStats)
+            strMetrics += strprintf("%s{method=\"%s\"} %s\n", strName, stats.strMethod, value(stats));
+    };
+    auto seconds = [](int64_t nMicros) { return strprintf("%.6f", nMicros / 1e6); };
+    metric("ravencash_rpc_calls_total", "counter", "RPC calls", [](const CRPCMethodStats& s) { return strprintf("%u", s.nCalls); });
+    metric("ravencash_rpc_errors_total", "counter", "RPC calls that failed", [](const CRPCMethodStats& s) { return strprintf("%u", s.nErrors); });
+    metric("ravencash_rpc_duration_seconds_total", "counter", "Time spent in RPC calls", [&](const CRPCMethodStats& s) { return seconds(s.nTotalMicros); });
+    metric("ravencash_rpc_duration_p50_seconds", "gauge", "Median duration of the latest RPC calls", [&](const CRPCMethodStats& s) { return seconds(s.nP50Micros); });
+    metric("ravencash_rpc_duration_p99_seconds", "gauge", "99th percentile duration of the latest RPC calls", [&](const CRPCMethodStats& s) { return seconds(s.nP99Micros); });
+    metric("ravencash_rpc_duration_max_seconds", "gauge", "Longest RPC call", [&](const CRPCMethodStats& s) { return seconds(s.nMaxMicros); });
+    metric("ravencash_rpc_reply_bytes_total", "counter", "Size of RPC replies", [](const CRPCMethodStats& s) { return strprintf("%u", s.nBytesReturned); });
+    metric("ravencash_rpc_cs_main_seconds_total", "counter", "Time RPC calls held the main lock", [&](const CRPCMethodStats& s) { return seconds(s.nLockMicros); });
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, strMetrics);
+    return true;
+}
+
+/** Size of the start of a request body that is searched for the method */
+static const size_t MAX_WORK_CLASS_PEEK_SIZE = 1024;
+
+/** Find the method of a JSON-RPC request to queue it in the right lane, without parsing the
+ * whole body on the event loop thread. Clients normally send the method before the params.
+ */
+static std::string JSONRPCWorkClass(HTTPRequest* req, const std::string&)
+{
+    const std::string strBody = req->PeekBody(MAX_WORK_CLASS_PEEK_SIZE);
+    const char* strSpace = " \t\r\n";
+    std::string::size_type pos = strBody.find_first_not_of(strSpace);
+    if (pos != std::string::npos && strBody[pos] == '[')
+        return "batch";
+
+    pos = strBody.find("\"method\"");
+    if (pos != std::string::npos)
+        pos = strBody.find_first_not_of(strSpace, pos + 8);
+    if (pos != std::string::npos && strBody[pos] == ':')
+        pos = strBody.find_first_not_of(strSpace, pos + 1);
+    if (pos == std::string::npos || strBody[pos] != '"')
+        return "unknown";
+    std::string::size_type end = strBody.find('"', pos + 1);
+    if (end == std::string::npos)
+        return "unknown";
+
+    // Only known methods get a class of their own, so that clients can't grow the statistics
+    std::string strMethod = strBody.substr(pos + 1, end - pos - 1);
+    return tableRPC[strMethod] ? strMethod : "unknown";
+}
+
 static bool InitRPCAuthentication()
 {
     if (gArgs.GetArg("-rpcpassword", "") == "")
@@ -232,10 +342,12 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, JSONRPCWorkClass);
+    if (gArgs.GetBoolArg("-rpcmetrics", DEFAULT_RPC_METRICS))
+        RegisterHTTPHandler("/metrics", true, HTTPReq_Metrics);
 #ifdef ENABLE_WALLET
     // ifdef can be removed once we switch to better endpoint support and API versioning
-    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC, JSONRPCWorkClass);
 #endif
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
@@ -252,6 +364,7 @@ void StopHTTPRPC()
 {
     LogPrint(BCLog::RPC, "Stopping HTTP RPC server\n");
     UnregisterHTTPHandler("/", true);
+    UnregisterHTTPHandler("/metrics", true);
     if (httpRPCTimerInterface) {
         RPCUnsetTimerInterface(httpRPCTimerInterface);
         delete httpRPCTimerInterface;
@@ -8,6 +8,9 @@
 #include <string>
 #include <map>
 
+/** Default for -rpcmetrics */
+static const bool DEFAULT_RPC_METRICS = false;
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -37,13 +37,28 @@
 #endif
 #endif
 
+#include <chrono>
 #include <thread>
+#include <map>
 #include <mutex>
 #include <condition_variable>
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** Maximum number of bytes of a chunked reply that may wait to be written to the client */
+static const size_t MAX_CHUNKED_REPLY_BACKLOG = 4 * 1024 * 1024;
+
+/** Work classes that go to the high priority lane by default: mining and relay */
+static const char* const DEFAULT_HTTP_HIGH_PRIORITY_CLASSES[] = {
+    "getbestblockhash", "getblockcount", "getblocktemplate", "submitblock", "sendrawtransaction",
+};
+/** Work classes that go to the low priority lane by default: scans over indexes and the chain */
+static const char* const DEFAULT_HTTP_LOW_PRIORITY_CLASSES[] = {
+    "listaddressesbyasset", "rescanblockchain", "getaddresstxids", "getaddressdeltas", "getaddressutxos",
+    "getaddressmempool", "gettxoutsetinfo", "verifychain", "/rest/assetholders/", "/rest/addressutxos/",
+};
+
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
 {
@@ -64,20 +79,89 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over multiple threads.
+ * Work items are simply callable objects. Every item is queued under a work class, whose
+ * priority picks the lane it waits in. Idle workers take the oldest runnable item of the
+ * highest lane; lanes and classes can be limited in how many workers they occupy, so slow
+ * requests can't hold up all workers.
  */
 template <typename WorkItem>
 class WorkQueue
 {
+public:
+    struct ClassConfig
+    {
+        HTTPWorkPriority priority;
+        //! 0 if only the lane limit applies
+        size_t nMaxRunning;
+
+        ClassConfig() : priority(HTTP_PRIORITY_NORMAL), nMaxRunning(0) {}
+    };
+
 private:
+    struct Entry
+    {
+        std::unique_ptr<WorkItem> item;
+        std::string strClass;
+        int64_t nTimeQueued;
+    };
+
+    struct Lane
+    {
+        std::deque<Entry> queue;
+        size_t nRunning;
+        size_t nMaxRunning;
+
+        Lane() : nRunning(0), nMaxRunning(1) {}
+    };
+
+    struct ClassState
+    {
+        size_t nQueued;
+        size_t nRunning;
+        uint64_t nProcessed;
+        uint64_t nRejected;
+        HTTPTimeHistogram queueWait;
+        HTTPTimeHistogram execTime;
+
+        ClassState() : nQueued(0), nRunning(0), nProcessed(0), nRejected(0) {}
+    };
+
     /** Mutex protects entire object */
     std::mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
+    Lane lanes[HTTP_PRIORITY_LANES];
+    std::map<std::string, ClassConfig> mapClassConfig;
+    std::map<std::string, ClassState> mapClassState;
     bool running;
     size_t maxDepth;
 
+    ClassConfig GetClassConfig(const std::string& strClass) const
+    {
+        auto it = mapClassConfig.find(strClass);
+        return it != mapClassConfig.end() ? it->second : ClassConfig();
+    }
+
+    /** Take the next item that may run now out of the queue */
+    bool Pop(Entry& entry, HTTPWorkPriority& priority)
+    {
+        for (int i = 0; i < HTTP_PRIORITY_LANES; i++) {
+            Lane& lane = lanes[i];
+            if (lane.nRunning >= lane.nMaxRunning)
+                continue;
+            for (auto it = lane.queue.begin(); it != lane.queue.end(); ++it) {
+                size_t nMaxRunning = GetClassConfig(it->strClass).nMaxRunning;
+                if (nMaxRunning && mapClassState[it->strClass].nRunning >= nMaxRunning)
+                    continue;
+                entry = std::move(*it);
+                lane.queue.erase(it);
+                priority = (HTTPWorkPriority)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
 public:
     WorkQueue(size_t _maxDepth) : running(true),
                                  maxDepth(_maxDepth)
@@ -88,14 +172,34 @@ public:
     ~WorkQueue()
     {
     }
+    /** Set the priority and worker limit of a work class. Call before the workers start. */
+    void SetClassConfig(const std::string& strClass, const ClassConfig& config)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        mapClassConfig[strClass] = config;
+    }
+    /** Limit the number of workers running items of a lane at the same time. Call before the workers start. */
+    void SetLaneMaxRunning(HTTPWorkPriority priority, size_t nMaxRunning)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        lanes[priority].nMaxRunning = std::max(nMaxRunning, (size_t)1);
+    }
     /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    bool Enqueue(WorkItem* item, const std::string& strClass)
     {
         std::unique_lock<std::mutex> lock(cs);
-        if (queue.size() >= maxDepth) {
+        Lane& lane = lanes[GetClassConfig(strClass).priority];
+        ClassState& state = mapClassState[strClass];
+        if (lane.queue.size() >= maxDepth) {
+            state.nRejected++;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        Entry entry;
+        entry.item.reset(item);
+        entry.strClass = strClass;
+        entry.nTimeQueued = GetTimeMicros();
+        lane.queue.push_back(std::move(entry));
+        state.nQueued++;
         cond.notify_one();
         return true;
     }
@@ -103,17 +207,35 @@ public:
     void Run()
     {
         while (true) {
-            std::unique_ptr<WorkItem> i;
+            Entry entry;
+            HTTPWorkPriority priority;
+            int64_t nTimeStart;
             {
                 std::unique_lock<std::mutex> lock(cs);
-                while (running && queue.empty())
+                while (running && !Pop(entry, priority))
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                nTimeStart = GetTimeMicros();
+                ClassState& state = mapClassState[entry.strClass];
+                state.nQueued--;
+                state.nRunning++;
+                state.queueWait.Add(nTimeStart - entry.nTimeQueued);
+                lanes[priority].nRunning++;
+            }
+            (*entry.item)();
+            // Destroy the item (and so finish its request) before counting it as done
+            entry.item.reset();
+            {
+                std::unique_lock<std::mutex> lock(cs);
+                ClassState& state = mapClassState[entry.strClass];
+                state.nRunning--;
+                state.nProcessed++;
+                state.execTime.Add(GetTimeMicros() - nTimeStart);
+                lanes[priority].nRunning--;
+                // Items held back by a lane or class limit may be able to run now
+                cond.notify_all();
             }
-            (*i)();
         }
     }
     /** Interrupt and exit loops */
@@ -123,18 +245,48 @@ public:
         running = false;
         cond.notify_all();
     }
+    void GetInfo(std::vector<HTTPWorkLaneInfo>& vLanes, std::vector<HTTPWorkClassInfo>& vClasses)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        vLanes.clear();
+        for (int i = 0; i < HTTP_PRIORITY_LANES; i++) {
+            HTTPWorkLaneInfo info;
+            info.priority = (HTTPWorkPriority)i;
+            info.nQueued = lanes[i].queue.size();
+            info.nRunning = lanes[i].nRunning;
+            info.nMaxRunning = lanes[i].nMaxRunning;
+            info.nMaxDepth = maxDepth;
+            vLanes.push_back(info);
+        }
+        vClasses.clear();
+        for (const auto& pair : mapClassState) {
+            const ClassConfig config = GetClassConfig(pair.first);
+            HTTPWorkClassInfo info;
+            info.strClass = pair.first;
+            info.priority = config.priority;
+            info.nQueued = pair.second.nQueued;
+            info.nRunning = pair.second.nRunning;
+            info.nMaxRunning = config.nMaxRunning;
+            info.nProcessed = pair.second.nProcessed;
+            info.nRejected = pair.second.nRejected;
+            info.queueWait = pair.second.queueWait;
+            info.execTime = pair.second.execTime;
+            vClasses.push_back(info);
+        }
+    }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPWorkClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPWorkClassifier classifier;
 };
 
 /** HTTP module state */
@@ -261,12 +413,13 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        std::string strClass = i->classifier ? i->classifier(hreq.get(), path) : i->prefix;
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        if (workQueue->Enqueue(item.get(), strClass))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: %s request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n", strClass);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -351,6 +504,105 @@ static void libevent_log_cb(int severity, const char *msg)
     //    LogPrint(BCLog::LIBEVENT, "libevent: %s\n", msg);
 }
 
+std::string HTTPWorkPriorityName(HTTPWorkPriority priority)
+{
+    switch (priority) {
+    case HTTP_PRIORITY_HIGH:
+        return "high";
+    case HTTP_PRIORITY_NORMAL:
+        return "normal";
+    case HTTP_PRIORITY_LOW:
+        return "low";
+    }
+    return "unknown";
+}
+
+HTTPTimeHistogram::HTTPTimeHistogram() : nCount(0), nTotalMicros(0), nMaxMicros(0)
+{
+    std::fill(vBuckets, vBuckets + BUCKETS, 0);
+}
+
+void HTTPTimeHistogram::Add(int64_t nMicros)
+{
+    nMicros = std::max(nMicros, (int64_t)0);
+    int nBucket = 0;
+    while (nBucket < BUCKETS - 1 && (nMicros >> nBucket) != 0)
+        nBucket++;
+    vBuckets[nBucket]++;
+    nCount++;
+    nTotalMicros += nMicros;
+    nMaxMicros = std::max(nMaxMicros, nMicros);
+}
+
+/** Split a "<class>:<value>" option at its last ':' */
+static bool SplitWorkClassOption(const std::string& strOption, std::string& strClass, std::string& strValue)
+{
+    const std::string::size_type pos = strOption.rfind(':');
+    if (pos == std::string::npos || pos == 0)
+        return false;
+    strClass = strOption.substr(0, pos);
+    strValue = strOption.substr(pos + 1);
+    return true;
+}
+
+/** Set up the work class priorities and limits from the defaults, -rpcpriority and -rpcmethodthreads */
+static bool InitHTTPWorkClasses(WorkQueue<HTTPClosure>* queue)
+{
+    std::map<std::string, WorkQueue<HTTPClosure>::ClassConfig> mapConfig;
+    for (const char* strClass : DEFAULT_HTTP_HIGH_PRIORITY_CLASSES)
+        mapConfig[strClass].priority = HTTP_PRIORITY_HIGH;
+    for (const char* strClass : DEFAULT_HTTP_LOW_PRIORITY_CLASSES)
+        mapConfig[strClass].priority = HTTP_PRIORITY_LOW;
+
+    for (const std::string& strOption : gArgs.GetArgs("-rpcpriority")) {
+        std::string strClass, strPriority;
+        bool fValid = SplitWorkClassOption(strOption, strClass, strPriority);
+        if (fValid && strPriority == "high")
+            mapConfig[strClass].priority = HTTP_PRIORITY_HIGH;
+        else if (fValid && strPriority == "normal")
+            mapConfig[strClass].priority = HTTP_PRIORITY_NORMAL;
+        else if (fValid && strPriority == "low")
+            mapConfig[strClass].priority = HTTP_PRIORITY_LOW;
+        else {
+            uiInterface.ThreadSafeMessageBox(
+                strprintf("Invalid -rpcpriority specification: %s. Use <method>:<high|normal|low>.", strOption),
+                "", CClientUIInterface::MSG_ERROR);
+            return false;
+        }
+    }
+
+    for (const std::string& strOption : gArgs.GetArgs("-rpcmethodthreads")) {
+        std::string strClass, strThreads;
+        int32_t nThreads;
+        if (!SplitWorkClassOption(strOption, strClass, strThreads) || !ParseInt32(strThreads, &nThreads) || nThreads < 0) {
+            uiInterface.ThreadSafeMessageBox(
+                strprintf("Invalid -rpcmethodthreads specification: %s. Use <method>:<n>.", strOption),
+                "", CClientUIInterface::MSG_ERROR);
+            return false;
+        }
+        mapConfig[strClass].nMaxRunning = nThreads;
+    }
+
+    for (const auto& pair : mapConfig) {
+        queue->SetClassConfig(pair.first, pair.second);
+    }
+
+    // Keep one worker free of low priority requests, if there is more than one
+    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    queue->SetLaneMaxRunning(HTTP_PRIORITY_HIGH, rpcThreads);
+    queue->SetLaneMaxRunning(HTTP_PRIORITY_NORMAL, rpcThreads);
+    queue->SetLaneMaxRunning(HTTP_PRIORITY_LOW, std::max(rpcThreads - 1, 1));
+    return true;
+}
+
+void GetHTTPWorkQueueInfo(std::vector<HTTPWorkLaneInfo>& lanes, std::vector<HTTPWorkClassInfo>& classes)
+{
+    lanes.clear();
+    classes.clear();
+    if (workQueue)
+        workQueue->GetInfo(lanes, classes);
+}
+
 bool InitHTTPServer()
 {
     if (!InitHTTPAllowList())
@@ -403,6 +655,11 @@ bool InitHTTPServer()
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
     workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    if (!InitHTTPWorkClasses(workQueue)) {
+        delete workQueue;
+        workQueue = nullptr;
+        return false;
+    }
     // tranfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -514,13 +771,87 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+
+/** Bytes of a chunked reply that were handed to the http thread but not yet written to the socket.
+ * The worker producing the reply waits on this, the http thread drains it as the client reads.
+ */
+struct HTTPReplyBacklog
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    size_t nBytes{0};
+    //! Set when the connection is gone, nothing will be drained anymore
+    bool fClosed{false};
+    //! Drain callback on the output buffer of the connection. Only used on the http thread.
+    struct evbuffer_cb_entry* drainCallback{nullptr};
+
+    void Drained(size_t n)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        nBytes -= std::min(nBytes, n);
+        cond.notify_all();
+    }
+
+    void Close()
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        fClosed = true;
+        cond.notify_all();
+    }
+};
+
+static void http_reply_drained_cb(struct evbuffer* buf, const struct evbuffer_cb_info* info, void* arg)
+{
+    if (info->n_deleted > 0) {
+        static_cast<HTTPReplyBacklog*>(arg)->Drained(info->n_deleted);
+    }
+}
+
+static void http_reply_closed_cb(struct evhttp_connection* conn, void* arg)
+{
+    static_cast<HTTPReplyBacklog*>(arg)->Close();
+}
+
+/** Start tracking how much of a chunked reply is still unsent. Runs on the http thread. */
+static void AttachReplyBacklog(struct evhttp_request* req, HTTPReplyBacklog* backlog)
+{
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    bufferevent* bev = conn ? evhttp_connection_get_bufferevent(conn) : nullptr;
+    if (!bev) {
+        backlog->Close();
+        return;
+    }
+    backlog->drainCallback = evbuffer_add_cb(bufferevent_get_output(bev), http_reply_drained_cb, backlog);
+    evhttp_connection_set_closecb(conn, http_reply_closed_cb, backlog);
+}
+
+/** Stop tracking a chunked reply before the request is finished. Runs on the http thread.
+ * If the connection is gone, libevent already dropped the callbacks along with it.
+ */
+static void DetachReplyBacklog(struct evhttp_request* req, HTTPReplyBacklog* backlog)
+{
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    bufferevent* bev = conn ? evhttp_connection_get_bufferevent(conn) : nullptr;
+    if (bev && backlog->drainCallback) {
+        evbuffer_remove_cb_entry(bufferevent_get_output(bev), backlog->drainCallback);
+        evhttp_connection_set_closecb(conn, nullptr, nullptr);
+    }
+    backlog->drainCallback = nullptr;
+    backlog->Close();
+}
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       chunkedReply(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && chunkedReply) {
+        // A chunked reply was abandoned half way, cut it off so the request doesn't leak
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        AbortChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -559,6 +890,19 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t maxSize)
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    std::string rv(std::min(evbuffer_get_length(buf), maxSize), '\0');
+    if (rv.empty())
+        return rv;
+    ev_ssize_t copied = evbuffer_copyout(buf, &rv[0], rv.size());
+    rv.resize(copied > 0 ? copied : 0);
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -601,6 +945,92 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+void HTTPRequest::WriteReplyChunk(const char* data, size_t len)
+{
+    assert(!replySent && req);
+    auto req_copy = req;
+    if (!chunkedReply) {
+        if (ShutdownRequested()) {
+            WriteHeader("Connection", "close");
+        }
+        backlog = std::make_shared<HTTPReplyBacklog>();
+        auto backlog_copy = backlog;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, backlog_copy]{
+            evhttp_send_reply_start(req_copy, HTTP_OK, nullptr);
+            AttachReplyBacklog(req_copy, backlog_copy.get());
+        });
+        ev->trigger(0);
+        chunkedReply = true;
+    }
+
+    {
+        // Don't run ahead of the client, wait for it to read what is queued already
+        std::unique_lock<std::mutex> lock(backlog->cs);
+        while (backlog->nBytes > MAX_CHUNKED_REPLY_BACKLOG && !backlog->fClosed && !ShutdownRequested()) {
+            backlog->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (backlog->fClosed) {
+            return; // nobody is listening anymore
+        }
+        backlog->nBytes += len;
+    }
+
+    // Events are handled in the order they were triggered, so the chunks go out in order
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, data, len);
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, evb]{
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(0);
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && req && chunkedReply);
+    auto req_copy = req;
+    auto backlog_copy = backlog;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, backlog_copy]{
+        DetachReplyBacklog(req_copy, backlog_copy.get());
+        evhttp_send_reply_end(req_copy);
+        // Re-enable reading from the socket, see WriteReply
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
+void HTTPRequest::AbortChunkedReply()
+{
+    assert(!replySent && req && chunkedReply);
+    auto req_copy = req;
+    auto backlog_copy = backlog;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, backlog_copy]{
+        DetachReplyBacklog(req_copy, backlog_copy.get());
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            // Dropping the connection frees the request with it
+            evhttp_connection_free(conn);
+        } else {
+            // The client is gone already and libevent left the request to us
+            evhttp_request_free(req_copy);
+        }
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -641,10 +1071,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPWorkClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -8,6 +8,8 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -17,6 +19,7 @@ struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPReplyBacklog;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -38,14 +41,72 @@ bool UpdateHTTPServerLogging(bool enable);
 
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Returns the work class of a request, e.g. its RPC method. It is called on the event
+ * loop thread before the request is queued, so it must be cheap.
+ */
+typedef std::function<std::string(HTTPRequest* req, const std::string &)> HTTPWorkClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
  * be invoked.
+ * Requests are queued under the work class returned by classifier, or under the
+ * prefix if there is no classifier.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPWorkClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Priority lanes of the work queue. Idle workers take requests from the highest lane first. */
+enum HTTPWorkPriority {
+    HTTP_PRIORITY_HIGH,
+    HTTP_PRIORITY_NORMAL,
+    HTTP_PRIORITY_LOW,
+};
+static const int HTTP_PRIORITY_LANES = 3;
+
+std::string HTTPWorkPriorityName(HTTPWorkPriority priority);
+
+/** Distribution of durations over power of two buckets of microseconds */
+struct HTTPTimeHistogram
+{
+    //! Bucket i counts durations below 2^i us, the last one everything from about 67s up
+    static const int BUCKETS = 28;
+
+    uint64_t nCount;
+    int64_t nTotalMicros;
+    int64_t nMaxMicros;
+    uint64_t vBuckets[BUCKETS];
+
+    HTTPTimeHistogram();
+    void Add(int64_t nMicros);
+};
+
+struct HTTPWorkLaneInfo
+{
+    HTTPWorkPriority priority;
+    size_t nQueued;
+    size_t nRunning;
+    //! Workers that may run requests of this lane at the same time
+    size_t nMaxRunning;
+    size_t nMaxDepth;
+};
+
+struct HTTPWorkClassInfo
+{
+    std::string strClass;
+    HTTPWorkPriority priority;
+    size_t nQueued;
+    size_t nRunning;
+    //! Workers that may run requests of this class at the same time, 0 if only the lane limits it
+    size_t nMaxRunning;
+    uint64_t nProcessed;
+    uint64_t nRejected;
+    HTTPTimeHistogram queueWait;
+    HTTPTimeHistogram execTime;
+};
+
+/** Get the state of the work queue lanes and the statistics of every work class seen so far */
+void GetHTTPWorkQueueInfo(std::vector<HTTPWorkLaneInfo>& lanes, std::vector<HTTPWorkClassInfo>& classes);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -59,6 +120,9 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool chunkedReply;
+    //! Flow control of a chunked reply, shared with the http thread that sends it
+    std::shared_ptr<HTTPReplyBacklog> backlog;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -98,6 +162,11 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Return up to maxSize bytes from the start of the request body without consuming it.
+     */
+    std::string PeekBody(size_t maxSize);
+
     /**
      * Write output header.
      *
@@ -114,6 +183,35 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Send part of the body of a chunked HTTP 200 reply. The first call starts the reply, so
+     * write the headers before it. Use this instead of WriteReply for large bodies that are
+     * produced incrementally.
+     *
+     * @note This blocks while too much of the reply is still waiting to be written to the
+     * client, so a slow reader holds back the producer instead of filling up memory. Once the
+     * client has gone away, further chunks are dropped.
+     */
+    void WriteReplyChunk(const char* data, size_t len);
+
+    /** Returns true once WriteReplyChunk has started a chunked reply */
+    bool ChunkedReplyStarted() const { return chunkedReply; }
+
+    /**
+     * Finish a chunked reply.
+     *
+     * @note Like WriteReply, this gives the request back to the main thread.
+     */
+    void EndChunkedReply();
+
+    /**
+     * Cut a chunked reply short by closing the connection without sending the final chunk,
+     * so the client sees a failed transfer instead of a truncated body.
+     *
+     * @note Like WriteReply, this gives the request back to the main thread.
+     */
+    void AbortChunkedReply();
 };
 
 /** Event handler closure.
@@ -0,0 +1,493 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/addressindex.h"
+
+#include "assets/assets.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "hash.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+#include <map>
+
+#include <boost/thread.hpp>
+
+static const char DB_ADDRESSINDEX = 'a';
+static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSBALANCEINDEX = 'z';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+bool GetIndexedAddress(const CScript& script, int& type, uint160& hashBytes, std::string& assetName, CAmount& assetAmount)
+{
+    assetName.clear();
+    assetAmount = 0;
+
+    if (script.IsPayToScriptHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+2, script.begin()+22));
+        type = 2;
+    } else if (script.IsPayToPublicKeyHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+3, script.begin()+23));
+        type = 1;
+    } else if (script.IsPayToPublicKey()) {
+        hashBytes = Hash160(script.begin()+1, script.end()-1);
+        type = 1;
+    } else if (ParseAssetScript(script, hashBytes, assetName, assetAmount)) {
+        // Asset outputs can't be in a block before assets are deployed, so they are parsed at any height
+        type = 1;
+    } else {
+        hashBytes.SetNull();
+        type = 0;
+        return false;
+    }
+    return true;
+}
+
+/** Access to the address index database (indexes/addressindex/) */
+class AddressIndex::DB : public BaseIndex::DB
+{
+private:
+    //! Add the balance changes of address index entries being written or erased to the batch
+    void UpdateAddressBalances(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, bool fErase);
+
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    //! Write the entries of a connected block and update the unspent outputs and balances they touch
+    bool WriteEntries(const std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                      const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex);
+    //! Erase the entries of a disconnected block and update the unspent outputs and balances they touch
+    bool EraseEntries(const std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                      const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+void AddressIndex::DB::UpdateAddressBalances(CDBBatch& batch, const std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, bool fErase) {
+    std::map<CAddressBalanceKey, CAddressBalanceValue> mapDeltas;
+    for (const auto& entry : vect) {
+        CAmount nValue = entry.second;
+        if (fErase) {
+            // Only take back what was applied when the entry was written
+            if (!Read(std::make_pair(DB_ADDRESSINDEX, entry.first), nValue))
+                continue;
+        } else if (Exists(std::make_pair(DB_ADDRESSINDEX, entry.first))) {
+            // The entry was already counted, e.g. when blocks after the last committed best block are indexed again
+            continue;
+        }
+
+        CAddressBalanceValue& delta = mapDeltas[CAddressBalanceKey(entry.first.type, entry.first.hashBytes, entry.first.asset)];
+        int nSign = fErase ? -1 : 1;
+        delta.balance += nSign * nValue;
+        if (nValue > 0)
+            delta.received += nSign * nValue;
+    }
+
+    for (const auto& delta : mapDeltas) {
+        CAddressBalanceValue value;
+        Read(std::make_pair(DB_ADDRESSBALANCEINDEX, delta.first), value);
+        value.balance += delta.second.balance;
+        value.received += delta.second.received;
+
+        if (value.balance == 0 && value.received == 0)
+            batch.Erase(std::make_pair(DB_ADDRESSBALANCEINDEX, delta.first));
+        else
+            batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, delta.first), value);
+    }
+}
+
+static void UpdateAddressUnspentIndex(CDBBatch& batch, const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect) {
+    for (const auto& entry : vect) {
+        if (entry.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first), entry.second);
+        }
+    }
+}
+
+bool AddressIndex::DB::WriteEntries(const std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                    const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex) {
+    CDBBatch batch(*this);
+    UpdateAddressBalances(batch, addressIndex, false);
+    for (const auto& entry : addressIndex)
+        batch.Write(std::make_pair(DB_ADDRESSINDEX, entry.first), entry.second);
+    UpdateAddressUnspentIndex(batch, addressUnspentIndex);
+    return WriteBatch(batch);
+}
+
+bool AddressIndex::DB::EraseEntries(const std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                    const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex) {
+    CDBBatch batch(*this);
+    UpdateAddressBalances(batch, addressIndex, true);
+    for (const auto& entry : addressIndex)
+        batch.Erase(std::make_pair(DB_ADDRESSINDEX, entry.first));
+    UpdateAddressUnspentIndex(batch, addressUnspentIndex);
+    return WriteBatch(batch);
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(new AddressIndex::DB(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::Init()
+{
+    LOCK(cs_main);
+
+    // Older versions only kept balances once they had backfilled them. Without them the moved entries would be
+    // incomplete, so they are erased and the index is rebuilt instead.
+    bool fBalances = false;
+    pblocktree->ReadFlag("addressbalanceindex", fBalances);
+    if (!MigrateLegacyData(*pblocktree, fBalances ? m_db.get() : nullptr, "addressindex",
+                           {DB_ADDRESSINDEX, DB_ADDRESSUNSPENTINDEX, DB_ADDRESSBALANCEINDEX}, chainActive.GetLocator())) {
+        return false;
+    }
+    if (fBalances && !pblocktree->WriteFlag("addressbalanceindex", false)) {
+        return error("%s: cannot write block index db flag", __func__);
+    }
+
+    return BaseIndex::Init();
+}
+
+bool AddressIndex::EraseLegacyData()
+{
+    LOCK(cs_main);
+    return MigrateLegacyData(*pblocktree, nullptr, "addressindex",
+                             {DB_ADDRESSINDEX, DB_ADDRESSUNSPENTINDEX, DB_ADDRESSBALANCEINDEX}, chainActive.GetLocator());
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+/** Add the spending activity of a transaction's inputs. Disconnecting restores the unspent outputs they spent. */
+static void AddInputEntries(const CTransaction& tx, const CTxUndo& txundo, int nHeight, unsigned int nTx, bool fDisconnect,
+                            std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex)
+{
+    const uint256& txhash = tx.GetHash();
+    for (unsigned int j = 0; j < tx.vin.size(); j++) {
+        const COutPoint& prevout = tx.vin[j].prevout;
+        const Coin& coin = txundo.vprevout[j];
+        int type;
+        uint160 hashBytes;
+        std::string assetName;
+        CAmount assetAmount;
+        if (!GetIndexedAddress(coin.out.scriptPubKey, type, hashBytes, assetName, assetAmount))
+            continue;
+
+        if (assetName.empty()) {
+            addressIndex.push_back(std::make_pair(CAddressIndexKey(type, hashBytes, nHeight, nTx, txhash, j, true), coin.out.nValue * -1));
+            addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(type, hashBytes, prevout.hash, prevout.n),
+                fDisconnect ? CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight) : CAddressUnspentValue()));
+        } else {
+            addressIndex.push_back(std::make_pair(CAddressIndexKey(type, hashBytes, assetName, nHeight, nTx, txhash, j, true), assetAmount * -1));
+            addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(type, hashBytes, assetName, prevout.hash, prevout.n),
+                fDisconnect ? CAddressUnspentValue(assetAmount, coin.out.scriptPubKey, coin.nHeight) : CAddressUnspentValue()));
+        }
+    }
+}
+
+/** Add the receiving activity of a transaction's outputs. Disconnecting erases the unspent outputs it created. */
+static void AddOutputEntries(const CTransaction& tx, int nHeight, unsigned int nTx, bool fDisconnect,
+                             std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                             std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex)
+{
+    const uint256& txhash = tx.GetHash();
+    for (unsigned int k = 0; k < tx.vout.size(); k++) {
+        const CTxOut& out = tx.vout[k];
+        int type;
+        uint160 hashBytes;
+        std::string assetName;
+        CAmount assetAmount;
+        if (!GetIndexedAddress(out.scriptPubKey, type, hashBytes, assetName, assetAmount))
+            continue;
+
+        if (assetName.empty()) {
+            addressIndex.push_back(std::make_pair(CAddressIndexKey(type, hashBytes, nHeight, nTx, txhash, k, false), out.nValue));
+            addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(type, hashBytes, txhash, k),
+                fDisconnect ? CAddressUnspentValue() : CAddressUnspentValue(out.nValue, out.scriptPubKey, nHeight)));
+        } else {
+            addressIndex.push_back(std::make_pair(CAddressIndexKey(type, hashBytes, assetName, nHeight, nTx, txhash, k, false), assetAmount));
+            addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(type, hashBytes, assetName, txhash, k),
+                fDisconnect ? CAddressUnspentValue() : CAddressUnspentValue(assetAmount, out.scriptPubKey, nHeight)));
+        }
+    }
+}
+
+/**
+ * Collect the address index entries of a block from the block and its undo data. The unspent index updates are
+ * ordered like ConnectBlock and DisconnectBlock apply them, so outputs created and spent within the block end up
+ * in the right state.
+ */
+static bool GetBlockEntries(const CBlock& block, const CBlockUndo& blockundo, int nHeight, bool fDisconnect,
+                            std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& addressUnspentIndex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block and undo data inconsistent", __func__);
+    }
+
+    for (unsigned int n = 0; n < block.vtx.size(); n++) {
+        unsigned int i = fDisconnect ? block.vtx.size() - 1 - n : n;
+        const CTransaction& tx = *block.vtx[i];
+        if (i > 0 && blockundo.vtxundo[i-1].vprevout.size() != tx.vin.size()) {
+            return error("%s: transaction and undo data inconsistent", __func__);
+        }
+
+        if (fDisconnect) {
+            AddOutputEntries(tx, nHeight, i, fDisconnect, addressIndex, addressUnspentIndex);
+            if (i > 0) AddInputEntries(tx, blockundo.vtxundo[i-1], nHeight, i, fDisconnect, addressIndex, addressUnspentIndex);
+        } else {
+            if (i > 0) AddInputEntries(tx, blockundo.vtxundo[i-1], nHeight, i, fDisconnect, addressIndex, addressUnspentIndex);
+            AddOutputEntries(tx, nHeight, i, fDisconnect, addressIndex, addressUnspentIndex);
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block is never connected to the UTXO set, so it has nothing to index
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash())) {
+        return false;
+    }
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    if (!GetBlockEntries(block, blockundo, pindex->nHeight, false, addressIndex, addressUnspentIndex)) {
+        return false;
+    }
+    return m_db->WriteEntries(addressIndex, addressUnspentIndex);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Erasing is idempotent, so if this is interrupted the blocks are disconnected again from the committed best
+    // block on the next start.
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo blockundo;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params) ||
+            !UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash())) {
+            return error("%s: failed to read block %s to disconnect from %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+        if (!GetBlockEntries(block, blockundo, pindex->nHeight, true, addressIndex, addressUnspentIndex) ||
+            !m_db->EraseEntries(addressIndex, addressUnspentIndex)) {
+            return error("%s: failed to disconnect block %s from %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+//! Step the cursor past key if it is positioned on it, used to resume iteration after the last returned entry
+template <typename K>
+static void SkipKey(CDBIterator& cursor, char prefix, const K& key)
+{
+    std::pair<char, K> found;
+    if (!cursor.Valid() || !cursor.GetKey(found) || found.first != prefix)
+        return;
+
+    CDataStream ssFound(SER_DISK, CLIENT_VERSION), ssKey(SER_DISK, CLIENT_VERSION);
+    ssFound << found.second;
+    ssKey << key;
+    if (ssFound.str() == ssKey.str())
+        cursor.Next();
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(uint160 addressHash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) const {
+
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(uint160 addressHash, int type, const CAddressUnspentKey* pAfter, size_t nLimit,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           bool &fMore, int start, int end) const {
+
+    fMore = false;
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    if (pAfter) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, *pAfter));
+        SkipKey(*pcursor, DB_ADDRESSUNSPENTINDEX, *pAfter);
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    size_t nRead = 0;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (!pcursor->GetValue(nValue))
+                return error("failed to get address unspent value");
+
+            // Heights are only stored in the value, so outputs outside the range are skipped over
+            if ((start > 0 && nValue.blockHeight < start) || (end > 0 && nValue.blockHeight > end)) {
+                pcursor->Next();
+                continue;
+            }
+
+            if (nLimit && nRead == nLimit) {
+                fMore = true;
+                break;
+            }
+
+            unspentOutputs.push_back(std::make_pair(key.second, nValue));
+            nRead++;
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressIndex(uint160 addressHash, int type, const CAddressIndexKey* pAfter, size_t nLimit,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                    bool &fMore, int start, int end) const {
+
+    fMore = false;
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    if (pAfter) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *pAfter));
+        SkipKey(*pcursor, DB_ADDRESSINDEX, *pAfter);
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    size_t nRead = 0;
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+            // Entries are sorted by asset before height, so jump over the part of each asset outside the range
+            if (start > 0 && key.second.blockHeight < start) {
+                pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, addressHash, key.second.asset, start, 0, uint256(), 0, false)));
+                continue;
+            }
+            if (end > 0 && key.second.blockHeight > end) {
+                pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, addressHash, key.second.asset, -1, 0, uint256(), 0, false)));
+                continue;
+            }
+
+            if (nLimit && nRead == nLimit) {
+                fMore = true;
+                break;
+            }
+
+            CAmount nValue;
+            if (!pcursor->GetValue(nValue))
+                return error("failed to get address index value");
+
+            addressIndex.push_back(std::make_pair(key.second, nValue));
+            nRead++;
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressBalance(uint160 addressHash, int type,
+                                      std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &vect) const {
+
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressBalanceKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSBALANCEINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+            CAddressBalanceValue value;
+            if (pcursor->GetValue(value)) {
+                vect.push_back(std::make_pair(key.second, value));
+                pcursor->Next();
+            } else {
+                return error("failed to get address balance value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressIndex(uint160 addressHash, int type,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                                    int start, int end) const {
+
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    if (start > 0 && end > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
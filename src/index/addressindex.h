@@ -0,0 +1,76 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include "amount.h"
+#include "index/base.h"
+#include "spentindex.h"
+
+#include <memory>
+
+class CScript;
+
+/**
+ * Get the address an output script pays to as it is keyed in the address and spent indexes: type 1 for pay to
+ * pubkey (hash) and asset outputs, type 2 for pay to script hash. For asset outputs the asset name and amount are
+ * returned too, assetName is left empty otherwise. Returns false for scripts without an indexed address.
+ */
+bool GetIndexedAddress(const CScript& script, int& type, uint160& hashBytes, std::string& assetName, CAmount& assetAmount);
+
+/**
+ * AddressIndex records the activity, unspent outputs and balances of each address, including assets held by
+ * them (-addressindex). Entries are built from the blocks and their undo data, so the index is kept on its own
+ * database under indexes/addressindex.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    /// Override base class init to migrate the entries older versions kept in the block tree DB.
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    virtual ~AddressIndex() override;
+
+    /// Erase the entries older versions kept in the block tree DB, for when the index is disabled.
+    static bool EraseLegacyData();
+
+    bool ReadAddressIndex(uint160 addressHash, int type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                          int start = 0, int end = 0) const;
+    //! Read at most nLimit entries that sort after pAfter (from the first one if null), fMore is set if entries remain
+    bool ReadAddressIndex(uint160 addressHash, int type, const CAddressIndexKey* pAfter, size_t nLimit,
+                          std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                          bool &fMore, int start = 0, int end = 0) const;
+    bool ReadAddressUnspentIndex(uint160 addressHash, int type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect) const;
+    //! Read at most nLimit unspent outputs that sort after pAfter (from the first one if null), fMore is set if entries remain
+    bool ReadAddressUnspentIndex(uint160 addressHash, int type, const CAddressUnspentKey* pAfter, size_t nLimit,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect,
+                                 bool &fMore, int start = 0, int end = 0) const;
+    bool ReadAddressBalance(uint160 addressHash, int type,
+                            std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &vect) const;
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -0,0 +1,526 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/base.h"
+
+#include "chainparams.h"
+#include "init.h"
+#include "tinyformat.h"
+#include "txdb.h"
+#include "ui_interface.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "warnings.h"
+
+#include <memory>
+
+#include <boost/thread.hpp>
+
+constexpr char DB_BEST_BLOCK = 'B';
+/// Block tree DB key, with the legacy flag name, of the locator an unfinished migration is in sync with
+constexpr char DB_LEGACY_MIGRATION = 'M';
+
+constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
+constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+
+template<typename... Args>
+static void FatalError(const char* fmt, const Args&... args)
+{
+    std::string strMessage = tfm::format(fmt, args...);
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        _("Error: A fatal internal error occurred, see debug.log for details"),
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
+    CDBWrapper(path, n_cache_size, f_memory, f_wipe, f_obfuscate)
+{}
+
+bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
+{
+    bool success = Read(DB_BEST_BLOCK, locator);
+    if (!success) {
+        locator.SetNull();
+    }
+    return success;
+}
+
+void BaseIndex::DB::WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator)
+{
+    batch.Write(DB_BEST_BLOCK, locator);
+}
+
+/** A database value as the bytes it is stored as, so entries can be moved without knowing their type */
+struct RawDBValue
+{
+    std::vector<char> data;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s.write(data.data(), data.size());
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        data.resize(s.size());
+        s.read(data.data(), data.size());
+    }
+};
+
+/** Persist a batch of moved entries. The new DB is synced before anything is erased from the old one. */
+static void WriteMigrationBatches(CDBWrapper* newdb, CDBWrapper& olddb, CDBBatch* batch_newdb, CDBBatch& batch_olddb)
+{
+    if (newdb) {
+        newdb->WriteBatch(*batch_newdb, /*fSync=*/ true);
+        batch_newdb->Clear();
+    }
+    olddb.WriteBatch(batch_olddb);
+    batch_olddb.Clear();
+}
+
+bool BaseIndex::MigrateLegacyData(CBlockTreeDB& block_tree_db, DB* db, const std::string& legacy_flag,
+                                  const std::vector<char>& prefixes, const CBlockLocator& best_locator)
+{
+    // Like the txindex migration: unset the flag first and remember the tip the entries are in sync with, so an
+    // older version doesn't use a partially moved index and an interrupted migration knows where to resume.
+    const auto marker_key = std::make_pair(DB_LEGACY_MIGRATION, legacy_flag);
+    bool f_legacy_flag = false;
+    block_tree_db.ReadFlag(legacy_flag, f_legacy_flag);
+    if (f_legacy_flag) {
+        if (!block_tree_db.Write(marker_key, best_locator)) {
+            return error("%s: cannot write %s migration marker", __func__, legacy_flag);
+        }
+        if (!block_tree_db.WriteFlag(legacy_flag, false)) {
+            return error("%s: cannot write block index db flag", __func__);
+        }
+    }
+
+    CBlockLocator locator;
+    if (!block_tree_db.Read(marker_key, locator)) {
+        return true;
+    }
+
+    // An index this version already built is newer than the legacy entries, they are only left to erase
+    CBlockLocator index_locator;
+    if (db && db->ReadBestBlock(index_locator)) {
+        db = nullptr;
+    }
+
+    LogPrintf("%s legacy %s entries...\n", db ? "Moving" : "Erasing", legacy_flag);
+    const size_t batch_size = 1 << 24; // 16 MiB
+
+    std::unique_ptr<CDBBatch> batch_newdb(db ? new CDBBatch(*db) : nullptr);
+    CDBBatch batch_olddb(block_tree_db);
+
+    int64_t count = 0;
+    bool interrupted = false;
+    std::unique_ptr<CDBIterator> cursor(block_tree_db.NewIterator());
+    for (char prefix : prefixes) {
+        // It's OK to erase entries the cursor has passed, LevelDB iterators work on a consistent snapshot
+        for (cursor->Seek(prefix); cursor->Valid(); cursor->Next()) {
+            boost::this_thread::interruption_point();
+            if (ShutdownRequested()) {
+                interrupted = true;
+                break;
+            }
+
+            CDataStream key = cursor->GetKey();
+            if (key.empty() || key[0] != prefix) {
+                break;
+            }
+            if (db) {
+                RawDBValue value;
+                if (!cursor->GetValue(value)) {
+                    return error("%s: cannot read %s record", __func__, legacy_flag);
+                }
+                batch_newdb->Write(key, value);
+            }
+            batch_olddb.Erase(key);
+
+            if (++count % 1000000 == 0) {
+                LogPrintf("%s legacy %s entries... [%d]\n", db ? "Moving" : "Erasing", legacy_flag, count);
+            }
+            if (batch_olddb.SizeEstimate() > batch_size || (db && batch_newdb->SizeEstimate() > batch_size)) {
+                WriteMigrationBatches(db, block_tree_db, batch_newdb.get(), batch_olddb);
+            }
+        }
+        if (interrupted) {
+            break;
+        }
+        WriteMigrationBatches(db, block_tree_db, batch_newdb.get(), batch_olddb);
+        block_tree_db.CompactRange(prefix, (char)(prefix + 1));
+    }
+
+    // Only once everything is moved the index DB is in sync with the locator and the marker can go
+    if (!interrupted) {
+        batch_olddb.Erase(marker_key);
+        if (db) {
+            db->WriteBestBlock(*batch_newdb, locator);
+        }
+    }
+    WriteMigrationBatches(db, block_tree_db, batch_newdb.get(), batch_olddb);
+
+    if (interrupted) {
+        LogPrintf("%s migration [CANCELLED].\n", legacy_flag);
+        return false;
+    }
+
+    LogPrintf("%s migration [DONE], %d entries.\n", legacy_flag, count);
+    return true;
+}
+
+BaseIndex::~BaseIndex()
+{
+    Interrupt();
+    Stop();
+}
+
+bool BaseIndex::Init()
+{
+    CBlockLocator locator;
+    if (!GetDB().ReadBestBlock(locator)) {
+        locator.SetNull();
+    }
+
+    LOCK(cs_main);
+    if (locator.IsNull()) {
+        m_best_block_index = nullptr;
+    } else {
+        // Resume from the block the index was committed at even if it is no longer in the active chain, so
+        // the sync thread disconnects it from indexes that keep state across blocks.
+        BlockMap::const_iterator it = mapBlockIndex.find(locator.vHave[0]);
+        if (it != mapBlockIndex.end()) {
+            m_best_block_index = it->second;
+        } else {
+            m_best_block_index = FindForkInGlobalIndex(chainActive, locator);
+        }
+    }
+    m_synced = m_best_block_index.load() == chainActive.Tip();
+    return true;
+}
+
+static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev)
+{
+    AssertLockHeld(cs_main);
+
+    if (!pindex_prev) {
+        return chainActive.Genesis();
+    }
+
+    const CBlockIndex* pindex = chainActive.Next(pindex_prev);
+    if (pindex) {
+        return pindex;
+    }
+
+    return chainActive.Next(chainActive.FindFork(pindex_prev));
+}
+
+void BaseIndex::ThreadSync()
+{
+    const CBlockIndex* pindex = m_best_block_index.load();
+    if (!m_synced) {
+        auto& consensus_params = Params().GetConsensus();
+
+        int64_t last_log_time = 0;
+        int64_t last_locator_write_time = 0;
+        while (true) {
+            if (m_interrupt) {
+                m_best_block_index = pindex;
+                // No need to handle errors in Commit. If it fails, the error will be already be
+                // logged. The best way to recover is to continue, as index cannot be corrupted by
+                // a missed commit to disk for an advanced index state.
+                Commit();
+                return;
+            }
+
+            {
+                LOCK(cs_main);
+                const CBlockIndex* pindex_next = NextSyncBlock(pindex);
+                if (!pindex_next) {
+                    // Blocks beyond the active chain, eg. of a branch that was reorganized away while the
+                    // node was down, are disconnected before the index follows the chain.
+                    if (pindex && !chainActive.Contains(pindex)) {
+                        const CBlockIndex* fork = chainActive.FindFork(pindex);
+                        m_best_block_index = pindex;
+                        if (!fork || !Rewind(pindex, fork)) {
+                            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                                       __func__, GetName());
+                            return;
+                        }
+                        pindex = fork;
+                    }
+                    m_best_block_index = pindex;
+                    m_synced = true;
+                    // No need to handle errors in Commit. See rationale above.
+                    Commit();
+                    break;
+                }
+                if (pindex_next->pprev != pindex) {
+                    m_best_block_index = pindex;
+                    if (!Rewind(pindex, pindex_next->pprev)) {
+                        FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                                   __func__, GetName());
+                        return;
+                    }
+                }
+                pindex = pindex_next;
+            }
+
+            int64_t current_time = GetTime();
+            if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
+                LogPrintf("Syncing %s with block chain from height %d\n",
+                          GetName(), pindex->nHeight);
+                last_log_time = current_time;
+            }
+
+            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                m_best_block_index = pindex->pprev;
+                last_locator_write_time = current_time;
+                // No need to handle errors in Commit. See rationale above.
+                Commit();
+            }
+
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+                FatalError("%s: Failed to read block %s from disk",
+                           __func__, pindex->GetBlockHash().ToString());
+                return;
+            }
+            if (!WriteBlock(block, pindex)) {
+                FatalError("%s: Failed to write block %s to index database",
+                           __func__, pindex->GetBlockHash().ToString());
+                return;
+            }
+        }
+    }
+
+    if (pindex) {
+        LogPrintf("%s is enabled at height %d\n", GetName(), pindex->nHeight);
+    } else {
+        LogPrintf("%s is enabled\n", GetName());
+    }
+
+    while (true) {
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            m_queue_cv.wait(lock, [this] { return m_interrupt || !m_queue.empty(); });
+            if (m_interrupt) {
+                break;
+            }
+            fn = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queue_processing = true;
+        }
+
+        fn();
+
+        {
+            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            m_queue_processing = false;
+        }
+        m_queue_cv.notify_all();
+    }
+
+    // Notifications still in the queue are dropped; the index catches up on them from the block files after a
+    // restart. No need to handle errors in Commit. See rationale above.
+    Commit();
+}
+
+bool BaseIndex::Commit()
+{
+    CDBBatch batch(GetDB());
+    if (!CommitInternal(batch) || !GetDB().WriteBatch(batch)) {
+        return error("%s: Failed to commit latest %s state", __func__, GetName());
+    }
+    return true;
+}
+
+bool BaseIndex::CommitInternal(CDBBatch& batch)
+{
+    // The locator is built from the block's ancestors, so committing doesn't need cs_main and
+    // BlockUntilSyncedToCurrentChain can wait for the index thread while holding it.
+    GetDB().WriteBestBlock(batch, GetLocator(m_best_block_index.load()));
+    return true;
+}
+
+bool BaseIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip == m_best_block_index);
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // In the case of a reorg, ensure persisted block locator is not stale.
+    m_best_block_index = new_tip;
+    if (!Commit()) {
+        // If commit fails, revert the best block index to avoid corruption.
+        m_best_block_index = current_tip;
+        return false;
+    }
+
+    return true;
+}
+
+void BaseIndex::QueueNotification(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_queue.push_back(std::move(fn));
+    }
+    m_queue_cv.notify_all();
+}
+
+void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                               const std::vector<CTransactionRef>& txn_conflicted)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    QueueNotification([this, block, pindex] { ProcessBlockConnected(block, pindex); });
+}
+
+void BaseIndex::ProcessBlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!best_block_index) {
+        if (pindex->nHeight != 0) {
+            FatalError("%s: First block connected is not the genesis block (height=%d)",
+                       __func__, pindex->nHeight);
+            return;
+        }
+    } else {
+        // Ensure block connects to an ancestor of the current best block. This should be the case
+        // most of the time, but may not be immediately after the sync thread catches up and sets
+        // m_synced. In this unlikely event, log a warning and let the next block catch up.
+        if (best_block_index->GetAncestor(pindex->nHeight - 1) != pindex->pprev) {
+            LogPrintf("%s: WARNING: Block %s does not connect to an ancestor of " /* Continued */
+                      "known best chain (tip=%s); not updating index\n",
+                      __func__, pindex->GetBlockHash().ToString(),
+                      best_block_index->GetBlockHash().ToString());
+            return;
+        }
+        if (best_block_index != pindex->pprev && !Rewind(best_block_index, pindex->pprev)) {
+            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                       __func__, GetName());
+            return;
+        }
+    }
+
+    if (WriteBlock(*block, pindex)) {
+        m_best_block_index = pindex;
+    } else {
+        FatalError("%s: Failed to write block %s to index",
+                   __func__, pindex->GetBlockHash().ToString());
+        return;
+    }
+}
+
+void BaseIndex::SetBestChain(const CBlockLocator& locator)
+{
+    if (!m_synced || locator.IsNull()) {
+        return;
+    }
+
+    // Look the block up here rather than on the index thread, which must not need cs_main
+    const uint256& locator_tip_hash = locator.vHave.front();
+    const CBlockIndex* locator_tip_index;
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator mi = mapBlockIndex.find(locator_tip_hash);
+        locator_tip_index = mi != mapBlockIndex.end() ? mi->second : nullptr;
+    }
+
+    QueueNotification([this, locator_tip_hash, locator_tip_index] { ProcessSetBestChain(locator_tip_hash, locator_tip_index); });
+}
+
+void BaseIndex::ProcessSetBestChain(const uint256& locator_tip_hash, const CBlockIndex* locator_tip_index)
+{
+    if (!locator_tip_index) {
+        FatalError("%s: First block (hash=%s) in locator was not found",
+                   __func__, locator_tip_hash.ToString());
+        return;
+    }
+
+    // This checks that the flush is received after BlockConnected. The check may fail
+    // immediately after the sync thread catches up and sets m_synced. Consider the case where
+    // there is a reorg and the blocks on the stale branch are connected again before the
+    // index reaches them. In this unlikely event, log a warning and let the next flush commit.
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!best_block_index || best_block_index->GetAncestor(locator_tip_index->nHeight) != locator_tip_index) {
+        LogPrintf("%s: WARNING: Locator contains block (hash=%s) not on known best " /* Continued */
+                  "chain (tip=%s); not writing index locator\n",
+                  __func__, locator_tip_hash.ToString(),
+                  best_block_index ? best_block_index->GetBlockHash().ToString() : "null");
+        return;
+    }
+
+    // No need to handle errors in Commit. If it fails, the error will be already be logged. The
+    // best way to recover is to continue, as index cannot be corrupted by a missed commit to disk
+    // for an advanced index state.
+    Commit();
+}
+
+bool BaseIndex::BlockUntilSyncedToCurrentChain()
+{
+    if (!m_synced) {
+        return false;
+    }
+
+    {
+        // Skip the queue if the index is already in sync with the tip.
+        LOCK(cs_main);
+        const CBlockIndex* chain_tip = chainActive.Tip();
+        const CBlockIndex* best_block_index = m_best_block_index.load();
+        if (best_block_index && best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip) {
+            return true;
+        }
+    }
+
+    // Every block connected up to the tip seen above was queued under cs_main, so the index has caught up with
+    // that tip once the queue is drained.
+    std::unique_lock<std::mutex> lock(m_queue_mutex);
+    m_queue_cv.wait(lock, [this] { return m_interrupt || (m_queue.empty() && !m_queue_processing); });
+    return !m_interrupt;
+}
+
+void BaseIndex::Interrupt()
+{
+    m_interrupt();
+    {
+        // Taking the lock makes sure a thread about to wait on the queue sees the interrupt.
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+    }
+    m_queue_cv.notify_all();
+}
+
+void BaseIndex::Start()
+{
+    // Need to register this ValidationInterface before running Init(), so that
+    // callbacks are not missed if Init sets m_synced to true.
+    RegisterValidationInterface(this);
+    if (!Init()) {
+        FatalError("%s: %s failed to initialize", __func__, GetName());
+        return;
+    }
+
+    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, GetName(),
+                                std::bind(&BaseIndex::ThreadSync, this));
+}
+
+void BaseIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+    Interrupt();
+
+    if (m_thread_sync.joinable()) {
+        m_thread_sync.join();
+    }
+}
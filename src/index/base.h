@@ -0,0 +1,163 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BASE_H
+#define BITCOIN_INDEX_BASE_H
+
+#include "dbwrapper.h"
+#include "primitives/block.h"
+#include "primitives/transaction.h"
+#include "threadinterrupt.h"
+#include "uint256.h"
+#include "validationinterface.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+class CBlockTreeDB;
+
+/**
+ * Base class for indices of blockchain data. This implements
+ * CValidationInterface and ensures blocks are indexed sequentially according
+ * to their position in the active chain.
+ *
+ * An index catches up from the block files on its own thread, with its own database, and follows the active chain
+ * from BlockConnected once it reached the tip. It can therefore be enabled on an existing node without -reindex.
+ * Notifications are only queued by the validation callbacks and written by the index thread, so connecting a
+ * block never waits for index writes.
+ */
+class BaseIndex : public CValidationInterface
+{
+protected:
+    class DB : public CDBWrapper
+    {
+    public:
+        DB(const fs::path& path, size_t n_cache_size,
+           bool f_memory = false, bool f_wipe = false, bool f_obfuscate = false);
+
+        /// Read block locator of the chain that the index is in sync with.
+        bool ReadBestBlock(CBlockLocator& locator) const;
+
+        /// Write block locator of the chain that the index is in sync with.
+        void WriteBestBlock(CDBBatch& batch, const CBlockLocator& locator);
+    };
+
+private:
+    /// Whether the index is in sync with the main chain. The flag is flipped
+    /// from false to true once, after which point this starts processing
+    /// ValidationInterface notifications to stay in sync.
+    std::atomic<bool> m_synced{false};
+
+    /// The last block in the chain that the index is in sync with.
+    std::atomic<const CBlockIndex*> m_best_block_index{nullptr};
+
+    std::thread m_thread_sync;
+    CThreadInterrupt m_interrupt;
+
+    /// Notifications received after the index got in sync, in the order they were
+    /// sent. They are written to the index by m_thread_sync.
+    std::mutex m_queue_mutex;
+    std::condition_variable m_queue_cv;
+    std::deque<std::function<void()>> m_queue;
+    bool m_queue_processing{false};
+
+    /// Sync the index with the block index starting from the current best block.
+    /// Intended to be run in its own thread, m_thread_sync, and can be
+    /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
+    /// flag is set and the thread goes on to process the notifications queued
+    /// by the ValidationInterface callbacks until it is interrupted.
+    void ThreadSync();
+
+    /// Write a block queued by BlockConnected, rewinding the index first if the block is on another branch.
+    void ProcessBlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex);
+
+    /// Commit the index state for a chain state flush queued by SetBestChain. locator_tip_index is
+    /// the block the flush was at, or nullptr if it wasn't found.
+    void ProcessSetBestChain(const uint256& locator_tip_hash, const CBlockIndex* locator_tip_index);
+
+    /// Append a notification to m_queue and wake up the index thread.
+    void QueueNotification(std::function<void()> fn);
+
+    /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
+    ///
+    /// Recommendations for error handling:
+    /// If called on a successor of the previous committed best block in the index, the index can
+    /// continue processing without risk of corruption, though the index state will need to catch up
+    /// from further behind on reboot. If the new state is not a successor of the previous state (due
+    /// to a chain reorganization), the index must halt until Commit succeeds or else it could end up
+    /// getting corrupted.
+    bool Commit();
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                        const std::vector<CTransactionRef>& txn_conflicted) override;
+
+    /// Called when the chain state is flushed to disk; the index commits its own state at the same point.
+    void SetBestChain(const CBlockLocator& locator) override;
+
+    /// Initialize internal state from the database and block index.
+    virtual bool Init();
+
+    /// Move the entries that versions before the separate index databases kept in the block tree DB under the
+    /// given key prefixes into db, or just erase them if db is null. legacy_flag is the block tree DB flag those
+    /// versions set while they kept the index in sync with the chain tip, best_locator. An interrupted migration
+    /// resumes on the next start. Once it completes, db is in sync with the chain the entries were moved at.
+    static bool MigrateLegacyData(CBlockTreeDB& block_tree_db, DB* db, const std::string& legacy_flag,
+                                  const std::vector<char>& prefixes, const CBlockLocator& best_locator);
+
+    /// Write update index entries for a newly connected block.
+    virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
+
+    /// Virtual method called internally by Commit that can be overridden to atomically
+    /// commit more index state.
+    virtual bool CommitInternal(CDBBatch& batch);
+
+    /// Rewind index to an earlier chain tip during a chain reorg. The tip must
+    /// be an ancestor of the current best block.
+    virtual bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
+
+    virtual DB& GetDB() const = 0;
+
+    /// Get the name of the index for display in logs.
+    virtual const char* GetName() const = 0;
+
+public:
+    /// Destructor interrupts sync thread if running and blocks until it exits.
+    virtual ~BaseIndex();
+
+    /// Blocks the current thread until the index is caught up to the current
+    /// state of the block chain. This only blocks if the index has gotten in
+    /// sync once and only needs to process the blocks in its queue. If the
+    /// index is catching up from far behind, this method does not block and
+    /// immediately returns false. The index thread doesn't take cs_main for
+    /// the queued notifications, so this may be called while holding it.
+    /// WriteBlock, Rewind and CommitInternal must not take cs_main either.
+    bool BlockUntilSyncedToCurrentChain();
+
+    void Interrupt();
+
+    /// Start initializes the sync state and registers the instance as a
+    /// ValidationInterface so that it stays in sync with blockchain updates.
+    void Start();
+
+    /// Stops the instance from staying in sync with blockchain updates and
+    /// waits for the index thread to commit its state and exit.
+    void Stop();
+
+    /// Whether the index caught up with the active chain and follows it from BlockConnected.
+    bool IsSynced() const { return m_synced; }
+
+    /// The last block the index is in sync with, or nullptr if it has not indexed the genesis block yet.
+    const CBlockIndex* GetBestBlockIndex() const { return m_best_block_index.load(); }
+};
+
+#endif // BITCOIN_INDEX_BASE_H
@@ -0,0 +1,483 @@
+// Copyright (c) 2020-2021 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/coinstatsindex.h"
+
+#include "chainparams.h"
+#include "coins.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+#include <map>
+
+/* The index database stores a DBVal with the UTXO set statistics after each block under the height of the
+ * block while it is in the active chain. When a block is disconnected, its DBVal is copied to a key by block
+ * hash, like the block filter index does, so the statistics of stale blocks can still be looked up.
+ *
+ * The amount held of an asset is stored under [DB_ASSET_TOTAL, asset name, ~height (BE)] whenever a block
+ * changes it, together with the hash of that block. The inverted height sorts the entries of an asset from the
+ * newest to the oldest, so the total after a block is the first entry at or below its height that was written
+ * by one of its ancestors. Entries left behind by stale blocks are skipped over that way and don't need to be
+ * erased on a reorg.
+ *
+ * The MuHash state of the best block is stored under DB_MUHASH and committed together with the best block
+ * locator.
+ */
+constexpr char DB_BLOCK_HASH = 's';
+constexpr char DB_BLOCK_HEIGHT = 't';
+constexpr char DB_MUHASH = 'M';
+constexpr char DB_ASSET_TOTAL = 'a';
+
+std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
+
+namespace {
+
+struct DBVal {
+    uint256 muhash;
+    uint64_t transaction_output_count;
+    uint64_t bogo_size;
+    CAmount total_amount;
+    uint64_t asset_output_count;
+    uint64_t asset_count;
+
+    DBVal() : transaction_output_count(0), bogo_size(0), total_amount(0), asset_output_count(0), asset_count(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(muhash);
+        READWRITE(transaction_output_count);
+        READWRITE(bogo_size);
+        READWRITE(total_amount);
+        READWRITE(asset_output_count);
+        READWRITE(asset_count);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHashKey {
+    uint256 hash;
+
+    explicit DBHashKey(const uint256& hash_in) : hash(hash_in) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        char prefix = DB_BLOCK_HASH;
+        READWRITE(prefix);
+        if (prefix != DB_BLOCK_HASH) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB hash key");
+        }
+
+        READWRITE(hash);
+    }
+};
+
+struct DBAssetKey {
+    std::string asset;
+    int height;
+
+    DBAssetKey() : height(0) {}
+    DBAssetKey(const std::string& asset_in, int height_in) : asset(asset_in), height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ASSET_TOTAL);
+        s << asset;
+        ser_writedata32be(s, ~static_cast<uint32_t>(height));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_ASSET_TOTAL) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB asset key");
+        }
+        s >> asset;
+        height = ~ser_readdata32be(s);
+    }
+};
+
+}; // namespace
+
+CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(new BaseIndex::DB(GetDataDir() / "indexes" / "coinstats", n_cache_size, f_memory, f_wipe))
+{}
+
+/** Add the asset an output holds, if any, to the per asset deltas of a block. */
+static void AddAssetDelta(const CScript& scriptPubKey, int sign, std::map<std::string, CAmount>& asset_deltas,
+                          uint64_t& asset_output_count)
+{
+    std::string asset_name;
+    CAmount amount;
+    if (GetScriptAssetAmount(scriptPubKey, asset_name, amount)) {
+        asset_deltas[asset_name] += sign * amount;
+        asset_output_count += sign;
+    }
+}
+
+/**
+ * Read the amount of an asset held after a block: the newest total written by the block or one of its
+ * ancestors. The iterator is left on the entry that was used.
+ */
+static bool ReadAssetTotal(CDBIterator& db_it, const std::string& asset, const CBlockIndex* pindex, CAmount& total)
+{
+    total = 0;
+    if (!pindex) return true;
+
+    DBAssetKey key;
+    db_it.Seek(DBAssetKey(asset, pindex->nHeight));
+    while (db_it.Valid() && db_it.GetKey(key) && key.asset == asset) {
+        std::pair<uint256, CAmount> value;
+        if (!db_it.GetValue(value)) {
+            return error("%s: unable to read total of asset %s at height %d", __func__, asset, key.height);
+        }
+        // Entries written by blocks that aren't ancestors were left behind by a reorg
+        if (pindex->GetAncestor(key.height)->GetBlockHash() == value.first) {
+            total = value.second;
+            return true;
+        }
+        db_it.Next();
+    }
+    return true;
+}
+
+/** Read the amount held of every asset after a block, leaving out assets it holds none of. */
+static bool ReadAssetTotals(CDBWrapper& db, const CBlockIndex* pindex, std::map<std::string, CAmount>& totals)
+{
+    std::unique_ptr<CDBIterator> db_it(db.NewIterator());
+    db_it->Seek(DB_ASSET_TOTAL);
+
+    DBAssetKey key;
+    while (db_it->Valid() && db_it->GetKey(key)) {
+        const std::string asset = key.asset;
+        CAmount total;
+        if (!ReadAssetTotal(*db_it, asset, pindex, total)) {
+            return false;
+        }
+        if (total != 0) {
+            totals.emplace(asset, total);
+        }
+
+        // Skip over the older entries of the asset, the entry at height 0 sorts last
+        db_it->Seek(DBAssetKey(asset, 0));
+        if (db_it->Valid() && db_it->GetKey(key) && key.asset == asset) {
+            db_it->Next();
+        }
+    }
+    return true;
+}
+
+bool CoinStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    std::map<std::string, CAmount> asset_deltas;
+
+    // The outputs of the genesis block are never added to the UTXO set
+    if (pindex->nHeight > 0) {
+        CBlockUndo block_undo;
+        if (!UndoReadFromDisk(block_undo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash())) {
+            return false;
+        }
+        if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return error("%s: block and undo data inconsistent", __func__);
+        }
+
+        std::pair<uint256, DBVal> read_out;
+        if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+            return false;
+        }
+
+        uint256 expected_block_hash = pindex->pprev->GetBlockHash();
+        if (read_out.first != expected_block_hash) {
+            return error("%s: previous block statistics belong to unexpected block %s; expected %s",
+                         __func__, read_out.first.ToString(), expected_block_hash.ToString());
+        }
+
+        for (size_t i = 0; i < block.vtx.size(); ++i) {
+            const CTransaction& tx = *block.vtx[i];
+
+            for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+                const CTxOut& out = tx.vout[j];
+
+                // Skip unspendable outputs since they are not included in the UTXO set
+                if (out.scriptPubKey.IsUnspendable()) continue;
+
+                ApplyCoinHash(m_muhash, COutPoint(tx.GetHash(), j), Coin(out, pindex->nHeight, tx.IsCoinBase()));
+                ++m_transaction_output_count;
+                m_bogo_size += GetBogoSize(out.scriptPubKey);
+                m_total_amount += out.nValue;
+                AddAssetDelta(out.scriptPubKey, 1, asset_deltas, m_asset_output_count);
+            }
+
+            // The coinbase tx has no undo data since no former output is spent
+            if (i == 0) continue;
+
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            if (tx_undo.vprevout.size() != tx.vin.size()) {
+                return error("%s: transaction and undo data inconsistent", __func__);
+            }
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout[j];
+
+                RemoveCoinHash(m_muhash, tx.vin[j].prevout, coin);
+                --m_transaction_output_count;
+                m_bogo_size -= GetBogoSize(coin.out.scriptPubKey);
+                m_total_amount -= coin.out.nValue;
+                AddAssetDelta(coin.out.scriptPubKey, -1, asset_deltas, m_asset_output_count);
+            }
+        }
+    }
+
+    CDBBatch batch(*m_db);
+    if (!asset_deltas.empty()) {
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+        for (const auto& delta : asset_deltas) {
+            if (delta.second == 0) continue;
+
+            CAmount prev_total;
+            if (!ReadAssetTotal(*db_it, delta.first, pindex->pprev, prev_total)) {
+                return false;
+            }
+            CAmount total = prev_total + delta.second;
+            if (prev_total == 0 && total != 0) {
+                ++m_asset_count;
+            } else if (prev_total != 0 && total == 0) {
+                --m_asset_count;
+            }
+            batch.Write(DBAssetKey(delta.first, pindex->nHeight), std::make_pair(pindex->GetBlockHash(), total));
+        }
+    }
+
+    DBVal value;
+    m_muhash.Finalize(value.muhash);
+    value.transaction_output_count = m_transaction_output_count;
+    value.bogo_size = m_bogo_size;
+    value.total_amount = m_total_amount;
+    value.asset_output_count = m_asset_output_count;
+    value.asset_count = m_asset_count;
+    batch.Write(DBHeightKey(pindex->nHeight), std::make_pair(pindex->GetBlockHash(), value));
+    return m_db->WriteBatch(batch);
+}
+
+static bool CopyHeightIndexToHashIndex(CDBIterator& db_it, CDBBatch& batch,
+                                       const std::string& index_name,
+                                       int start_height, int stop_height)
+{
+    DBHeightKey key(start_height);
+    db_it.Seek(key);
+
+    for (int height = start_height; height <= stop_height; ++height) {
+        if (!db_it.GetKey(key) || key.height != height) {
+            return error("%s: unexpected key in %s: expected (%c, %d)",
+                         __func__, index_name, DB_BLOCK_HEIGHT, height);
+        }
+
+        std::pair<uint256, DBVal> value;
+        if (!db_it.GetValue(value)) {
+            return error("%s: unable to read value in %s at key (%c, %d)",
+                         __func__, index_name, DB_BLOCK_HEIGHT, height);
+        }
+
+        batch.Write(DBHashKey(value.first), std::move(value.second));
+
+        db_it.Next();
+    }
+    return true;
+}
+
+bool CoinStatsIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    {
+        CDBBatch batch(*m_db);
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+
+        // During a reorg, we need to copy the statistics of all blocks that are getting disconnected from the
+        // height index to the hash index so we can still find them when the height index entries are overwritten.
+        if (!CopyHeightIndexToHashIndex(*db_it, batch, GetName(), new_tip->nHeight, current_tip->nHeight)) {
+            return false;
+        }
+
+        if (!m_db->WriteBatch(batch)) return false;
+    }
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!ReverseBlock(block, pindex)) {
+            return false;
+        }
+    }
+
+    // The counters are restored from the statistics stored for the new tip, which also verifies the reversed MuHash
+    if (!LoadBlockStats(new_tip)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+static bool LookupOne(CDBWrapper& db, const CBlockIndex* block_index, DBVal& result)
+{
+    // First check if the result is stored under the height index and the value there matches the
+    // block hash. This should be the case if the block is on the active chain.
+    std::pair<uint256, DBVal> read_out;
+    if (!db.Read(DBHeightKey(block_index->nHeight), read_out)) {
+        return false;
+    }
+    if (read_out.first == block_index->GetBlockHash()) {
+        result = std::move(read_out.second);
+        return true;
+    }
+
+    // If value at the height index corresponds to an different block, the result will be stored in
+    // the hash index.
+    return db.Read(DBHashKey(block_index->GetBlockHash()), result);
+}
+
+bool CoinStatsIndex::LookUpStats(const CBlockIndex* block_index, CCoinsStats& coins_stats, bool fAssetTotals) const
+{
+    DBVal entry;
+    if (!LookupOne(*m_db, block_index, entry)) {
+        return false;
+    }
+
+    coins_stats.nHeight = block_index->nHeight;
+    coins_stats.hashBlock = block_index->GetBlockHash();
+    coins_stats.hashSerialized = entry.muhash;
+    coins_stats.nTransactionOutputs = entry.transaction_output_count;
+    coins_stats.nBogoSize = entry.bogo_size;
+    coins_stats.nTotalAmount = entry.total_amount;
+    coins_stats.nAssetOutputs = entry.asset_output_count;
+    coins_stats.nAssets = entry.asset_count;
+    coins_stats.fFromIndex = true;
+
+    if (fAssetTotals && !ReadAssetTotals(*m_db, block_index, coins_stats.mapAssetTotals)) {
+        return false;
+    }
+    return true;
+}
+
+bool CoinStatsIndex::LoadBlockStats(const CBlockIndex* pindex)
+{
+    DBVal entry;
+    if (!LookupOne(*m_db, pindex, entry)) {
+        return error("%s: Cannot read the %s statistics of block %s; index may be corrupted",
+                     __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+
+    uint256 muhash;
+    m_muhash.Finalize(muhash);
+    if (entry.muhash != muhash) {
+        return error("%s: MuHash of the %s state doesn't match block %s; index may be corrupted",
+                     __func__, GetName(), pindex->GetBlockHash().ToString());
+    }
+
+    m_transaction_output_count = entry.transaction_output_count;
+    m_bogo_size = entry.bogo_size;
+    m_total_amount = entry.total_amount;
+    m_asset_output_count = entry.asset_output_count;
+    m_asset_count = entry.asset_count;
+    return true;
+}
+
+bool CoinStatsIndex::Init()
+{
+    if (!m_db->Read(DB_MUHASH, m_muhash)) {
+        // Check that the cause of the read failure is that the key does not exist. Any other errors
+        // indicate database corruption or a disk failure, and starting the index would cause
+        // further corruption.
+        if (m_db->Exists(DB_MUHASH)) {
+            return error("%s: Cannot read current %s state; index may be corrupted",
+                         __func__, GetName());
+        }
+    }
+
+    if (!BaseIndex::Init()) {
+        return false;
+    }
+
+    const CBlockIndex* pindex = GetBestBlockIndex();
+    if (pindex && !LoadBlockStats(pindex)) {
+        return false;
+    }
+    return true;
+}
+
+bool CoinStatsIndex::CommitInternal(CDBBatch& batch)
+{
+    // The MuHash state is committed together with the best block it belongs to
+    batch.Write(DB_MUHASH, m_muhash);
+    return BaseIndex::CommitInternal(batch);
+}
+
+bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    if (pindex->nHeight == 0) {
+        return true;
+    }
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash())) {
+        return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block and undo data inconsistent", __func__);
+    }
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+
+            RemoveCoinHash(m_muhash, COutPoint(tx.GetHash(), j), Coin(out, pindex->nHeight, tx.IsCoinBase()));
+        }
+
+        if (i == 0) continue;
+
+        const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+        if (tx_undo.vprevout.size() != tx.vin.size()) {
+            return error("%s: transaction and undo data inconsistent", __func__);
+        }
+        for (size_t j = 0; j < tx.vin.size(); ++j) {
+            ApplyCoinHash(m_muhash, tx.vin[j].prevout, tx_undo.vprevout[j]);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2020-2021 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_COINSTATSINDEX_H
+#define BITCOIN_INDEX_COINSTATSINDEX_H
+
+#include "amount.h"
+#include "coinstats.h"
+#include "crypto/muhash.h"
+#include "index/base.h"
+
+#include <memory>
+
+static const bool DEFAULT_COINSTATSINDEX = false;
+
+/**
+ * CoinStatsIndex maintains statistics on the UTXO set after each block: a rolling MuHash of the unspent
+ * outputs, their count, size and total amount, and the amount held of each asset. The MuHash is updated from
+ * the outputs a block creates and the ones its undo data says it spent, so the statistics of the tip and of
+ * any earlier block can be looked up without scanning the chainstate.
+ */
+class CoinStatsIndex final : public BaseIndex
+{
+private:
+    const std::unique_ptr<BaseIndex::DB> m_db;
+
+    MuHash3072 m_muhash;
+    uint64_t m_transaction_output_count{0};
+    uint64_t m_bogo_size{0};
+    CAmount m_total_amount{0};
+    uint64_t m_asset_output_count{0};
+    uint64_t m_asset_count{0};
+
+    /// Undo the changes a block made to the MuHash.
+    bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
+
+    /// Read the statistics stored for a block and make them the current state.
+    bool LoadBlockStats(const CBlockIndex* pindex);
+
+protected:
+    bool Init() override;
+
+    bool CommitInternal(CDBBatch& batch) override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "coinstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit CoinStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Look up the UTXO set statistics after a block. The asset totals are only filled in if fAssetTotals is set,
+    /// and can only be looked up for blocks in the chain the index follows.
+    bool LookUpStats(const CBlockIndex* block_index, CCoinsStats& coins_stats, bool fAssetTotals) const;
+};
+
+/// The global UTXO set statistics index. May be null.
+extern std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
+
+#endif // BITCOIN_INDEX_COINSTATSINDEX_H
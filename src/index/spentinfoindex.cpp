@@ -0,0 +1,145 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/spentinfoindex.h"
+
+#include "chainparams.h"
+#include "index/addressindex.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+static const char DB_SPENTINDEX = 'p';
+
+std::unique_ptr<SpentIndex> g_spentindex;
+
+/** Access to the spent index database (indexes/spentindex/) */
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    //! Write the entries with a value and erase the ones without
+    bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect);
+};
+
+SpentIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool SpentIndex::DB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& vect) {
+    CDBBatch batch(*this);
+    for (const auto& entry : vect) {
+        if (entry.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_SPENTINDEX, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_SPENTINDEX, entry.first), entry.second);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(new SpentIndex::DB(n_cache_size, f_memory, f_wipe))
+{}
+
+SpentIndex::~SpentIndex() {}
+
+bool SpentIndex::Init()
+{
+    LOCK(cs_main);
+    if (!MigrateLegacyData(*pblocktree, m_db.get(), "spentindex", {DB_SPENTINDEX}, chainActive.GetLocator())) {
+        return false;
+    }
+    return BaseIndex::Init();
+}
+
+bool SpentIndex::EraseLegacyData()
+{
+    LOCK(cs_main);
+    return MigrateLegacyData(*pblocktree, nullptr, "spentindex", {DB_SPENTINDEX}, chainActive.GetLocator());
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const { return *m_db; }
+
+/** Collect the spent index entries of a block from the block and its undo data. */
+static bool GetBlockEntries(const CBlock& block, const CBlockUndo& blockundo, int nHeight,
+                            std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& spentIndex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block and undo data inconsistent", __func__);
+    }
+
+    for (unsigned int i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const CTxUndo& txundo = blockundo.vtxundo[i-1];
+        if (txundo.vprevout.size() != tx.vin.size()) {
+            return error("%s: transaction and undo data inconsistent", __func__);
+        }
+
+        for (unsigned int j = 0; j < tx.vin.size(); j++) {
+            const COutPoint& prevout = tx.vin[j].prevout;
+
+            // The address of asset outputs is recorded, their amount stays the output value like for any other output
+            const CTxOut& out = txundo.vprevout[j].out;
+            int type;
+            uint160 hashBytes;
+            std::string assetName;
+            CAmount assetAmount;
+            GetIndexedAddress(out.scriptPubKey, type, hashBytes, assetName, assetAmount);
+            spentIndex.push_back(std::make_pair(CSpentIndexKey(prevout.hash, prevout.n),
+                                                CSpentIndexValue(tx.GetHash(), j, nHeight, out.nValue, type, hashBytes)));
+        }
+    }
+    return true;
+}
+
+bool SpentIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block spends nothing
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash())) {
+        return false;
+    }
+
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    if (!GetBlockEntries(block, blockundo, pindex->nHeight, spentIndex)) {
+        return false;
+    }
+    return m_db->UpdateSpentIndex(spentIndex);
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // Only the spending inputs of the disconnected blocks are needed, which don't depend on the undo data
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: failed to read block %s to disconnect from %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+
+        std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+        for (unsigned int i = 1; i < block.vtx.size(); i++) {
+            for (const CTxIn& txin : block.vtx[i]->vin) {
+                spentIndex.push_back(std::make_pair(CSpentIndexKey(txin.prevout.hash, txin.prevout.n), CSpentIndexValue()));
+            }
+        }
+        if (!m_db->UpdateSpentIndex(spentIndex)) {
+            return error("%s: failed to disconnect block %s from %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool SpentIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_db->Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINFOINDEX_H
+#define BITCOIN_INDEX_SPENTINFOINDEX_H
+
+#include "index/base.h"
+#include "spentindex.h"
+
+#include <memory>
+
+/**
+ * SpentIndex records the transaction input that spent each output, with the amount and address of the output
+ * (-spentindex). It is kept on its own database under indexes/spentindex.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    /// Override base class init to migrate the entries older versions kept in the block tree DB.
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    virtual ~SpentIndex() override;
+
+    /// Erase the entries older versions kept in the block tree DB, for when the index is disabled.
+    static bool EraseLegacyData();
+
+    /// Look up the input spending an output. Returns false if the output isn't spent in the indexed chain.
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+};
+
+/// The global spent index, used by getspentinfo and the verbose transaction RPCs. May be null.
+extern std::unique_ptr<SpentIndex> g_spentindex;
+
+#endif // BITCOIN_INDEX_SPENTINFOINDEX_H
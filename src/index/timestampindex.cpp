@@ -0,0 +1,94 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/timestampindex.h"
+
+#include "chain.h"
+#include "spentindex.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/thread.hpp>
+
+static const char DB_TIMESTAMPINDEX = 's';
+
+std::unique_ptr<TimestampIndex> g_timestampindex;
+
+/** Access to the timestamp index database (indexes/timestampindex/) */
+class TimestampIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+TimestampIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "timestampindex", n_cache_size, f_memory, f_wipe)
+{}
+
+TimestampIndex::TimestampIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(new TimestampIndex::DB(n_cache_size, f_memory, f_wipe))
+{}
+
+TimestampIndex::~TimestampIndex() {}
+
+bool TimestampIndex::Init()
+{
+    LOCK(cs_main);
+    if (!MigrateLegacyData(*pblocktree, m_db.get(), "timestampindex", {DB_TIMESTAMPINDEX}, chainActive.GetLocator())) {
+        return false;
+    }
+    return BaseIndex::Init();
+}
+
+bool TimestampIndex::EraseLegacyData()
+{
+    LOCK(cs_main);
+    return MigrateLegacyData(*pblocktree, nullptr, "timestampindex", {DB_TIMESTAMPINDEX}, chainActive.GetLocator());
+}
+
+BaseIndex::DB& TimestampIndex::GetDB() const { return *m_db; }
+
+bool TimestampIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CDBBatch batch(*m_db);
+    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())), 0);
+    return m_db->WriteBatch(batch);
+}
+
+bool TimestampIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // The entries are known from the block index alone, so blocks leaving the chain are dropped from the results
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        batch.Erase(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())));
+    }
+    if (!m_db->WriteBatch(batch)) {
+        return error("%s: failed to disconnect blocks from %s", __func__, GetName());
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool TimestampIndex::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CTimestampIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
+            hashes.push_back(key.second.blockHash);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
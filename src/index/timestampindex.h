@@ -0,0 +1,51 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TIMESTAMPINDEX_H
+#define BITCOIN_INDEX_TIMESTAMPINDEX_H
+
+#include "index/base.h"
+
+#include <memory>
+
+/**
+ * TimestampIndex records the hashes of the blocks in the active chain by block time (-timestampindex). It is kept
+ * on its own database under indexes/timestampindex.
+ */
+class TimestampIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    /// Override base class init to migrate the entries older versions kept in the block tree DB.
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "timestampindex"; }
+
+public:
+    explicit TimestampIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    virtual ~TimestampIndex() override;
+
+    /// Erase the entries older versions kept in the block tree DB, for when the index is disabled.
+    static bool EraseLegacyData();
+
+    /// Get the hashes of the blocks with a time in [low, high], ordered by time.
+    bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) const;
+};
+
+/// The global timestamp index, used by getblockhashes. May be null.
+extern std::unique_ptr<TimestampIndex> g_timestampindex;
+
+#endif // BITCOIN_INDEX_TIMESTAMPINDEX_H
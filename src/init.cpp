@@ -14,6 +14,7 @@
 #include "addrman.h"
 #include "amount.h"
 #include "base58.h"
+#include "blockfilter.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -22,6 +23,13 @@
 #include "fs.h"
 #include "httpserver.h"
 #include "httprpc.h"
+#include "index/addressindex.h"
+#include "index/blockfilterindex.h"
+#include "index/coinstatsindex.h"
+#include "index/spentinfoindex.h"
+#include "index/timestampindex.h"
+#include "index/txindex.h"
+#include "kawpow_context.h"
 #include "key.h"
 #include "validation.h"
 #include "miner.h"
@@ -196,6 +204,8 @@ public:
 static CCoinsViewErrorCatcher *pcoinscatcher = nullptr;
 static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
+static std::set<BlockFilterType> g_enabled_filter_types;
+
 void Interrupt(boost::thread_group& threadGroup)
 {
     InterruptHTTPServer();
@@ -206,6 +216,12 @@ void Interrupt(boost::thread_group& threadGroup)
     llmq::InterruptLLMQSystem();
     if (g_connman)
         g_connman->Interrupt();
+    if (g_txindex) g_txindex->Interrupt();
+    if (g_addressindex) g_addressindex->Interrupt();
+    if (g_spentindex) g_spentindex->Interrupt();
+    if (g_timestampindex) g_timestampindex->Interrupt();
+    if (g_coin_stats_index) g_coin_stats_index->Interrupt();
+    ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
     threadGroup.interrupt_all();
 }
 
@@ -253,6 +269,8 @@ void PrepareShutdown()
     if(g_connman) g_connman->Stop();
     peerLogic.reset();
     g_connman.reset();
+    StopHeaderCheckThreads();
+    GetKAWPOWContextManager().Stop();
 
     if (!fLiteMode && !fRPCInWarmup) {
         // STORE DATA CACHES INTO SERIALIZED DAT FILES
@@ -297,6 +315,29 @@ void PrepareShutdown()
     // up with our current chain to avoid any strange pruning edge cases and make
     // next startup faster by avoiding rescan.
 
+    if (g_txindex) {
+        g_txindex->Stop();
+        g_txindex.reset();
+    }
+    if (g_addressindex) {
+        g_addressindex->Stop();
+        g_addressindex.reset();
+    }
+    if (g_spentindex) {
+        g_spentindex->Stop();
+        g_spentindex.reset();
+    }
+    if (g_timestampindex) {
+        g_timestampindex->Stop();
+        g_timestampindex.reset();
+    }
+    if (g_coin_stats_index) {
+        g_coin_stats_index->Stop();
+        g_coin_stats_index.reset();
+    }
+    ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
+    DestroyAllBlockFilterIndexes();
+
     {
         LOCK(cs_main);
         if (pcoinsTip != nullptr) {
@@ -342,6 +383,9 @@ void PrepareShutdown()
         delete passetsVerifierCache;
         passetsVerifierCache = nullptr;
 
+        delete passetsCompiledVerifierCache;
+        passetsCompiledVerifierCache = nullptr;
+
         delete passetsQualifierCache;
         passetsQualifierCache = nullptr;
 
@@ -540,11 +584,14 @@ std::string HelpMessage(HelpMessageMode mode)
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
-    strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call, built in the background (default: %u)"), DEFAULT_TXINDEX));
 
-    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
-    strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
-    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
+    strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses, built in the background (default: %u)"), DEFAULT_ADDRESSINDEX));
+    strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps, built in the background (default: %u)"), DEFAULT_TIMESTAMPINDEX));
+    strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint, built in the background (default: %u)"), DEFAULT_SPENTINDEX));
+    strUsage += HelpMessageOpt("-blockfilterindex=<type>", strprintf(_("Maintain an index of compact filters by block, built in the background (default: %s, values: %s)."), DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
+            " " + _("If <type> is not supplied or if <type> = 1, indexes for all known types are enabled."));
+    strUsage += HelpMessageOpt("-coinstatsindex", strprintf(_("Maintain UTXO set statistics after each block, used by the gettxoutsetinfo rpc call, built in the background (default: %u)"), DEFAULT_COINSTATSINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info)"));
@@ -568,6 +615,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
     strUsage += HelpMessageOpt("-peerbloomfilters", strprintf(_("Support filtering of blocks and transaction with bloom filters (default: %u)"), DEFAULT_PEERBLOOMFILTERS));
+    strUsage += HelpMessageOpt("-peerblockfilters", strprintf(_("Serve compact block filters to peers per BIP 157 (default: %u)"), DEFAULT_PEERBLOCKFILTERS));
     strUsage += HelpMessageOpt("-port=<port>", strprintf(_("Listen for connections on <port> (default: %u or testnet: %u)"), defaultChainParams->GetDefaultPort(), testnetChainParams->GetDefaultPort()));
     strUsage += HelpMessageOpt("-proxy=<ip:port>", _("Connect through SOCKS5 proxy"));
     strUsage += HelpMessageOpt("-proxyrandomize", strprintf(_("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)"), DEFAULT_PROXYRANDOMIZE));
@@ -628,6 +676,8 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT));
         strUsage += HelpMessageOpt("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT));
         strUsage += HelpMessageOpt("-vbparams=<deployment>:<start>:<end>(:<window>:<threshold>)", "Use given start/end times for specified version bits deployment (regtest-only). Specifying window and threshold is optional.");
+        strUsage += HelpMessageOpt("-dmnsnapshotperiod=<n>", strprintf("Write the full smartnode list to disk every <n> blocks, lower values speed up queries of older lists at the cost of disk space (default: %u)", DEFAULT_DMN_SNAPSHOT_PERIOD));
+        strUsage += HelpMessageOpt("-dmnlistcache=<n>", strprintf("Keep up to <n> smartnode lists of older blocks in memory (default: %u)", DEFAULT_DMN_LIST_CACHE));
         strUsage += HelpMessageOpt("-watchquorums=<n>", strprintf("Watch and validate quorum communication (default: %u)", llmq::DEFAULT_WATCH_QUORUMS));
     }
     strUsage += HelpMessageOpt("-debug=<category>", strprintf(_("Output debugging information (default: %u, supplying <category> is optional)"), 0) + ". " +
@@ -641,6 +691,8 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
     {
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
+        strUsage += HelpMessageOpt("-lockprofile", strprintf("Record how long every LOCK() site waits for and holds its mutex, see getlockprofile (default: %u)", DEFAULT_LOCK_PROFILE));
+        strUsage += HelpMessageOpt("-lockprofileinterval=<n>", strprintf("With -lockprofile, log the %u lock sites with the longest wait every <n> seconds, 0 to disable (default: %u)", LOCK_PROFILE_LOG_SITES, DEFAULT_LOCK_PROFILE_INTERVAL));
         strUsage += HelpMessageOpt("-logthreadnames", strprintf("Add thread names to debug messages (default: %u)", DEFAULT_LOGTHREADNAMES));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
@@ -709,9 +761,13 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-rpcport=<port>", strprintf(_("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)"), defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort()));
     strUsage += HelpMessageOpt("-rpcallowip=<ip>", _("Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
     strUsage += HelpMessageOpt("-rpcthreads=<n>", strprintf(_("Set the number of threads to service RPC calls (default: %d)"), DEFAULT_HTTP_THREADS));
+    strUsage += HelpMessageOpt("-rpcpriority=<method>:<high|normal|low>", _("Queue calls of an RPC method or REST path prefix in the given priority lane. Idle RPC threads serve higher lanes first and at most all but one thread run low priority calls. This option can be specified multiple times"));
+    strUsage += HelpMessageOpt("-rpcmetrics", strprintf(_("Serve the RPC call statistics of getrpcstats in the Prometheus text format at /metrics on the RPC port, using the RPC credentials (default: %u)"), DEFAULT_RPC_METRICS));
+    strUsage += HelpMessageOpt("-rpcmethodthreads=<method>:<n>", _("Run at most <n> calls of an RPC method or REST path prefix at the same time, 0 for no limit. This option can be specified multiple times"));
     if (showDebug) {
-        strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
+        strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of each priority lane of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
         strUsage += HelpMessageOpt("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT));
+        strUsage += HelpMessageOpt("-rpcstatslocktime", strprintf("Measure how long RPC calls hold the main lock for getrpcstats, at the cost of timing every lock of it (default: %u)", DEFAULT_RPC_STATS_LOCK_TIME));
     }
 
     return strUsage;
@@ -1056,17 +1112,6 @@ void InitParameterInteraction()
     }
 #endif // ENABLE_WALLET
 
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        gArgs.ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
-    }
 }
 
 static std::string ResolveErrMsg(const char * const optname, const std::string& strBind)
@@ -1164,10 +1209,37 @@ bool AppInitParameterInteraction()
 
     // also see: InitParameterInteraction()
 
+    // The indexes are built by their own threads, so they can be switched on and off between restarts
+    fTxIndex = gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX);
+    fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+    fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+
+    // parse and validate enabled filter types
+    std::string blockfilterindex_value = gArgs.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
+    if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
+        g_enabled_filter_types.insert(AllBlockFilterTypes().begin(), AllBlockFilterTypes().end());
+    } else if (blockfilterindex_value != "0") {
+        const std::vector<std::string> names = gArgs.GetArgs("-blockfilterindex");
+        for (const auto& name : names) {
+            BlockFilterType filter_type;
+            if (!BlockFilterTypeByName(name, filter_type)) {
+                return InitError(strprintf(_("Unknown -blockfilterindex value %s."), name));
+            }
+            g_enabled_filter_types.insert(filter_type);
+        }
+    }
+
     // if using block pruning, then disallow txindex
     if (gArgs.GetArg("-prune", 0)) {
-        if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
+        if (fTxIndex)
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (fAddressIndex || fSpentIndex || fTimestampIndex)
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
+        if (!g_enabled_filter_types.empty())
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+        if (gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX))
+            return InitError(_("Prune mode is incompatible with -coinstatsindex."));
     }
 
     if (gArgs.IsArgSet("-devnet")) {
@@ -1389,6 +1461,14 @@ bool AppInitParameterInteraction()
     if (gArgs.GetBoolArg("-peerbloomfilters", DEFAULT_PEERBLOOMFILTERS))
         nLocalServices = ServiceFlags(nLocalServices | NODE_BLOOM);
 
+    // Signal NODE_COMPACT_FILTERS if peerblockfilters and basic filters index are both enabled.
+    if (gArgs.GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS)) {
+        if (g_enabled_filter_types.count(BlockFilterType::BASIC) != 1) {
+            return InitError(_("Cannot set -peerblockfilters without -blockfilterindex."));
+        }
+        nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
+    }
+
     nMaxTipAge = gArgs.GetArg("-maxtipage", DEFAULT_MAX_TIP_AGE);
 
     if (gArgs.IsArgSet("-vbparams")) {
@@ -1546,6 +1626,8 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x16r_algo = X16RBatchAutoDetect();
+    LogPrintf("Using the '%s' X16R batch implementation\n", x16r_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1603,6 +1685,8 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
     }
+    // Header proof of work is checked on the same number of threads as scripts
+    StartHeaderCheckThreads(nScriptCheckThreads);
 
     std::vector<std::string> vSporkAddresses;
     if (gArgs.IsArgSet("-sporkaddr")) {
@@ -1628,6 +1712,13 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         }
     }
 
+    if (gArgs.GetBoolArg("-lockprofile", DEFAULT_LOCK_PROFILE)) {
+        EnableLockProfile(true);
+        int64_t nLockProfileInterval = gArgs.GetArg("-lockprofileinterval", DEFAULT_LOCK_PROFILE_INTERVAL);
+        if (nLockProfileInterval > 0)
+            scheduler.scheduleEvery(boost::bind(&LogLockProfile, LOCK_PROFILE_LOG_SITES), nLockProfileInterval * 1000);
+    }
+
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
@@ -1814,8 +1905,24 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
     int64_t nBlockTreeDBCache = nTotalCache / 8;
-    nBlockTreeDBCache = std::min(nBlockTreeDBCache, (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
+    nBlockTreeDBCache = std::min(nBlockTreeDBCache, nMaxBlockDBCache << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int64_t nTxIndexCache = std::min(nTotalCache / 8, fTxIndex ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= nTxIndexCache;
+    int64_t nAddressIndexCache = 0;
+    size_t nAddressIndexes = (size_t)fAddressIndex + (size_t)fSpentIndex + (size_t)fTimestampIndex;
+    if (nAddressIndexes > 0) {
+        int64_t nMaxCache = std::min(nTotalCache / 8, nMaxAddressIndexCache << 20);
+        nAddressIndexCache = nMaxCache / nAddressIndexes;
+        nTotalCache -= nAddressIndexCache * nAddressIndexes;
+    }
+    int64_t nFilterIndexCache = 0;
+    if (!g_enabled_filter_types.empty()) {
+        size_t nIndexes = g_enabled_filter_types.size();
+        int64_t nMaxCache = std::min(nTotalCache / 8, nMaxFilterIndexCache << 20);
+        nFilterIndexCache = nMaxCache / nIndexes;
+        nTotalCache -= nFilterIndexCache * nIndexes;
+    }
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1824,6 +1931,16 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    if (fTxIndex) {
+        LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (nAddressIndexes > 0) {
+        LogPrintf("* Using %.1fMiB for each address, spent and timestamp index database\n", nAddressIndexCache * (1.0 / 1024 / 1024));
+    }
+    for (BlockFilterType filter_type : g_enabled_filter_types) {
+        LogPrintf("* Using %.1fMiB for %s block filter index database\n",
+                  nFilterIndexCache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1850,7 +1967,9 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                 delete evoDb;
 
                 evoDb = new CEvoDB(nEvoDbCache, false, fReset || fReindexChainState);
-                deterministicMNManager = new CDeterministicMNManager(*evoDb);
+                deterministicMNManager = new CDeterministicMNManager(*evoDb,
+                    std::max<int64_t>(gArgs.GetArg("-dmnsnapshotperiod", DEFAULT_DMN_SNAPSHOT_PERIOD), 1),
+                    std::max<int64_t>(gArgs.GetArg("-dmnlistcache", DEFAULT_DMN_LIST_CACHE), 1));
                 pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReset);
                 llmq::InitLLMQSystem(*evoDb, &scheduler, false, fReset || fReindexChainState);
 
@@ -1875,6 +1994,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     // Restricted assets
                     delete prestricteddb;
                     delete passetsVerifierCache;
+                    delete passetsCompiledVerifierCache;
                     delete passetsQualifierCache;
                     delete passetsRestrictionCache;
                     delete passetsGlobalRestrictionCache;
@@ -1903,6 +2023,8 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     prestricteddb = new CRestrictedDB(nBlockTreeDBCache, false, fReset);
                     passetsVerifierCache = new CLRUCache<std::string, CNullAssetTxVerifierString>(
                             MAX_CACHE_ASSETS_SIZE);
+                    passetsCompiledVerifierCache = new CLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>>(
+                            MAX_CACHE_ASSETS_SIZE);
                     passetsQualifierCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
                     passetsRestrictionCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
                     passetsGlobalRestrictionCache = new CLRUCache<std::string, int8_t>(MAX_CACHE_ASSETS_SIZE);
@@ -1946,8 +2068,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
                 if (fRequestShutdown) break;
 
-                // LoadBlockIndex will load fTxIndex from the db, or set it if
-                // we're reindexing. It will also load fHavePruned if we've
+                // LoadBlockIndex will load fHavePruned if we've
                 // ever removed a block file from disk.
                 // Note that it also sets fReindex based on the disk flag!
                 // From here on out fReindex and fReset mean something different!
@@ -1961,30 +2082,6 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                 if (!mapBlockIndex.empty() && mapBlockIndex.count(chainparams.GetConsensus().hashGenesisBlock) == 0)
                     return InitError(_("Incorrect or no genesis block found. Wrong datadir for network?"));
 
-                // Check for changed -txindex state
-                if (fTxIndex != gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -txindex");
-                    break;
-                }
-
-                // Check for changed -addressindex state
-                if (fAddressIndex != gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
-                    break;
-                }
-
-                // Check for changed -timestampindex state
-                if (fTimestampIndex != gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -timestampindex");
-                    break;
-                }
-
-                // Check for changed -spentindex state
-                if (fSpentIndex != gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX)) {
-                    strLoadError = _("You need to rebuild the database using -reindex to change -spentindex");
-                    break;
-                }
-
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -2119,6 +2216,40 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         ::feeEstimator.Read(est_filein);
     fFeeEstimatesInitialized = true;
 
+    // ********************************************************* Step 7c: start indexers
+    if (fTxIndex) {
+        g_txindex = std::unique_ptr<TxIndex>(new TxIndex(nTxIndexCache, false, fReindex));
+        g_txindex->Start();
+    }
+    if (fAddressIndex) {
+        g_addressindex = std::unique_ptr<AddressIndex>(new AddressIndex(nAddressIndexCache, false, fReindex));
+        g_addressindex->Start();
+    }
+    if (fSpentIndex) {
+        g_spentindex = std::unique_ptr<SpentIndex>(new SpentIndex(nAddressIndexCache, false, fReindex));
+        g_spentindex->Start();
+    }
+    if (fTimestampIndex) {
+        g_timestampindex = std::unique_ptr<TimestampIndex>(new TimestampIndex(nAddressIndexCache, false, fReindex));
+        g_timestampindex->Start();
+    }
+    // Drop what older versions kept of the disabled indexes in the block tree DB. If this is interrupted, the
+    // rest goes on the next start.
+    if (!fAddressIndex) AddressIndex::EraseLegacyData();
+    if (!fSpentIndex) SpentIndex::EraseLegacyData();
+    if (!fTimestampIndex) TimestampIndex::EraseLegacyData();
+
+    for (const auto& filter_type : g_enabled_filter_types) {
+        InitBlockFilterIndex(filter_type, nFilterIndexCache, false, fReindex);
+        GetBlockFilterIndex(filter_type)->Start();
+    }
+
+    if (gArgs.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
+        // The statistics are small and read once per block, so the index goes without a cache of its own
+        g_coin_stats_index = std::unique_ptr<CoinStatsIndex>(new CoinStatsIndex(0, false, fReindex || fReindexChainState));
+        g_coin_stats_index->Start();
+    }
+
     // ********************************************************* Step 8: load wallet
 #ifdef ENABLE_WALLET
     if (!CWallet::InitLoadWallet())
@@ -2328,6 +2459,14 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         vImportFiles.push_back(strFile);
     }
 
+    // Build the KAWPOW context for the next block in the background so neither the miner nor
+    // the first block validated after startup has to wait for it
+    {
+        LOCK(cs_main);
+        if (chainActive.Tip() && chainActive.Tip()->nTime >= 1651444217)
+            GetKAWPOWContextManager().SetTipHeight(chainActive.Height());
+    }
+
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
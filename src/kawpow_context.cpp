@@ -0,0 +1,152 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "kawpow_context.h"
+
+#include <crypto/ethash/include/ethash/progpow.hpp>
+
+#include <chrono>
+#include <stdexcept>
+
+CKAWPOWContextManager::~CKAWPOWContextManager()
+{
+    Stop();
+}
+
+CKAWPOWContextManager::ContextPtr CKAWPOWContextManager::Build(int epoch_number, int64_t& nMicros)
+{
+    const auto start = std::chrono::steady_clock::now();
+    ethash::epoch_context_ptr context = ethash::create_epoch_context(epoch_number);
+    nMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if (!context)
+        return nullptr;
+    return ContextPtr(context.release(), ethash_destroy_epoch_context);
+}
+
+void CKAWPOWContextManager::Insert(int epoch_number, const ContextPtr& context, int64_t nMicros)
+{
+    contexts[epoch_number] = Entry{context, ++nUseCounter};
+    nBuilds++;
+    nLastBuildMicros = nMicros;
+    nTotalBuildMicros += nMicros;
+
+    while (contexts.size() > MAX_CONTEXTS) {
+        auto oldest = contexts.begin();
+        for (auto it = contexts.begin(); it != contexts.end(); ++it) {
+            if (it->second.nLastUse < oldest->second.nLastUse)
+                oldest = it;
+        }
+        contexts.erase(oldest);
+    }
+}
+
+void CKAWPOWContextManager::PrefetchLocked(int epoch_number)
+{
+    if (fStopped || fPrefetchRunning || contexts.count(epoch_number) || building.count(epoch_number))
+        return;
+
+    // The previous prefetch has finished, reap it before starting the next one
+    if (prefetchThread.joinable())
+        prefetchThread.join();
+
+    building.insert(epoch_number);
+    fPrefetchRunning = true;
+    prefetchThread = std::thread([this, epoch_number] {
+        int64_t nMicros;
+        ContextPtr context = Build(epoch_number, nMicros);
+
+        std::lock_guard<std::mutex> lock(cs);
+        building.erase(epoch_number);
+        if (context)
+            Insert(epoch_number, context, nMicros);
+        fPrefetchRunning = false;
+        cond.notify_all();
+    });
+}
+
+CKAWPOWContextManager::ContextPtr CKAWPOWContextManager::Get(int epoch_number)
+{
+    std::unique_lock<std::mutex> lock(cs);
+
+    bool fWaited = false;
+    while (true) {
+        auto it = contexts.find(epoch_number);
+        if (it != contexts.end()) {
+            it->second.nLastUse = ++nUseCounter;
+            ContextPtr context = it->second.context;
+            if (epoch_number == nCurrentEpoch)
+                PrefetchLocked(epoch_number + 1);
+            return context;
+        }
+        if (!building.count(epoch_number))
+            break;
+        // Someone else (usually the prefetch thread) is already building it
+        if (!fWaited)
+            nStalls++;
+        fWaited = true;
+        cond.wait(lock);
+    }
+
+    if (!fWaited)
+        nStalls++;
+    building.insert(epoch_number);
+    lock.unlock();
+    int64_t nMicros;
+    ContextPtr context = Build(epoch_number, nMicros);
+    lock.lock();
+    building.erase(epoch_number);
+    if (context)
+        Insert(epoch_number, context, nMicros);
+    cond.notify_all();
+
+    if (!context)
+        throw std::runtime_error("Failed to allocate KAWPOW epoch context");
+    if (epoch_number == nCurrentEpoch)
+        PrefetchLocked(epoch_number + 1);
+    return context;
+}
+
+void CKAWPOWContextManager::SetTipHeight(int nHeight)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    nCurrentEpoch = ethash::get_epoch_number(nHeight + 1);
+    if (!contexts.count(nCurrentEpoch))
+        PrefetchLocked(nCurrentEpoch);
+    else
+        PrefetchLocked(nCurrentEpoch + 1);
+}
+
+void CKAWPOWContextManager::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStopped = true;
+    }
+    if (prefetchThread.joinable())
+        prefetchThread.join();
+}
+
+CKAWPOWContextManager::Stats CKAWPOWContextManager::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    Stats stats;
+    stats.nCurrentEpoch = nCurrentEpoch;
+    stats.fNextEpochReady = nCurrentEpoch >= 0 && contexts.count(nCurrentEpoch + 1);
+    stats.fBuilding = !building.empty();
+    stats.nContexts = contexts.size();
+    for (const auto& entry : contexts) {
+        stats.nMemoryUsage += ethash::get_light_cache_size(entry.second.context->light_cache_num_items) + progpow::l1_cache_size;
+    }
+    stats.nBuilds = nBuilds;
+    stats.nLastBuildMicros = nLastBuildMicros;
+    stats.nTotalBuildMicros = nTotalBuildMicros;
+    stats.nStalls = nStalls;
+    return stats;
+}
+
+CKAWPOWContextManager& GetKAWPOWContextManager()
+{
+    static CKAWPOWContextManager manager;
+    return manager;
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef RAVENCASH_KAWPOW_CONTEXT_H
+#define RAVENCASH_KAWPOW_CONTEXT_H
+
+#include <crypto/ethash/include/ethash/ethash.hpp>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <thread>
+
+/**
+ * Owns the KAWPOW (ethash light) epoch contexts shared by validation, the miner and the
+ * mining RPCs. Building a context takes a noticeable amount of time, so the epoch of the block
+ * after the active tip and the epoch following it are built on a background thread and are
+ * ready by the time the chain crosses the boundary. At most MAX_CONTEXTS contexts are cached (least recently
+ * used first out); callers holding a context keep it alive through the shared_ptr.
+ */
+class CKAWPOWContextManager
+{
+public:
+    typedef std::shared_ptr<const ethash::epoch_context> ContextPtr;
+
+    /** Enough for the tip epoch, its successor and older blocks still being validated */
+    static const size_t MAX_CONTEXTS = 4;
+
+    struct Stats {
+        int nCurrentEpoch{-1};
+        bool fNextEpochReady{false};
+        bool fBuilding{false};
+        size_t nContexts{0};
+        size_t nMemoryUsage{0};
+        uint64_t nBuilds{0};
+        int64_t nLastBuildMicros{0};
+        int64_t nTotalBuildMicros{0};
+        /** Requests that had to wait for a context to be built */
+        uint64_t nStalls{0};
+    };
+
+    CKAWPOWContextManager() = default;
+    ~CKAWPOWContextManager();
+
+    /** Return the context for epoch_number, building it on this thread if nobody else is. */
+    ContextPtr Get(int epoch_number);
+    /**
+     * Tell the manager about a new active tip. The epoch of the block after it becomes the
+     * current epoch; it is built in the background if missing, otherwise its successor is.
+     */
+    void SetTipHeight(int nHeight);
+    /** Wait for a background build to finish and stop prefetching. */
+    void Stop();
+
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        ContextPtr context;
+        uint64_t nLastUse;
+    };
+
+    static ContextPtr Build(int epoch_number, int64_t& nMicros);
+    /** Add a freshly built context and evict the least recently used ones. cs must be held. */
+    void Insert(int epoch_number, const ContextPtr& context, int64_t nMicros);
+    /** Start a background build of epoch_number if possible. cs must be held. */
+    void PrefetchLocked(int epoch_number);
+
+    mutable std::mutex cs;
+    std::condition_variable cond;
+    std::map<int, Entry> contexts;
+    /** Epochs currently being built, by any thread */
+    std::set<int> building;
+    std::thread prefetchThread;
+    bool fPrefetchRunning{false};
+    bool fStopped{false};
+    uint64_t nUseCounter{0};
+    /** Epoch of the block after the active tip, only it and its successor are prefetched */
+    int nCurrentEpoch{-1};
+    uint64_t nBuilds{0};
+    uint64_t nStalls{0};
+    int64_t nLastBuildMicros{0};
+    int64_t nTotalBuildMicros{0};
+};
+
+/** The process-wide context manager. */
+CKAWPOWContextManager& GetKAWPOWContextManager();
+
+#endif // RAVENCASH_KAWPOW_CONTEXT_H
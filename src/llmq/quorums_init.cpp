@@ -34,8 +34,8 @@ void InitLLMQSystem(CEvoDB& evoDb, CScheduler* scheduler, bool unitTests, bool f
     quorumBlockProcessor = new CQuorumBlockProcessor(evoDb);
     quorumDKGSessionManager = new CDKGSessionManager(*llmqDb, *blsWorker);
     quorumManager = new CQuorumManager(evoDb, *blsWorker, *quorumDKGSessionManager);
-    quorumSigSharesManager = new CSigSharesManager();
-    quorumSigningManager = new CSigningManager(*llmqDb, unitTests);
+    quorumSigSharesManager = new CSigSharesManager(*blsWorker);
+    quorumSigningManager = new CSigningManager(*llmqDb, *blsWorker, unitTests);
     chainLocksHandler = new CChainLocksHandler(scheduler);
     quorumInstantSendManager = new CInstantSendManager(*llmqDb);
 }
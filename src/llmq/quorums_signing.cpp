@@ -440,8 +440,9 @@ void CRecoveredSigsDb::CleanupOldVotes(int64_t maxAge)
 
 //////////////////
 
-CSigningManager::CSigningManager(CDBWrapper& llmqDb, bool fMemory) :
-    db(llmqDb)
+CSigningManager::CSigningManager(CDBWrapper& llmqDb, CBLSWorker& _blsWorker, bool fMemory) :
+    db(llmqDb),
+    blsWorker(_blsWorker)
 {
 }
 
@@ -633,7 +634,7 @@ bool CSigningManager::ProcessPendingRecoveredSigs(CConnman& connman)
     }
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    batchVerifier.VerifyParallel(blsWorker, MIN_VERIFY_SUB_BATCH_SIZE);
     verifyTimer.stop();
 
     LogPrint(BCLog::LLMQ, "CSigningManager::%s -- verified recovered sig(s). count=%d, vt=%d, nodes=%d\n", __func__, verifyCount, verifyTimer.count(), recSigsByNode.size());
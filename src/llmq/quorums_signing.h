@@ -120,10 +120,14 @@ class CSigningManager
     // which are not 100% at the chain tip.
     static const int SIGN_HEIGHT_OFFSET = 8;
 
+    // pending recovered sigs are verified on the BLS worker threads once there are this many per thread
+    static const size_t MIN_VERIFY_SUB_BATCH_SIZE = 8;
+
 private:
     CCriticalSection cs;
 
     CRecoveredSigsDb db;
+    CBLSWorker& blsWorker;
 
     // Incoming and not verified yet
     std::unordered_map<NodeId, std::list<CRecoveredSig>> pendingRecoveredSigs;
@@ -137,7 +141,7 @@ private:
     std::vector<CRecoveredSigsListener*> recoveredSigsListeners;
 
 public:
-    CSigningManager(CDBWrapper& llmqDb, bool fMemory);
+    CSigningManager(CDBWrapper& llmqDb, CBLSWorker& _blsWorker, bool fMemory);
 
     bool AlreadyHave(const CInv& inv);
     bool GetRecoveredSigForGetData(const uint256& hash, CRecoveredSig& ret);
@@ -339,10 +339,14 @@ class CSigSharesManager : public CRecoveredSigsListener
     const size_t MAX_MSGS_CNT_QSIGSHARESINV = 200;
     // 400 is the maximum quorum size, so this is also the maximum number of sigs we need to support
     const size_t MAX_MSGS_TOTAL_BATCHED_SIGS = 400;
+    // pending sig shares are verified on the BLS worker threads once there are this many per thread
+    static const size_t MIN_VERIFY_SUB_BATCH_SIZE = 16;
 
 private:
     CCriticalSection cs;
 
+    CBLSWorker& blsWorker;
+
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
@@ -364,7 +368,7 @@ private:
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
 public:
-    CSigSharesManager();
+    CSigSharesManager(CBLSWorker& _blsWorker);
     ~CSigSharesManager();
 
     void StartWorkerThread();
@@ -651,14 +651,27 @@ void static RavenCashMiner(const CChainParams& chainparams)
             //
             int64_t nStart = GetTime();
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
+            // The X16R algorithm order only depends on the parent, work it out once per template
+            const HashX16RContext x16rContext(pblock->hashPrevBlock);
             while (true)
             {
 
                 uint256 hash;
                 uint256 mix_hash;
+                // X16R nonces are hashed X16R_BATCH_LANES at a time and then checked one by one
+                uint256 x16rHashes[X16R_BATCH_LANES];
+                int nX16RLane = X16R_BATCH_LANES;
                 while (true)
                 {  
-                    hash = pblock->GetHashFull(mix_hash);
+                    if (pblock->nTime < 1651444217) {
+                        if (nX16RLane == X16R_BATCH_LANES) {
+                            pblock->GetX16RHashBatch(x16rContext, x16rHashes);
+                            nX16RLane = 0;
+                        }
+                        hash = x16rHashes[nX16RLane++];
+                    } else {
+                        hash = pblock->GetHashFull(mix_hash);
+                    }
                     if (UintToArith256(hash) <= hashTarget)
                     {
                         pblock->mix_hash = mix_hash;
@@ -33,6 +33,26 @@ uint256 CBlockHeader::GetX16RHash() const
     return HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock);
 }
 
+uint256 CBlockHeader::GetX16RHash(const HashX16RContext& context) const
+{
+    assert(context.GetPrevBlockHash() == hashPrevBlock);
+    return context.Hash(BEGIN(nVersion), END(nNonce));
+}
+
+void CBlockHeader::GetX16RHashBatch(const HashX16RContext& context, uint256* hashes) const
+{
+    assert(context.GetPrevBlockHash() == hashPrevBlock);
+    const size_t len = END(nNonce) - BEGIN(nVersion);
+    unsigned char input[X16R_BATCH_LANES * 80];
+    assert(len <= 80);
+    for (int i = 0; i < X16R_BATCH_LANES; i++) {
+        const uint32_t nLaneNonce = nNonce + i;
+        memcpy(input + i * len, BEGIN(nVersion), len);
+        memcpy(input + (i + 1) * len - sizeof(nNonce), &nLaneNonce, sizeof(nNonce));
+    }
+    context.HashBatch(input, len, hashes);
+}
+
 /**
  * @brief This takes a block header, removes the nNonce64 and the mixHash. Then performs a serialized hash of it SHA256D.
  * This will be used as the input to the KAAAWWWPOW hashing function
@@ -12,6 +12,7 @@
 #include <unordered_lru_cache.h>
 #include <util.h>
 
+class HashX16RContext;
 
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
@@ -84,6 +85,10 @@ public:
     /// Compute the Header Hash from the block
     uint256 GetHash() const;
     uint256 GetX16RHash() const;
+    /// X16R hash using a precomputed algorithm order, the context must be for hashPrevBlock
+    uint256 GetX16RHash(const HashX16RContext& context) const;
+    /// X16R hashes of this header with nonces nNonce .. nNonce + X16R_BATCH_LANES - 1, written to hashes
+    void GetX16RHashBatch(const HashX16RContext& context, uint256* hashes) const;
 
     /// Caching lookup/computation of POW hash
     //uint256 GetPOWHash(bool readCache = true) const;
@@ -3,6 +3,9 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "assets/assets.h"
+#include "assets/assetdb.h"
+#include "base58.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "core_io.h"
@@ -10,7 +13,9 @@
 #include "primitives/transaction.h"
 #include "validation.h"
 #include "httpserver.h"
+#include "index/addressindex.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -23,6 +28,8 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t DEFAULT_REST_PAGE_SIZE = 1000; //entries returned by the paged endpoints unless ?count= is given
+static const size_t MAX_REST_PAGE_SIZE = 50000;
 
 enum RetFormat {
     RF_UNDEF,
@@ -67,6 +74,17 @@ static bool RESTERR(HTTPRequest* req, enum HTTPStatusCode status, std::string me
     return false;
 }
 
+/** Sink for a JSONStreamWriter that sends its output as a chunked JSON reply to req */
+static JSONStreamWriter::Sink JSONReplySink(HTTPRequest* req)
+{
+    return [req](const char* data, size_t len) {
+        if (!req->ChunkedReplyStarted()) {
+            req->WriteHeader("Content-Type", "application/json");
+        }
+        req->WriteReplyChunk(data, len);
+    };
+}
+
 static enum RetFormat ParseDataFormat(std::string& param, const std::string& strReq)
 {
     const std::string::size_type pos = strReq.rfind('.');
@@ -113,6 +131,44 @@ static bool ParseHashStr(const std::string& strReq, uint256& v)
     return true;
 }
 
+/** Remove the query string from strURIPart and return its decoded key=value pairs */
+static std::map<std::string, std::string> ParseQueryString(std::string& strURIPart)
+{
+    std::map<std::string, std::string> mapQuery;
+    const std::string::size_type pos = strURIPart.find('?');
+    if (pos == std::string::npos)
+        return mapQuery;
+
+    std::vector<std::string> vPairs;
+    boost::split(vPairs, strURIPart.substr(pos + 1), boost::is_any_of("&"));
+    strURIPart.erase(pos);
+    for (const std::string& strPair : vPairs) {
+        const std::string::size_type posEq = strPair.find('=');
+        if (posEq == std::string::npos)
+            mapQuery[urlDecode(strPair)] = "";
+        else
+            mapQuery[urlDecode(strPair.substr(0, posEq))] = urlDecode(strPair.substr(posEq + 1));
+    }
+    return mapQuery;
+}
+
+/** Read the ?count= and ?after= parameters of the paged endpoints */
+static bool ParsePageParams(const std::map<std::string, std::string>& mapQuery, size_t& nCount, std::string& strAfter)
+{
+    nCount = DEFAULT_REST_PAGE_SIZE;
+    auto it = mapQuery.find("count");
+    if (it != mapQuery.end()) {
+        int32_t n;
+        if (!ParseInt32(it->second, &n) || n < 1 || (size_t)n > MAX_REST_PAGE_SIZE)
+            return false;
+        nCount = n;
+    }
+
+    it = mapQuery.find("after");
+    strAfter = it != mapQuery.end() ? it->second : "";
+    return true;
+}
+
 static bool CheckWarmup(HTTPRequest* req)
 {
     std::string statusmessage;
@@ -209,6 +265,8 @@ static bool rest_block(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
     CBlock block;
+    // the binary and hex formats are the block as it is stored on disk, so it doesn't need to be deserialized
+    std::vector<uint8_t> vBlockData;
     CBlockIndex* pblockindex = nullptr;
     {
         LOCK(cs_main);
@@ -219,33 +277,34 @@ static bool rest_block(HTTPRequest* req,
         if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        if (rf == RF_BINARY || rf == RF_HEX) {
+            if (!ReadRawBlockFromDisk(vBlockData, pblockindex, Params().MessageStart()))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        } else if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryBlock = ssBlock.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, std::string(vBlockData.begin(), vBlockData.end()));
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::string strHex = HexStr(vBlockData.begin(), vBlockData.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        JSONStreamWriter writer(JSONReplySink(req));
+        blockToJSON(block, pblockindex, showTxDetails, writer);
+        writer.WriteRaw("\n");
+        writer.Flush();
+        req->EndChunkedReply();
         return true;
     }
 
@@ -331,11 +390,11 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
     switch (rf) {
     case RF_JSON: {
-        UniValue mempoolObject = mempoolToJSON(true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        JSONStreamWriter writer(JSONReplySink(req));
+        mempoolToJSON(true, writer);
+        writer.WriteRaw("\n");
+        writer.Flush();
+        req->EndChunkedReply();
         return true;
     }
     default: {
@@ -586,6 +645,275 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_asset(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string strNameEncoded;
+    const RetFormat rf = ParseDataFormat(strNameEncoded, strURIPart);
+
+    // Asset names may contain characters such as '#' that have to be percent encoded in the URI
+    const std::string strName = urlDecode(strNameEncoded);
+    if (!IsAssetNameValid(strName))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid asset name: " + strName);
+
+    CDatabasedAssetData assetData;
+    CNullAssetTxVerifierString verifier;
+    bool fHasVerifier = false;
+    {
+        LOCK(cs_main);
+        auto currentActiveAssetCache = GetCurrentAssetCache();
+        if (!currentActiveAssetCache)
+            return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Asset cache isn't available");
+
+        if (!currentActiveAssetCache->GetAssetMetaDataIfExists(strName, assetData.asset, assetData.nHeight, assetData.blockHash))
+            return RESTERR(req, HTTP_NOT_FOUND, strName + " not found");
+
+        fHasVerifier = currentActiveAssetCache->GetAssetVerifierStringIfExists(strName, verifier);
+    }
+
+    // The binary formats are the record as it is stored in the assets database
+    CDataStream ssAsset(SER_NETWORK, PROTOCOL_VERSION);
+    ssAsset << assetData;
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryAsset = ssAsset.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryAsset);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssAsset.begin(), ssAsset.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        const CNewAsset& asset = assetData.asset;
+        UniValue objAsset(UniValue::VOBJ);
+        objAsset.push_back(Pair("name", asset.strName));
+        objAsset.push_back(Pair("amount", ValueFromAmount(asset.nAmount, asset.units)));
+        objAsset.push_back(Pair("units", asset.units));
+        objAsset.push_back(Pair("reissuable", asset.nReissuable));
+        objAsset.push_back(Pair("has_ipfs", asset.nHasIPFS));
+        if (asset.nHasIPFS) {
+            if (asset.strIPFSHash.size() == 32) {
+                objAsset.push_back(Pair("txid", EncodeAssetData(asset.strIPFSHash)));
+            } else {
+                objAsset.push_back(Pair("ipfs_hash", EncodeAssetData(asset.strIPFSHash)));
+            }
+        }
+        if (fHasVerifier)
+            objAsset.push_back(Pair("verifier_string", verifier.verifier_string));
+        objAsset.push_back(Pair("height", assetData.nHeight));
+        objAsset.push_back(Pair("blockhash", assetData.blockHash.GetHex()));
+
+        std::string strJSON = objAsset.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_assetholders(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (!fAssetIndex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Asset holders are only available with -assetindex");
+
+    std::string strPath = strURIPart;
+    const std::map<std::string, std::string> mapQuery = ParseQueryString(strPath);
+    std::string strNameEncoded;
+    const RetFormat rf = ParseDataFormat(strNameEncoded, strPath);
+
+    const std::string strName = urlDecode(strNameEncoded);
+    if (!IsAssetNameValid(strName))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid asset name: " + strName);
+
+    size_t nCount;
+    std::string strAfter;
+    if (!ParsePageParams(mapQuery, nCount, strAfter))
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("count must be between 1 and %u", MAX_REST_PAGE_SIZE));
+
+    // Read one entry more than asked for to know whether there is another page
+    std::vector<std::pair<std::string, CAmount> > vecAddressAmounts;
+    int8_t units = OWNER_UNITS;
+    {
+        LOCK(cs_main);
+        int nTotalEntries = 0;
+        if (!passetsdb->AssetAddressDir(vecAddressAmounts, nTotalEntries, false, strName, nCount + 1, 0, strAfter))
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Couldn't retrieve address asset directory");
+
+        CNewAsset asset;
+        auto currentActiveAssetCache = GetCurrentAssetCache();
+        if (!IsAssetNameAnOwner(strName) && currentActiveAssetCache && currentActiveAssetCache->GetAssetMetaDataIfExists(strName, asset))
+            units = asset.units;
+    }
+    bool fMore = vecAddressAmounts.size() > nCount;
+    if (fMore)
+        vecAddressAmounts.resize(nCount);
+
+    // Address and amount pairs as they are stored in the assets database, followed by fMore.
+    // Pass the last address as ?after= to get the next page.
+    CDataStream ssHolders(SER_NETWORK, PROTOCOL_VERSION);
+    ssHolders << vecAddressAmounts << fMore;
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryHolders = ssHolders.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryHolders);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssHolders.begin(), ssHolders.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        UniValue holders(UniValue::VOBJ);
+        for (const auto& pair : vecAddressAmounts)
+            holders.push_back(Pair(pair.first, ValueFromAmount(pair.second, units)));
+
+        UniValue objHolders(UniValue::VOBJ);
+        objHolders.push_back(Pair("holders", holders));
+        if (fMore)
+            objHolders.push_back(Pair("cursor", vecAddressAmounts.back().first));
+
+        std::string strJSON = objHolders.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_addressutxos(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (!fAddressIndex)
+        return RESTERR(req, HTTP_NOT_FOUND, "Address outputs are only available with -addressindex");
+
+    std::string strPath = strURIPart;
+    const std::map<std::string, std::string> mapQuery = ParseQueryString(strPath);
+    std::string strAddress;
+    const RetFormat rf = ParseDataFormat(strAddress, strPath);
+
+    uint160 hashBytes;
+    int type = 0;
+    if (!CBitcoinAddress(strAddress).GetIndexKey(hashBytes, type))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + strAddress);
+
+    size_t nCount;
+    std::string strAfter;
+    if (!ParsePageParams(mapQuery, nCount, strAfter))
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("count must be between 1 and %u", MAX_REST_PAGE_SIZE));
+
+    // The cursor is the hex serialization of the last key of the previous page
+    CAddressUnspentKey keyAfter;
+    if (!strAfter.empty()) {
+        if (!IsHex(strAfter))
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor");
+        std::vector<unsigned char> vchKey = ParseHex(strAfter);
+        CDataStream ssKey(vchKey, SER_DISK, CLIENT_VERSION);
+        try {
+            ssKey >> keyAfter;
+        } catch (const std::exception&) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor");
+        }
+        if (!ssKey.empty() || keyAfter.hashBytes != hashBytes || (int)keyAfter.type != type)
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor");
+    }
+
+    // The index would miss the outputs of blocks it hasn't caught up with yet
+    if (g_addressindex && !g_addressindex->BlockUntilSyncedToCurrentChain())
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Addresses are still in the process of being indexed");
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vecUnspent;
+    bool fMore = false;
+    if (!GetAddressUnspent(hashBytes, type, strAfter.empty() ? nullptr : &keyAfter, nCount, vecUnspent, fMore))
+        return RESTERR(req, HTTP_NOT_FOUND, "No information available for address " + strAddress);
+
+    // Index keys and values as they are stored in the address index, followed by fMore.
+    // Pass the hex of the last key as ?after= to get the next page.
+    CDataStream ssUnspent(SER_NETWORK, PROTOCOL_VERSION);
+    ssUnspent << vecUnspent << fMore;
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryUnspent = ssUnspent.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryUnspent);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssUnspent.begin(), ssUnspent.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        UniValue utxos(UniValue::VARR);
+        for (const auto& entry : vecUnspent) {
+            UniValue output(UniValue::VOBJ);
+            output.push_back(Pair("address", strAddress));
+            output.push_back(Pair("assetName", entry.first.asset));
+            output.push_back(Pair("txid", entry.first.txhash.GetHex()));
+            output.push_back(Pair("outputIndex", (int)entry.first.index));
+            output.push_back(Pair("script", HexStr(entry.second.script.begin(), entry.second.script.end())));
+            output.push_back(Pair("satoshis", entry.second.satoshis));
+            output.push_back(Pair("height", entry.second.blockHeight));
+            utxos.push_back(output);
+        }
+
+        UniValue objUnspent(UniValue::VOBJ);
+        objUnspent.push_back(Pair("utxos", utxos));
+        if (fMore) {
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            ssKey << vecUnspent.back().first;
+            objUnspent.push_back(Pair("cursor", HexStr(ssKey.begin(), ssKey.end())));
+        }
+
+        std::string strJSON = objUnspent.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -598,6 +926,9 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/asset/", rest_asset},
+      {"/rest/assetholders/", rest_assetholders},
+      {"/rest/addressutxos/", rest_addressutxos},
 };
 
 bool StartREST()
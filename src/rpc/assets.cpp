@@ -738,7 +738,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
 
     if (request.fHelp || !AreAssetsDeployed() || request.params.size() < 1)
         throw std::runtime_error(
-            "listassetbalancesbyaddress \"address\" (onlytotal) (count) (start)\n"
+            "listassetbalancesbyaddress \"address\" (onlytotal) (count) (start) \"after\"\n"
             + AssetActivationWarning() +
             "\nReturns a list of all asset balances for an address.\n"
 
@@ -747,6 +747,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
             "2. \"onlytotal\"                (boolean, optional, default=false) when false result is just a list of assets balances -- when true the result is just a single number representing the number of assets\n"
             "3. \"count\"                    (integer, optional, default=50000, MAX=50000) truncates results to include only the first _count_ assets found\n"
             "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+            "5. \"after\"                    (string, optional, default=\"\") results start after this asset, pass the last asset of the previous page to page through the list without the cost of a large _start_\n"
 
             "\nResult:\n"
             "{\n"
@@ -757,6 +758,7 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
 
             "\nExamples:\n"
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" false 2 0")
+            + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" false 100 0 \"LAST_ASSET_OF_PREVIOUS_PAGE\"")
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\" true")
             + HelpExampleCli("listassetbalancesbyaddress", "\"myaddress\"")
         );
@@ -784,13 +786,18 @@ UniValue listassetbalancesbyaddress(const JSONRPCRequest& request)
         start = request.params[3].get_int();
     }
 
+    std::string strAfter;
+    if (request.params.size() > 4) {
+        strAfter = request.params[4].get_str();
+    }
+
     if (!passetsdb)
         throw JSONRPCError(RPC_INTERNAL_ERROR, "asset db unavailable.");
 
     LOCK(cs_main);
     std::vector<std::pair<std::string, CAmount> > vecAssetAmounts;
     int nTotalEntries = 0;
-    if (!passetsdb->AddressDir(vecAssetAmounts, nTotalEntries, fOnlyTotal, address, count, start))
+    if (!passetsdb->AddressDir(vecAssetAmounts, nTotalEntries, fOnlyTotal, address, count, start, strAfter))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve address asset directory.");
 
     // If only the number of addresses is wanted return it
@@ -1066,9 +1073,9 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         return "_This rpc call is not functional unless -assetindex is enabled. To enable, please run the wallet with -assetindex, this will require a reindex to occur";
     }
 
-    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 4 || request.params.size() < 1)
+    if (request.fHelp || !AreAssetsDeployed() || request.params.size() > 5 || request.params.size() < 1)
         throw std::runtime_error(
-                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start)\n"
+                "listaddressesbyasset \"asset_name\" (onlytotal) (count) (start) \"after\"\n"
                 + AssetActivationWarning() +
                 "\nReturns a list of all address that own the given asset (with balances)"
                 "\nOr returns the total size of how many address own the given asset"
@@ -1078,6 +1085,7 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
                 "2. \"onlytotal\"                (boolean, optional, default=false) when false result is just a list of addresses with balances -- when true the result is just a single number representing the number of addresses\n"
                 "3. \"count\"                    (integer, optional, default=50000, MAX=50000) truncates results to include only the first _count_ assets found\n"
                 "4. \"start\"                    (integer, optional, default=0) results skip over the first _start_ assets found (if negative it skips back from the end)\n"
+                "5. \"after\"                    (string, optional, default=\"\") results start after this address, pass the last address of the previous page to page through the holders without the cost of a large _start_\n"
 
                 "\nResult:\n"
                 "[ "
@@ -1087,6 +1095,7 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
 
                 "\nExamples:\n"
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 2 0")
+                + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" false 1000 0 \"LAST_ADDRESS_OF_PREVIOUS_PAGE\"")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\" true")
                 + HelpExampleCli("listaddressesbyasset", "\"ASSET_NAME\"")
         );
@@ -1110,13 +1119,18 @@ UniValue listaddressesbyasset(const JSONRPCRequest &request)
         start = request.params[3].get_int();
     }
 
+    std::string strAfter;
+    if (request.params.size() > 4) {
+        strAfter = request.params[4].get_str();
+    }
+
     if (!IsAssetNameValid(asset_name))
         return "_Not a valid asset name";
 
     LOCK(cs_main);
     std::vector<std::pair<std::string, CAmount> > vecAddressAmounts;
     int nTotalEntries = 0;
-    if (!passetsdb->AssetAddressDir(vecAddressAmounts, nTotalEntries, fOnlyTotal, asset_name, count, start))
+    if (!passetsdb->AssetAddressDir(vecAddressAmounts, nTotalEntries, fOnlyTotal, asset_name, count, start, strAfter))
         throw JSONRPCError(RPC_INTERNAL_ERROR, "couldn't retrieve address asset directory.");
 
     // If only the number of addresses is wanted return it
@@ -2948,14 +2962,20 @@ UniValue getsnapshot(const JSONRPCRequest& request)
         result.push_back(Pair("height", snapshotDbEntry.height));
 
         UniValue entries(UniValue::VARR);
-        for (auto const & ownerAndAmt : snapshotDbEntry.ownersAndAmounts) {
-            UniValue entry(UniValue::VOBJ);
+        bool fRead = pAssetSnapshotDb->ForEachOwnershipSnapshotChunk(snapshotDbEntry,
+            [&](const std::vector<std::pair<std::string, CAmount>> & ownersAndAmounts) {
+                for (auto const & ownerAndAmt : ownersAndAmounts) {
+                    UniValue entry(UniValue::VOBJ);
 
-            entry.push_back(Pair("address", ownerAndAmt.first));
-            entry.push_back(Pair("amount_owned", UnitValueFromAmount(ownerAndAmt.second, snapshotDbEntry.assetName)));
+                    entry.push_back(Pair("address", ownerAndAmt.first));
+                    entry.push_back(Pair("amount_owned", UnitValueFromAmount(ownerAndAmt.second, snapshotDbEntry.assetName)));
 
-            entries.push_back(entry);
-        }
+                    entries.push_back(entry);
+                }
+                return true;
+            });
+        if (!fRead)
+            throw JSONRPCError(RPC_DATABASE_ERROR, std::string("Failed to read the owners of the snapshot"));
 
         result.push_back(Pair("owners", entries));
 
@@ -3021,9 +3041,9 @@ static const CRPCCommand commands[] =
     { "assets",   "issueunique",                &issueunique,                true, {"root_name", "asset_tags", "ipfs_hashes", "to_address", "change_address"}},
     { "assets",   "listmyassets",               &listmyassets,               true, {"asset", "verbose", "count", "start", "confs"}},
 #endif
-    { "assets",   "listassetbalancesbyaddress", &listassetbalancesbyaddress, true, {"address", "onlytotal", "count", "start"} },
+    { "assets",   "listassetbalancesbyaddress", &listassetbalancesbyaddress, true, {"address", "onlytotal", "count", "start", "after"} },
     { "assets",   "getassetdata",               &getassetdata,               true, {"asset_name"}},
-    { "assets",   "listaddressesbyasset",       &listaddressesbyasset,       true, {"asset_name", "onlytotal", "count", "start"}},
+    { "assets",   "listaddressesbyasset",       &listaddressesbyasset,       true, {"asset_name", "onlytotal", "count", "start", "after"}},
 #ifdef ENABLE_WALLET
     { "assets",   "transferfromaddress",        &transferfromaddress,        true, {"asset_name", "from_address", "qty", "to_address", "message", "expire_time", "RVH_change_address", "asset_change_address"}},
     { "assets",   "transferfromaddresses",      &transferfromaddresses,      true, {"asset_name", "from_addresses", "qty", "to_address", "message", "expire_time", "RVH_change_address", "asset_change_address"}},
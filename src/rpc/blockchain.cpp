@@ -8,19 +8,27 @@
 #include "rpc/blockchain.h"
 
 #include "amount.h"
+#include "base58.h"
+#include "blockfilter.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "coins.h"
+#include "coinstats.h"
 #include "core_io.h"
 #include "consensus/validation.h"
+#include "ctpl.h"
+#include "init.h"
 #include "validation.h"
 #include "core_io.h"
 // #include "index/txindex.h"
 #include "policy/feerate.h"
 #include "policy/policy.h"
 #include "primitives/transaction.h"
+#include "random.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
+#include "script/standard.h"
 #include "streams.h"
 #include "sync.h"
 #include "txdb.h"
@@ -28,6 +36,9 @@
 #include "util.h"
 #include "utilstrencodings.h"
 #include "hash.h"
+#include "index/blockfilterindex.h"
+#include "index/coinstatsindex.h"
+#include "index/timestampindex.h"
 
 #include "evo/specialtx.h"
 #include "evo/cbtx.h"
@@ -42,8 +53,11 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/thread.hpp> // boost::thread::interrupt
 
-#include <mutex>
+#include <atomic>
 #include <condition_variable>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 
 struct CUpdatedBlock
 {
@@ -117,9 +131,8 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, bool powHash)
+static void blockHeadToJSON(UniValue& result, const CBlock& block, const CBlockIndex* blockindex)
 {
-    UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
@@ -131,23 +144,23 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.push_back(Pair("version", block.nVersion));
     result.push_back(Pair("versionHex", strprintf("%08x", block.nVersion)));
     result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
-    bool chainLock = llmq::chainLocksHandler->HasChainLock(blockindex->nHeight, blockindex->GetBlockHash());
-    UniValue txs(UniValue::VARR);
-    for(const auto& tx : block.vtx)
-    {
-        if(txDetails)
-        {
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, uint256(), objTx);
-            bool fLocked = llmq::quorumInstantSendManager->IsLocked(tx->GetHash());
-            objTx.push_back(Pair("instantlock", fLocked || chainLock));
-            objTx.push_back(Pair("instantlock_internal", fLocked));
-            txs.push_back(objTx);
-        }
-        else
-            txs.push_back(tx->GetHash().GetHex());
-    }
-    result.push_back(Pair("tx", txs));
+}
+
+static UniValue blockTxToJSON(const CTransaction& tx, bool txDetails, bool chainLock)
+{
+    if (!txDetails)
+        return tx.GetHash().GetHex();
+
+    UniValue objTx(UniValue::VOBJ);
+    TxToUniv(tx, uint256(), objTx);
+    bool fLocked = llmq::quorumInstantSendManager->IsLocked(tx.GetHash());
+    objTx.push_back(Pair("instantlock", fLocked || chainLock));
+    objTx.push_back(Pair("instantlock_internal", fLocked));
+    return objTx;
+}
+
+static void blockTailToJSON(UniValue& result, const CBlock& block, const CBlockIndex* blockindex, bool chainLock)
+{
     if (!block.vtx[0]->vExtraPayload.empty()) {
         CCbTx cbTx;
         if (GetTxPayload(block.vtx[0]->vExtraPayload, cbTx)) {
@@ -172,10 +185,50 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
     result.push_back(Pair("chainlock", chainLock));
+}
+
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, bool powHash)
+{
+    UniValue result(UniValue::VOBJ);
+    blockHeadToJSON(result, block, blockindex);
+    bool chainLock = llmq::chainLocksHandler->HasChainLock(blockindex->nHeight, blockindex->GetBlockHash());
+    UniValue txs(UniValue::VARR);
+    for(const auto& tx : block.vtx)
+        txs.push_back(blockTxToJSON(*tx, txDetails, chainLock));
+    result.push_back(Pair("tx", txs));
+    blockTailToJSON(result, block, blockindex, chainLock);
 
     return result;
 }
 
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONStreamWriter& writer)
+{
+    // Writing may block until the client reads, so everything that needs cs_main is collected
+    // up front and the transactions are streamed without it
+    AssertLockNotHeld(cs_main);
+    UniValue head(UniValue::VOBJ);
+    UniValue tail(UniValue::VOBJ);
+    bool chainLock = llmq::chainLocksHandler->HasChainLock(blockindex->nHeight, blockindex->GetBlockHash());
+    {
+        LOCK(cs_main);
+        blockHeadToJSON(head, block, blockindex);
+        blockTailToJSON(tail, block, blockindex, chainLock);
+    }
+
+    writer.BeginObject();
+    writer.Members(head);
+
+    // Only one transaction is held as a UniValue tree at a time
+    writer.Key("tx");
+    writer.BeginArray();
+    for(const auto& tx : block.vtx)
+        writer.Value(blockTxToJSON(*tx, txDetails, chainLock));
+    writer.EndArray();
+
+    writer.Members(tail);
+    writer.EndObject();
+}
+
 UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -406,27 +459,66 @@ std::string EntryDescriptionString()
            "    \"instantlock\" : true|false  (boolean) True if this transaction was locked via InstantSend\n";
 }
 
-void entryToJSON(UniValue &info, const CTxMemPoolEntry &e)
+/** What entryToJSON reports about a mempool entry, copied out so it can be written without mempool.cs */
+struct MempoolEntryInfo
+{
+    uint256 hash;
+    size_t nTxSize;
+    CAmount nFee;
+    CAmount nModifiedFee;
+    int64_t nTime;
+    unsigned int nHeight;
+    uint64_t nCountWithDescendants;
+    uint64_t nSizeWithDescendants;
+    CAmount nModFeesWithDescendants;
+    uint64_t nCountWithAncestors;
+    uint64_t nSizeWithAncestors;
+    CAmount nModFeesWithAncestors;
+    std::vector<uint256> vDepends;
+};
+
+static MempoolEntryInfo GetEntryInfo(const CTxMemPoolEntry& e)
 {
     AssertLockHeld(mempool.cs);
 
-    info.push_back(Pair("size", (int)e.GetTxSize()));
-    info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
-    info.push_back(Pair("modifiedfee", ValueFromAmount(e.GetModifiedFee())));
-    info.push_back(Pair("time", e.GetTime()));
-    info.push_back(Pair("height", (int)e.GetHeight()));
-    info.push_back(Pair("descendantcount", e.GetCountWithDescendants()));
-    info.push_back(Pair("descendantsize", e.GetSizeWithDescendants()));
-    info.push_back(Pair("descendantfees", e.GetModFeesWithDescendants()));
-    info.push_back(Pair("ancestorcount", e.GetCountWithAncestors()));
-    info.push_back(Pair("ancestorsize", e.GetSizeWithAncestors()));
-    info.push_back(Pair("ancestorfees", e.GetModFeesWithAncestors()));
-    const CTransaction& tx = e.GetTx();
-    std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
+    MempoolEntryInfo entry;
+    entry.hash = e.GetTx().GetHash();
+    entry.nTxSize = e.GetTxSize();
+    entry.nFee = e.GetFee();
+    entry.nModifiedFee = e.GetModifiedFee();
+    entry.nTime = e.GetTime();
+    entry.nHeight = e.GetHeight();
+    entry.nCountWithDescendants = e.GetCountWithDescendants();
+    entry.nSizeWithDescendants = e.GetSizeWithDescendants();
+    entry.nModFeesWithDescendants = e.GetModFeesWithDescendants();
+    entry.nCountWithAncestors = e.GetCountWithAncestors();
+    entry.nSizeWithAncestors = e.GetSizeWithAncestors();
+    entry.nModFeesWithAncestors = e.GetModFeesWithAncestors();
+    for (const CTxIn& txin : e.GetTx().vin)
     {
         if (mempool.exists(txin.prevout.hash))
-            setDepends.insert(txin.prevout.hash.ToString());
+            entry.vDepends.push_back(txin.prevout.hash);
+    }
+    return entry;
+}
+
+static void entryInfoToJSON(UniValue &info, const MempoolEntryInfo& entry)
+{
+    info.push_back(Pair("size", (int)entry.nTxSize));
+    info.push_back(Pair("fee", ValueFromAmount(entry.nFee)));
+    info.push_back(Pair("modifiedfee", ValueFromAmount(entry.nModifiedFee)));
+    info.push_back(Pair("time", entry.nTime));
+    info.push_back(Pair("height", (int)entry.nHeight));
+    info.push_back(Pair("descendantcount", entry.nCountWithDescendants));
+    info.push_back(Pair("descendantsize", entry.nSizeWithDescendants));
+    info.push_back(Pair("descendantfees", entry.nModFeesWithDescendants));
+    info.push_back(Pair("ancestorcount", entry.nCountWithAncestors));
+    info.push_back(Pair("ancestorsize", entry.nSizeWithAncestors));
+    info.push_back(Pair("ancestorfees", entry.nModFeesWithAncestors));
+    std::set<std::string> setDepends;
+    for (const uint256& dep : entry.vDepends)
+    {
+        setDepends.insert(dep.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -436,7 +528,13 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e)
     }
 
     info.push_back(Pair("depends", depends));
-    info.push_back(Pair("instantlock", llmq::quorumInstantSendManager->IsLocked(tx.GetHash())));
+    info.push_back(Pair("instantlock", llmq::quorumInstantSendManager->IsLocked(entry.hash)));
+}
+
+void entryToJSON(UniValue &info, const CTxMemPoolEntry &e)
+{
+    AssertLockHeld(mempool.cs);
+    entryInfoToJSON(info, GetEntryInfo(e));
 }
 
 UniValue mempoolToJSON(bool fVerbose)
@@ -467,6 +565,41 @@ UniValue mempoolToJSON(bool fVerbose)
     }
 }
 
+void mempoolToJSON(bool fVerbose, JSONStreamWriter& writer)
+{
+    if (fVerbose)
+    {
+        // Writing may block until the client reads, so copy the entries first and don't hold
+        // mempool.cs while streaming them
+        std::vector<MempoolEntryInfo> vEntries;
+        {
+            LOCK(mempool.cs);
+            vEntries.reserve(mempool.mapTx.size());
+            for (const CTxMemPoolEntry& e : mempool.mapTx)
+                vEntries.push_back(GetEntryInfo(e));
+        }
+
+        writer.BeginObject();
+        for (const MempoolEntryInfo& entry : vEntries)
+        {
+            UniValue info(UniValue::VOBJ);
+            entryInfoToJSON(info, entry);
+            writer.KeyValue(entry.hash.ToString(), info);
+        }
+        writer.EndObject();
+    }
+    else
+    {
+        std::vector<uint256> vtxid;
+        mempool.queryHashes(vtxid);
+
+        writer.BeginArray();
+        for (const uint256& hash : vtxid)
+            writer.Value(hash.ToString());
+        writer.EndArray();
+    }
+}
+
 UniValue getrawmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -496,6 +629,11 @@ UniValue getrawmempool(const JSONRPCRequest& request)
     if (!request.params[0].isNull())
         fVerbose = request.params[0].get_bool();
 
+    if (request.pStreamWriter) {
+        mempoolToJSON(fVerbose, *request.pStreamWriter);
+        return NullUniValue;
+    }
+
     return mempoolToJSON(fVerbose);
 }
 
@@ -682,6 +820,11 @@ UniValue getblockhashes(const JSONRPCRequest& request)
     unsigned int low = request.params[1].get_int();
     std::vector<uint256> blockHashes;
 
+    // The index would miss the blocks it hasn't caught up with yet
+    if (g_timestampindex && !g_timestampindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block timestamps are still in the process of being indexed.");
+    }
+
     if (!GetTimestampIndex(high, low, blockHashes)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
     }
@@ -886,6 +1029,21 @@ static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
     return block;
 }
 
+static std::vector<uint8_t> GetRawBlockChecked(const CBlockIndex* pblockindex)
+{
+    std::vector<uint8_t> data;
+    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+    }
+
+    if (!ReadRawBlockFromDisk(data, pblockindex, Params().MessageStart())) {
+        // see GetBlockChecked
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+
+    return data;
+}
+
 
 UniValue getmerkleblocks(const JSONRPCRequest& request)
 {
@@ -1018,8 +1176,6 @@ UniValue getblock(const JSONRPCRequest& request)
             + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
-    LOCK(cs_main);
-
     std::string strHash = request.params[0].get_str();
     uint256 hash(uint256S(strHash));
 
@@ -1039,91 +1195,109 @@ UniValue getblock(const JSONRPCRequest& request)
 		}
 	}
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    CBlock block;
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
 
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-    const CBlock block = GetBlockChecked(pblockindex);
+        if (mapBlockIndex.count(hash) == 0)
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    if (verbosity <= 0)
-    {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        pblockindex = mapBlockIndex[hash];
+
+        if (verbosity <= 0)
+        {
+            // the serialized block is what is on disk already
+            const std::vector<uint8_t> data = GetRawBlockChecked(pblockindex);
+            return HexStr(data.begin(), data.end());
+        }
+
+        block = GetBlockChecked(pblockindex);
+
+        if (verbosity < 2 || !request.pStreamWriter)
+            return blockToJSON(block, pblockindex, verbosity >= 2, powHash);
     }
 
-    return blockToJSON(block, pblockindex, verbosity >= 2, powHash);
+    // Streaming may wait for the client, which must not hold up validation
+    blockToJSON(block, pblockindex, true, *request.pStreamWriter);
+    return NullUniValue;
 }
 
-struct CCoinsStats
+UniValue getblockfilter(const JSONRPCRequest& request)
 {
-    int nHeight;
-    uint256 hashBlock;
-    uint64_t nTransactions;
-    uint64_t nTransactionOutputs;
-    uint64_t nBogoSize;
-    uint256 hashSerialized;
-    uint64_t nDiskSize;
-    CAmount nTotalAmount;
-
-    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
-};
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "The basic filter matches the scripts created and spent in the block, and the holder script of asset outputs.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"     (string, required) The hash of the block\n"
+            "2. \"filtertype\"    (string, optional, default=\"basic\") The type name of the filter (" + ListBlockFilterTypes() + ")\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"xxxx\",   (string) the hex-encoded filter data\n"
+            "  \"header\" : \"xxxx\"    (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
-{
-    assert(!outputs.empty());
-    ss << hash;
-    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
-    stats.nTransactions++;
-    for (const auto output : outputs) {
-        ss << VARINT(output.first + 1);
-        ss << output.second.out.scriptPubKey;
-        ss << VARINT(output.second.out.nValue);
-        stats.nTransactionOutputs++;
-        stats.nTotalAmount += output.second.out.nValue;
-        stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
-                           2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
-    }
-    ss << VARINT(0);
-}
+    uint256 block_hash = ParseHashV(request.params[0], "blockhash");
+    std::string filtertype_name = "basic";
+    if (!request.params[1].isNull()) {
+        filtertype_name = request.params[1].get_str();
+    }
 
-//! Calculate statistics about the unspent transaction output set
-static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
-{
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+    BlockFilterType filtertype;
+    if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+    }
 
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
+    BlockFilterIndex* index = GetBlockFilterIndex(filtertype);
+    if (!index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filtertype_name);
+    }
+
+    const CBlockIndex* block_index;
+    bool block_was_connected;
     {
         LOCK(cs_main);
-        stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->nHeight;
+        BlockMap::iterator mi = mapBlockIndex.find(block_hash);
+        if (mi == mapBlockIndex.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        block_index = mi->second;
+        block_was_connected = block_index->IsValid(BLOCK_VALID_SCRIPTS);
     }
-    ss << stats.hashBlock;
-    uint256 prevkey;
-    std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        COutPoint key;
-        Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
-                outputs.clear();
-            }
-            prevkey = key.hash;
-            outputs[key.n] = std::move(coin);
+
+    bool index_ready = index->BlockUntilSyncedToCurrentChain();
+
+    BlockFilter filter;
+    uint256 filter_header;
+    if (!index->LookupFilter(block_index, filter) ||
+        !index->LookupFilterHeader(block_index, filter_header)) {
+        int err_code;
+        std::string errmsg = "Filter not found.";
+
+        if (!block_was_connected) {
+            err_code = RPC_INVALID_ADDRESS_OR_KEY;
+            errmsg += " Block was not connected to active chain.";
+        } else if (!index_ready) {
+            err_code = RPC_MISC_ERROR;
+            errmsg += " Block filters are still in the process of being indexed.";
         } else {
-            return error("%s: unable to read value", __func__);
+            err_code = RPC_INTERNAL_ERROR;
+            errmsg += " This error is unexpected and indicates index corruption.";
         }
-        pcursor->Next();
-    }
-    if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+
+        throw JSONRPCError(err_code, errmsg);
     }
-    stats.hashSerialized = ss.GetHash();
-    stats.nDiskSize = view->EstimateSize();
-    return true;
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("filter", HexStr(filter.GetEncodedFilter())));
+    ret.push_back(Pair("header", filter_header.GetHex()));
+    return ret;
 }
 
 UniValue pruneblockchain(const JSONRPCRequest& request)
@@ -1175,44 +1349,163 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
     return uint64_t(height);
 }
 
+//! Get the block in the active chain a hash_or_height parameter refers to. Requires cs_main.
+static const CBlockIndex* ParseHashOrHeight(const UniValue& param)
+{
+    AssertLockHeld(cs_main);
+
+    if (param.isNum()) {
+        const int height = param.get_int();
+        const int current_tip = chainActive.Height();
+        if (height < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
+        }
+        if (height > current_tip) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+        }
+
+        return chainActive[height];
+    } else {
+        const uint256 hash = ParseHashV(param, "hash_or_height");
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        if (!chainActive.Contains(mi->second)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+        }
+        return mi->second;
+    }
+}
+
+static CoinStatsHashType ParseHashType(const std::string& hash_type_input)
+{
+    if (hash_type_input == "hash_serialized_2") {
+        return CoinStatsHashType::HASH_SERIALIZED;
+    } else if (hash_type_input == "muhash") {
+        return CoinStatsHashType::MUHASH;
+    } else if (hash_type_input == "none") {
+        return CoinStatsHashType::NONE;
+    } else {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", hash_type_input));
+    }
+}
+
 UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 4)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" hash_or_height use_index asset_totals )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time if you are not using coinstatsindex.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"      (string, optional, default=\"hash_serialized_2\") Which UTXO set hash should be calculated. Options: 'hash_serialized_2' (the legacy algorithm), 'muhash', 'none'.\n"
+            "2. hash_or_height   (string or numeric, optional) The block hash or height of the target height (only available with coinstatsindex).\n"
+            "3. use_index        (boolean, optional, default=true) Use coinstatsindex, if available. The index can't calculate 'hash_serialized_2'.\n"
+            "4. asset_totals     (boolean, optional, default=false) Include the amount held of each asset.\n"
             "\nResult:\n"
             "{\n"
-            "  \"height\":n,     (numeric) The current block height (index)\n"
-            "  \"bestblock\": \"hex\",   (string) the best block hash hex\n"
-            "  \"transactions\": n,      (numeric) The number of transactions\n"
+            "  \"height\":n,     (numeric) The block height (index) of the returned statistics\n"
+            "  \"bestblock\": \"hex\",   (string) The hash of the block at which these statistics are calculated\n"
+            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs (not available when coinstatsindex is used)\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
-            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
-            "  \"total_amount\": x.xxx          (numeric) The total amount\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)\n"
+            "  \"muhash\": \"hash\",      (string) The MuHash of the UTXO set (only present if 'muhash' hash_type is chosen)\n"
+            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk (not available when coinstatsindex is used)\n"
+            "  \"total_amount\": x.xxx,  (numeric) The total amount\n"
+            "  \"asset_txouts\": n,      (numeric) The number of unspent transaction outputs holding an asset\n"
+            "  \"assets\": n,            (numeric) The number of assets held by unspent transaction outputs\n"
+            "  \"asset_totals\": {       (json object, only present if asset_totals is set) The amount held of each asset\n"
+            "    \"asset_name\": x.xxx,  (numeric) The amount of the asset held by unspent transaction outputs\n"
+            "    ,...\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"none\"")
+            + HelpExampleCli("gettxoutsetinfo", "\"none\" 1000")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\" '\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"' true true")
             + HelpExampleRpc("gettxoutsetinfo", "")
+            + HelpExampleRpc("gettxoutsetinfo", "\"none\"")
+            + HelpExampleRpc("gettxoutsetinfo", "\"none\", 1000")
         );
 
     UniValue ret(UniValue::VOBJ);
 
+    CoinStatsHashType hash_type = request.params[0].isNull() ? CoinStatsHashType::HASH_SERIALIZED : ParseHashType(request.params[0].get_str());
+    bool index_requested = request.params[2].isNull() || request.params[2].get_bool();
+    bool fAssetTotals = !request.params[3].isNull() && request.params[3].get_bool();
+
+    // The index keeps the MuHash only, so the legacy hash always scans the UTXO set
+    bool use_index = g_coin_stats_index && index_requested && hash_type != CoinStatsHashType::HASH_SERIALIZED;
+
+    const CBlockIndex* pindex = nullptr;
+    if (!request.params[1].isNull()) {
+        if (!g_coin_stats_index) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires coinstatsindex");
+        }
+        if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "hash_serialized_2 hash type cannot be queried for a specific block");
+        }
+        if (!index_requested) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires use_index");
+        }
+        LOCK(cs_main);
+        pindex = ParseHashOrHeight(request.params[1]);
+    }
+
     CCoinsStats stats;
-    FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview, stats)) {
-        ret.push_back(Pair("height", (int64_t)stats.nHeight));
-        ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+    if (use_index) {
+        bool index_ready = g_coin_stats_index->BlockUntilSyncedToCurrentChain();
+        if (!pindex) {
+            // The block the index is synced to is the tip it just caught up with
+            LOCK(cs_main);
+            pindex = index_ready ? g_coin_stats_index->GetBestBlockIndex() : chainActive.Tip();
+        }
+        if (fAssetTotals) {
+            LOCK(cs_main);
+            if (!chainActive.Contains(pindex)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Asset totals are only available for blocks in the active chain");
+            }
+        }
+        if (!g_coin_stats_index->LookUpStats(pindex, stats, fAssetTotals)) {
+            if (!index_ready) {
+                throw JSONRPCError(RPC_MISC_ERROR, "UTXO set statistics are still in the process of being indexed.");
+            }
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set statistics");
+        }
+    } else {
+        FlushStateToDisk();
+        if (!GetUTXOStats(pcoinsdbview, stats, hash_type, fAssetTotals)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
+    }
+
+    ret.push_back(Pair("height", (int64_t)stats.nHeight));
+    ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+    if (!stats.fFromIndex) {
         ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
-        ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
-        ret.push_back(Pair("bogosize", (int64_t)stats.nBogoSize));
+    }
+    ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
+    ret.push_back(Pair("bogosize", (int64_t)stats.nBogoSize));
+    if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
         ret.push_back(Pair("hash_serialized_2", stats.hashSerialized.GetHex()));
+    } else if (hash_type == CoinStatsHashType::MUHASH) {
+        ret.push_back(Pair("muhash", stats.hashSerialized.GetHex()));
+    }
+    if (!stats.fFromIndex) {
         ret.push_back(Pair("disk_size", stats.nDiskSize));
-        ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
-    } else {
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+    }
+    ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
+    ret.push_back(Pair("asset_txouts", (int64_t)stats.nAssetOutputs));
+    ret.push_back(Pair("assets", (int64_t)stats.nAssets));
+    if (fAssetTotals) {
+        UniValue totals(UniValue::VOBJ);
+        for (const auto& asset : stats.mapAssetTotals) {
+            totals.push_back(Pair(asset.first, ValueFromAmount(asset.second)));
+        }
+        ret.push_back(Pair("asset_totals", totals));
     }
     return ret;
 }
@@ -1924,33 +2217,7 @@ static UniValue getblockstats(const JSONRPCRequest& request)
 
     LOCK(cs_main);
 
-    CBlockIndex* pindex;
-    if (request.params[0].isNum()) {
-        const int height = request.params[0].get_int();
-        const int current_tip = chainActive.Height();
-        if (height < 0) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
-        }
-        if (height > current_tip) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
-        }
-
-        pindex = chainActive[height];
-    } else {
-        const uint256 hash = ParseHashV(request.params[0], "parameter 1");
-        if (mapBlockIndex.count(hash) == 0)
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        pindex = mapBlockIndex[hash];
-        // pindex = LookupBlockIndex(hash);
-        // if (!pindex) {
-        //     throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        // }
-        if (!chainActive.Contains(pindex)) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
-        }
-    }
-
-    assert(pindex != nullptr);
+    const CBlockIndex* pindex = ParseHashOrHeight(request.params[0]);
 
     std::set<std::string> stats;
     if (!request.params[1].isNull()) {
@@ -2199,6 +2466,347 @@ UniValue getspecialtxes(const JSONRPCRequest& request)
     return result;
 }
 
+/** Maximum number of threads scanning the UTXO set in parallel, see scantxoutset */
+static const int MAX_SCAN_THREADS = 8;
+
+//! Progress of the running scan, in 65536ths of the txid space
+static std::atomic<int> g_scan_progress;
+static std::atomic<bool> g_scan_in_progress;
+static std::atomic<bool> g_should_abort_scan;
+
+/** RAII object to prevent concurrency issues when scanning the txout set */
+class CoinsViewScanReserver
+{
+private:
+    bool m_could_reserve;
+public:
+    explicit CoinsViewScanReserver() : m_could_reserve(false) {}
+
+    bool reserve() {
+        assert(!m_could_reserve);
+        bool expected = false;
+        if (!g_scan_in_progress.compare_exchange_strong(expected, true)) {
+            return false;
+        }
+        m_could_reserve = true;
+        return true;
+    }
+
+    ~CoinsViewScanReserver() {
+        if (m_could_reserve) {
+            g_scan_in_progress = false;
+        }
+    }
+};
+
+/** Salted hasher for the scripts a scan looks for */
+class ScanScriptHasher
+{
+private:
+    const uint64_t k0, k1;
+
+public:
+    ScanScriptHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+    size_t operator()(const CScript& script) const
+    {
+        return CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+    }
+};
+
+//! The scripts a scan looks for, mapped to the index of the scan object they came from
+typedef std::unordered_map<CScript, size_t, ScanScriptHasher> ScanNeedles;
+
+struct ScanMatch
+{
+    COutPoint outpoint;
+    Coin coin;
+    size_t nObject;
+};
+
+/** Get the scripts paying to a scan object, which is an address or one of addr(), raw(), pk(), pkh() and combo() */
+static std::vector<CScript> ParseScanObject(const std::string& strObject)
+{
+    std::vector<CScript> scripts;
+
+    size_t nOpen = strObject.find('(');
+    if (nOpen == std::string::npos) {
+        CTxDestination dest = DecodeDestination(strObject);
+        if (!IsValidDestination(dest)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid address or scan object: %s", strObject));
+        }
+        scripts.push_back(GetScriptForDestination(dest));
+        return scripts;
+    }
+    if (strObject.back() != ')') {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid scan object: %s", strObject));
+    }
+
+    std::string strType = strObject.substr(0, nOpen);
+    std::string strArg = strObject.substr(nOpen + 1, strObject.size() - nOpen - 2);
+    if (strType == "addr") {
+        CTxDestination dest = DecodeDestination(strArg);
+        if (!IsValidDestination(dest)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid address: %s", strArg));
+        }
+        scripts.push_back(GetScriptForDestination(dest));
+    } else if (strType == "raw") {
+        if (strArg.empty() || !IsHex(strArg)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Script must be hex: %s", strArg));
+        }
+        std::vector<unsigned char> data(ParseHex(strArg));
+        scripts.push_back(CScript(data.begin(), data.end()));
+    } else if (strType == "pk" || strType == "pkh" || strType == "combo") {
+        if (!IsHex(strArg)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Public key must be hex: %s", strArg));
+        }
+        CPubKey pubkey(ParseHex(strArg));
+        if (!pubkey.IsFullyValid()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Invalid public key: %s", strArg));
+        }
+        if (strType != "pkh") {
+            scripts.push_back(GetScriptForRawPubKey(pubkey));
+        }
+        if (strType != "pk") {
+            scripts.push_back(GetScriptForDestination(pubkey.GetID()));
+        }
+    } else {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Unknown scan object type: %s", strType));
+    }
+    return scripts;
+}
+
+/**
+ * Look for the scripts in the coins of the transactions whose id starts with a byte below nEndByte, beginning
+ * where the cursor is positioned. Asset outputs also match the script they pay to without the asset data.
+ */
+static bool ScanUTXORange(CCoinsViewCursor* pcursor, unsigned int nStartByte, unsigned int nEndByte, const ScanNeedles& needles,
+                          std::vector<ScanMatch>& matches, int64_t& nSearched)
+{
+    // Progress is counted by the first two bytes of the txid
+    unsigned int nReported = nStartByte << 8;
+    while (pcursor->Valid()) {
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+            return false;
+        }
+        unsigned int nPos = (key.hash.begin()[0] << 8) | key.hash.begin()[1];
+        if (nPos >= nEndByte << 8) {
+            break;
+        }
+        if (++nSearched % 8192 == 0) {
+            if (g_should_abort_scan || ShutdownRequested()) {
+                return false;
+            }
+            g_scan_progress += nPos - nReported;
+            nReported = nPos;
+        }
+
+        const CScript& script = coin.out.scriptPubKey;
+        auto it = needles.find(script);
+        if (it == needles.end() && script.IsAssetScript()) {
+            // The asset data follows a P2PKH script
+            it = needles.find(CScript(script.begin(), script.begin() + 25));
+        }
+        if (it != needles.end()) {
+            matches.push_back(ScanMatch{key, std::move(coin), it->second});
+        }
+        pcursor->Next();
+    }
+    g_scan_progress += (nEndByte << 8) - nReported;
+    return true;
+}
+
+UniValue scantxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "scantxoutset \"action\" ( [scanobjects,...] )\n"
+            "\nScans the unspent transaction output set for outputs paying to any of the scan objects, without a wallet or -addressindex.\n"
+            "The scan runs on several threads and only one scan can run at a time.\n"
+            "\nArguments:\n"
+            "1. \"action\"                       (string, required) The action to execute\n"
+            "                                      \"start\" for starting a scan\n"
+            "                                      \"abort\" for aborting the current scan (returns true when abort was successful)\n"
+            "                                      \"status\" for progress report (in %) of the current scan\n"
+            "2. \"scanobjects\"                  (array, required for \"start\") Array of scan objects\n"
+            "    [\n"
+            "      \"scanobject\"                (string) One of:\n"
+            "                                      \"address\" or \"addr(address)\": outputs and asset outputs paying to the address\n"
+            "                                      \"raw(hex)\": outputs with this scriptPubKey\n"
+            "                                      \"pk(pubkey)\": P2PK outputs of the public key\n"
+            "                                      \"pkh(pubkey)\": P2PKH outputs and asset outputs of the public key\n"
+            "                                      \"combo(pubkey)\": both of the above\n"
+            "      ,...\n"
+            "    ]\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"success\": true|false,          (boolean) Whether the scan completed\n"
+            "  \"searched_items\": n,            (numeric) The number of unspent transaction outputs scanned\n"
+            "  \"height\": n,                    (numeric) The height of the block at which the scan was done\n"
+            "  \"bestblock\": \"hash\",            (string) The hash of the block at which the scan was done\n"
+            "  \"unspents\": [\n"
+            "    {\n"
+            "      \"txid\": \"transactionid\",     (string) The transaction id\n"
+            "      \"vout\": n,                  (numeric) The vout value\n"
+            "      \"scriptPubKey\": \"script\",    (string) The script key\n"
+            "      \"desc\": \"scanobject\",        (string) The scan object that matched the output\n"
+            "      \"amount\": x.xxx,            (numeric) The total amount in " + CURRENCY_UNIT + " of the unspent output\n"
+            "      \"height\": n,                (numeric) Height of the unspent transaction output\n"
+            "      \"asset\": {                  (json object, only for asset outputs)\n"
+            "        \"name\": \"asset_name\",      (string) The name of the asset\n"
+            "        \"amount\": x.xxx           (numeric) The amount of the asset\n"
+            "      }\n"
+            "    }\n"
+            "    ,...\n"
+            "  ],\n"
+            "  \"total_amount\": x.xxx,          (numeric) The total amount of all found unspent outputs in " + CURRENCY_UNIT + "\n"
+            "  \"asset_totals\": {               (json object) The total amount of each asset in the found unspent outputs\n"
+            "    \"asset_name\": x.xxx\n"
+            "    ,...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("scantxoutset", "start '[\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\", \"pkh(0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798)\"]'")
+            + HelpExampleCli("scantxoutset", "status")
+            + HelpExampleRpc("scantxoutset", "\"start\", [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]")
+        );
+
+    RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VARR});
+
+    UniValue result(UniValue::VOBJ);
+    if (request.params[0].get_str() == "status") {
+        CoinsViewScanReserver reserver;
+        if (reserver.reserve()) {
+            // no scan in progress
+            return NullUniValue;
+        }
+        result.push_back(Pair("progress", (int)(g_scan_progress * 100.0 / 65536 + 0.5)));
+        return result;
+    } else if (request.params[0].get_str() == "abort") {
+        CoinsViewScanReserver reserver;
+        if (reserver.reserve()) {
+            // reserve was possible which means no scan was running
+            return false;
+        }
+        // set the abort flag
+        g_should_abort_scan = true;
+        return true;
+    } else if (request.params[0].get_str() != "start") {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid command '%s'", request.params[0].get_str()));
+    }
+
+    CoinsViewScanReserver reserver;
+    if (!reserver.reserve()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Scan already in progress, use action \"abort\" or \"status\"");
+    }
+    if (request.params[1].isNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "scanobjects argument is required for the start action");
+    }
+
+    std::vector<std::string> vObjects;
+    ScanNeedles needles;
+    for (const UniValue& scanobject : request.params[1].get_array().getValues()) {
+        if (!scanobject.isStr()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Scan object must be a string");
+        }
+        for (CScript& script : ParseScanObject(scanobject.get_str())) {
+            needles.emplace(std::move(script), vObjects.size());
+        }
+        vObjects.push_back(scanobject.get_str());
+    }
+
+    g_scan_progress = 0;
+    g_should_abort_scan = false;
+
+    // Coins are keyed by txid, so the txid space is split into one range per thread
+    const int nWorkers = std::max(1, std::min(GetNumCores(), MAX_SCAN_THREADS));
+    std::vector<unsigned int> vRangeStart;
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    uint256 hashBestBlock;
+    int nHeight;
+    {
+        // Cursors created under cs_main all see the flushed chainstate
+        LOCK(cs_main);
+        FlushStateToDisk();
+        for (int i = 0; i <= nWorkers; i++) {
+            vRangeStart.push_back(256 * i / nWorkers);
+        }
+        for (int i = 0; i < nWorkers; i++) {
+            uint256 txidStart;
+            *txidStart.begin() = vRangeStart[i];
+            cursors.emplace_back(pcoinsdbview->Cursor(txidStart));
+        }
+        hashBestBlock = cursors[0]->GetBestBlock();
+        nHeight = mapBlockIndex.find(hashBestBlock)->second->nHeight;
+    }
+
+    std::vector<std::vector<ScanMatch>> vMatches(nWorkers);
+    std::vector<int64_t> vSearched(nWorkers, 0);
+    std::vector<std::future<bool>> futures;
+    {
+        ctpl::thread_pool scanPool(nWorkers);
+        RenameThreadPool(scanPool, "ravencash-utxoscan");
+        for (int i = 0; i < nWorkers; i++) {
+            futures.emplace_back(scanPool.push([&, i](int threadId) {
+                return ScanUTXORange(cursors[i].get(), vRangeStart[i], vRangeStart[i + 1], needles, vMatches[i], vSearched[i]);
+            }));
+        }
+    }
+
+    bool fSuccess = true;
+    int64_t nSearched = 0;
+    for (int i = 0; i < nWorkers; i++) {
+        fSuccess &= futures[i].get();
+        nSearched += vSearched[i];
+    }
+
+    // The ranges are in txid order, and so are the matches within each of them
+    CAmount nTotal = 0;
+    std::map<std::string, CAmount> mapAssetTotals;
+    UniValue unspents(UniValue::VARR);
+    for (const auto& matches : vMatches) {
+        for (const ScanMatch& match : matches) {
+            const CTxOut& txo = match.coin.out;
+            nTotal += txo.nValue;
+
+            UniValue unspent(UniValue::VOBJ);
+            unspent.push_back(Pair("txid", match.outpoint.hash.GetHex()));
+            unspent.push_back(Pair("vout", (int32_t)match.outpoint.n));
+            unspent.push_back(Pair("scriptPubKey", HexStr(txo.scriptPubKey.begin(), txo.scriptPubKey.end())));
+            unspent.push_back(Pair("desc", vObjects[match.nObject]));
+            unspent.push_back(Pair("amount", ValueFromAmount(txo.nValue)));
+            unspent.push_back(Pair("height", (int32_t)match.coin.nHeight));
+
+            std::string strAssetName;
+            CAmount nAssetAmount;
+            if (GetScriptAssetAmount(txo.scriptPubKey, strAssetName, nAssetAmount)) {
+                mapAssetTotals[strAssetName] += nAssetAmount;
+                UniValue asset(UniValue::VOBJ);
+                asset.push_back(Pair("name", strAssetName));
+                asset.push_back(Pair("amount", ValueFromAmount(nAssetAmount)));
+                unspent.push_back(Pair("asset", asset));
+            }
+            unspents.push_back(unspent);
+        }
+    }
+
+    UniValue assetTotals(UniValue::VOBJ);
+    for (const auto& asset : mapAssetTotals) {
+        assetTotals.push_back(Pair(asset.first, ValueFromAmount(asset.second)));
+    }
+
+    result.push_back(Pair("success", fSuccess));
+    result.push_back(Pair("searched_items", nSearched));
+    result.push_back(Pair("height", nHeight));
+    result.push_back(Pair("bestblock", hashBestBlock.GetHex()));
+    result.push_back(Pair("unspents", unspents));
+    result.push_back(Pair("total_amount", ValueFromAmount(nTotal)));
+    result.push_back(Pair("asset_totals", assetTotals));
+    return result;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafe argNames
   //  --------------------- ------------------------  -----------------------  ------ ----------
@@ -2209,6 +2817,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getbestchainlock",       &getbestchainlock,       true,  {} },
     { "blockchain",         "getblockcount",          &getblockcount,          true,  {} },
     { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbosity|verbose", "powhash"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         true,  {"blockhash","filtertype"} },
     { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"} },
     { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
@@ -2223,7 +2832,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         true,  {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {"hash_type", "hash_or_height", "use_index", "asset_totals"} },
+    { "blockchain",         "scantxoutset",           &scantxoutset,           true,  {"action", "scanobjects"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
 
@@ -7,6 +7,7 @@
 
 class CBlock;
 class CBlockIndex;
+class JSONStreamWriter;
 class UniValue;
 
 /**
@@ -24,12 +25,19 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false, bool powHash = false);
 
+/** Block description to JSON, written into a stream one transaction at a time. Takes cs_main
+ * only to collect the header fields, so it must be called without it. */
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, JSONStreamWriter& writer);
+
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
 
+/** Mempool to JSON, written into a stream one entry at a time from a copy taken under mempool.cs */
+void mempoolToJSON(bool fVerbose, JSONStreamWriter& writer);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
@@ -164,6 +164,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "gettxout", 1, "n" },
     { "gettxout", 2, "include_mempool" },
     { "gettxoutproof", 0, "txids" },
+    { "gettxoutsetinfo", 1, "hash_or_height" },
+    { "gettxoutsetinfo", 2, "use_index" },
+    { "gettxoutsetinfo", 3, "asset_totals" },
+    { "scantxoutset", 1, "scanobjects" },
     { "lockunspent", 0, "unlock" },
     { "lockunspent", 1, "transactions" },
     { "importprivkey", 2, "rescan" },
@@ -239,6 +243,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getsnapshot", 1, "block_height"},
     { "purgesnapshot", 1, "block_height"},
     { "stop", 0, "wait" },
+    { "getrpcstats", 0, "reset" },
+    { "getlockprofile", 0, "reset" },
+    { "getlockprofile", 1, "count" },
     { "getkawpowhash", 3, "height"},
 };
 
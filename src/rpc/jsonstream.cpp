@@ -0,0 +1,106 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <assert.h>
+
+JSONStreamWriter::JSONStreamWriter(const Sink& sinkIn, size_t nChunkSizeIn) :
+    sink(sinkIn), nChunkSize(nChunkSizeIn), fAfterKey(false), nBytesFlushed(0)
+{
+    buffer.reserve(nChunkSize);
+}
+
+void JSONStreamWriter::BeginValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+
+    if (!vFirst.empty()) {
+        if (!vFirst.back())
+            Append(",");
+        vFirst.back() = false;
+    }
+}
+
+void JSONStreamWriter::Append(const std::string& str)
+{
+    buffer.append(str);
+    if (buffer.size() >= nChunkSize)
+        Flush();
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    Append("{");
+    vFirst.push_back(true);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    vFirst.pop_back();
+    Append("}");
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    Append("[");
+    vFirst.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    vFirst.pop_back();
+    Append("]");
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vFirst.empty() && !fAfterKey);
+    BeginValue();
+    Append(UniValue(key).write() + ":");
+    fAfterKey = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    BeginValue();
+    Append(value.write());
+}
+
+void JSONStreamWriter::KeyValue(const std::string& key, const UniValue& value)
+{
+    Key(key);
+    Value(value);
+}
+
+void JSONStreamWriter::Members(const UniValue& obj)
+{
+    assert(obj.isObject());
+    const std::vector<std::string>& keys = obj.getKeys();
+    const std::vector<UniValue>& values = obj.getValues();
+    for (size_t i = 0; i < keys.size(); i++)
+        KeyValue(keys[i], values[i]);
+}
+
+void JSONStreamWriter::WriteRaw(const std::string& str)
+{
+    Append(str);
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (buffer.empty())
+        return;
+
+    sink(buffer.data(), buffer.size());
+    nBytesFlushed += buffer.size();
+    buffer.clear();
+}
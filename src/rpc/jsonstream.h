@@ -0,0 +1,68 @@
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+/** Size of the chunks handed to the sink by default */
+static const size_t DEFAULT_JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Writes a JSON document piece by piece into a sink, in chunks of about nChunkSize bytes.
+ * Large RPC and REST replies use it to send their output while it is produced, instead of
+ * building the whole UniValue tree and its string first. The output is the same as
+ * UniValue::write() without indentation.
+ */
+class JSONStreamWriter
+{
+public:
+    typedef std::function<void(const char* data, size_t len)> Sink;
+
+    explicit JSONStreamWriter(const Sink& sinkIn, size_t nChunkSizeIn = DEFAULT_JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write the key of the next object member */
+    void Key(const std::string& key);
+    /** Write a complete value, as an array element, a member value after Key() or the document itself */
+    void Value(const UniValue& value);
+    void KeyValue(const std::string& key, const UniValue& value);
+    /** Write all members of the object obj into the currently open object */
+    void Members(const UniValue& obj);
+
+    /** Append text that isn't part of the document structure, e.g. a trailing newline */
+    void WriteRaw(const std::string& str);
+
+    /** Hand everything buffered so far to the sink */
+    void Flush();
+
+    /** Returns true if a Key() was written and its value hasn't been yet */
+    bool ExpectsValue() const { return fAfterKey; }
+
+    /** Number of bytes handed to the sink so far */
+    size_t GetBytesFlushed() const { return nBytesFlushed; }
+
+private:
+    void BeginValue();
+    void Append(const std::string& str);
+
+    Sink sink;
+    size_t nChunkSize;
+    std::string buffer;
+    //! One entry per open object or array, true until its first member is written
+    std::vector<bool> vFirst;
+    bool fAfterKey;
+    size_t nBytesFlushed;
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
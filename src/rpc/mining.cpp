@@ -13,7 +13,9 @@
 #include "consensus/params.h"
 #include "consensus/validation.h"
 #include "core_io.h"
+#include "hash.h"
 #include "init.h"
+#include "kawpow_context.h"
 #include "validation.h"
 #include "miner.h"
 #include "net.h"
@@ -212,6 +214,42 @@ UniValue generatetoaddress(const JSONRPCRequest& request)
 }
 #endif // ENABLE_MINER
 
+static UniValue KAWPOWContextStats()
+{
+    const CKAWPOWContextManager::Stats stats = GetKAWPOWContextManager().GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("epoch",        stats.nCurrentEpoch));
+    obj.push_back(Pair("nextready",    stats.fNextEpochReady));
+    obj.push_back(Pair("building",     stats.fBuilding));
+    obj.push_back(Pair("contexts",     (uint64_t)stats.nContexts));
+    obj.push_back(Pair("memory",       (uint64_t)stats.nMemoryUsage));
+    obj.push_back(Pair("builds",       stats.nBuilds));
+    obj.push_back(Pair("lastbuildms",  stats.nLastBuildMicros / 1000));
+    obj.push_back(Pair("totalbuildms", stats.nTotalBuildMicros / 1000));
+    obj.push_back(Pair("stalls",       stats.nStalls));
+    return obj;
+}
+
+static UniValue X16RAlgoStats()
+{
+    static const char* const algoNames[16] = {
+        "blake", "bmw", "groestl", "jh", "keccak", "skein", "luffa", "cubehash",
+        "shavite", "simd", "echo", "hamsi", "fugue", "shabal", "whirlpool", "sha512"
+    };
+
+    UniValue stats(UniValue::VOBJ);
+    for (int i = 0; i < 16; i++) {
+        const uint64_t nHits = algoHashHits[i];
+        const double nSeconds = algoHashTotal[i] / 1000000000.0;
+        UniValue algo(UniValue::VOBJ);
+        algo.push_back(Pair("hashes", nHits));
+        algo.push_back(Pair("seconds", nSeconds));
+        algo.push_back(Pair("hashespersec", nSeconds > 0 ? nHits / nSeconds : 0.0));
+        stats.push_back(Pair(algoNames[i], algo));
+    }
+    return stats;
+}
+
 UniValue getmininginfo(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -228,6 +266,24 @@ UniValue getmininginfo(const JSONRPCRequest& request)
             "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
 			"  \"hashespersec\": nnn,       (numeric) Your current hashes per second\n"
 			"  \"algos\": nnn,              (string) Current solving block algos orders\n"
+            "  \"algostats\": {             (json object) Time spent by the miner in each X16R algorithm\n"
+            "     \"name\": {                 (json object) The algorithm name (blake, bmw, ...)\n"
+            "       \"hashes\": nnn,          (numeric) Messages hashed by this algorithm\n"
+            "       \"seconds\": x.xxx,       (numeric) Total time spent in this algorithm\n"
+            "       \"hashespersec\": nnn     (numeric) Average throughput of this algorithm\n"
+            "     }, ...\n"
+            "  },\n"
+            "  \"kawpowcontext\": {         (json object) KAWPOW epoch contexts shared by validation and mining\n"
+            "     \"epoch\": n,               (numeric) Epoch of the block after the active tip\n"
+            "     \"nextready\": true|false,  (boolean) Whether the following epoch has already been built\n"
+            "     \"building\": true|false,   (boolean) Whether a context is being built right now\n"
+            "     \"contexts\": n,            (numeric) Number of cached contexts\n"
+            "     \"memory\": n,              (numeric) Memory used by the cached contexts in bytes\n"
+            "     \"builds\": n,              (numeric) Contexts built since startup\n"
+            "     \"lastbuildms\": n,         (numeric) Time taken by the last build in milliseconds\n"
+            "     \"totalbuildms\": n,        (numeric) Time taken by all builds in milliseconds\n"
+            "     \"stalls\": n               (numeric) Requests that had to wait for a context to be built\n"
+            "  },\n"
             "  \"pooledtx\": n              (numeric) The size of the mempool\n"
             "  \"chain\": \"xxxx\",           (string) current network name as defined in BIP70 (main, test, regtest)\n"
             "}\n"
@@ -248,6 +304,8 @@ UniValue getmininginfo(const JSONRPCRequest& request)
     obj.push_back(Pair("networkhashps",    getnetworkhashps(request)));
     obj.push_back(Pair("hashespersec",     (double)nHashesPerSec));
 	obj.push_back(Pair("algos", (std::string)alsoHashString));
+    obj.push_back(Pair("algostats",        X16RAlgoStats()));
+    obj.push_back(Pair("kawpowcontext",    KAWPOWContextStats()));
 	obj.push_back(Pair("pooledtx",         (uint64_t)mempool.size()));
 	obj.push_back(Pair("chain",            Params().NetworkIDString()));
 
@@ -830,12 +888,9 @@ static UniValue getkawpowhash(const JSONRPCRequest& request) {
         fCheckTarget = true;
     }
 
-    static ethash::epoch_context_ptr context{nullptr, nullptr};
-
     // Get the context from the block height
     const auto epoch_number = ethash::get_epoch_number(nHeight);
-    if (!context || context->epoch_number != epoch_number)
-        context = ethash::create_epoch_context(epoch_number);
+    const CKAWPOWContextManager::ContextPtr context = GetKAWPOWContextManager().Get(epoch_number);
 
     // ProgPow hash
     const auto result = progpow::hash(*context, nHeight, header_hash, nNonce);
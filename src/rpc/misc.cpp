@@ -11,6 +11,8 @@
 #include "core_io.h"
 #include "init.h"
 #include "httpserver.h"
+#include "index/addressindex.h"
+#include "index/spentinfoindex.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/blockchain.h"
@@ -702,6 +704,104 @@ bool getAddressesFromParams(const UniValue& params, std::vector<std::pair<uint16
     return true;
 }
 
+static const int DEFAULT_ADDRESS_INDEX_PAGE_SIZE = 1000;
+static const int MAX_ADDRESS_INDEX_PAGE_SIZE = 50000;
+
+/** Where a paged address index query stopped, handed to clients as an opaque hex cursor */
+struct CAddressIndexCursor
+{
+    uint32_t nAddress = 0;
+    std::vector<unsigned char> vchKey; // Serialized index key of the last returned entry, empty to start at the first one
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nAddress);
+        READWRITE(vchKey);
+    }
+};
+
+//! Returns true if the request asked for a single page of results with "limit" or "cursor"
+bool getAddressPageFromParams(const UniValue& params, size_t& nLimit, std::string& strCursor)
+{
+    if (!params[0].isObject())
+        return false;
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (limitValue.isNull() && cursorValue.isNull())
+        return false;
+
+    int limit = DEFAULT_ADDRESS_INDEX_PAGE_SIZE;
+    if (!limitValue.isNull()) {
+        limit = limitValue.get_int();
+        if (limit < 1 || limit > MAX_ADDRESS_INDEX_PAGE_SIZE)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("limit must be between 1 and %d", MAX_ADDRESS_INDEX_PAGE_SIZE));
+    }
+
+    nLimit = limit;
+    strCursor = cursorValue.isNull() ? "" : cursorValue.get_str();
+    return true;
+}
+
+/**
+ * Read up to nLimit index entries for the addresses, resuming where strCursor stopped. read fetches the entries of one
+ * address that sort after a key. strNext is set to the cursor of the following page, or left empty after the last one.
+ */
+template <typename Key, typename Value, typename Read>
+void readAddressPage(const std::vector<std::pair<uint160, int> >& addresses, const std::string& strCursor, size_t nLimit,
+                     Read read, std::vector<std::pair<Key, Value> >& page, std::string& strNext)
+{
+    CAddressIndexCursor cursor;
+    Key after;
+    bool fAfter = false;
+
+    if (!strCursor.empty()) {
+        if (!IsHex(strCursor))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        try {
+            CDataStream ssCursor(ParseHex(strCursor), SER_DISK, CLIENT_VERSION);
+            ssCursor >> cursor;
+            if (!cursor.vchKey.empty()) {
+                CDataStream ssKey(cursor.vchKey, SER_DISK, CLIENT_VERSION);
+                ssKey >> after;
+                fAfter = true;
+            }
+        } catch (const std::exception&) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        if (cursor.nAddress >= addresses.size())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor doesn't match the addresses");
+    }
+
+    strNext.clear();
+    for (size_t i = cursor.nAddress; i < addresses.size(); i++) {
+        bool fMore = false;
+        if (!read(addresses[i].first, addresses[i].second, fAfter ? &after : nullptr, nLimit - page.size(), page, fMore)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        fAfter = false;
+
+        CAddressIndexCursor next;
+        if (fMore) {
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            ssKey << page.back().first;
+            next.nAddress = i;
+            next.vchKey.assign(ssKey.begin(), ssKey.end());
+        } else if (page.size() == nLimit && i + 1 < addresses.size()) {
+            next.nAddress = i + 1;
+        } else {
+            continue;
+        }
+
+        CDataStream ssCursor(SER_DISK, CLIENT_VERSION);
+        ssCursor << next;
+        strNext = HexStr(ssCursor.begin(), ssCursor.end());
+        return;
+    }
+}
+
 bool heightSort(std::pair<CAddressUnspentKey, CAddressUnspentValue> a,
                 std::pair<CAddressUnspentKey, CAddressUnspentValue> b) {
     return a.second.blockHeight < b.second.blockHeight;
@@ -783,6 +883,48 @@ UniValue getaddressmempool(const JSONRPCRequest& request)
     return result;
 }
 
+/** Wait for an optional index to catch up with the chain. While it is still behind it would answer with partial
+ * results, so throw instead. */
+static void EnsureIndexSynced(BaseIndex* index, const std::string& strWhat)
+{
+    if (index && !index->BlockUntilSyncedToCurrentChain())
+        throw JSONRPCError(RPC_MISC_ERROR, strWhat + " are still in the process of being indexed.");
+}
+
+UniValue addressUnspentToJSON(const CAddressUnspentKey& key, const CAddressUnspentValue& value)
+{
+    UniValue output(UniValue::VOBJ);
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    output.push_back(Pair("address", address));
+    output.push_back(Pair("txid", key.txhash.GetHex()));
+    output.push_back(Pair("outputIndex", (int)key.index));
+    output.push_back(Pair("script", HexStr(value.script.begin(), value.script.end())));
+    output.push_back(Pair("satoshis", value.satoshis));
+    output.push_back(Pair("height", value.blockHeight));
+    return output;
+}
+
+UniValue addressDeltaToJSON(const CAddressIndexKey& key, const CAmount& amount)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.push_back(Pair("satoshis", amount));
+    delta.push_back(Pair("txid", key.txhash.GetHex()));
+    delta.push_back(Pair("index", (int)key.index));
+    delta.push_back(Pair("blockindex", (int)key.txindex));
+    delta.push_back(Pair("height", key.blockHeight));
+    delta.push_back(Pair("address", address));
+    return delta;
+}
+
 UniValue getaddressutxos(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -796,6 +938,10 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            "  \"start\" (number, optional) Only return outputs created at or after this height\n"
+            "  \"end\" (number, optional) Only return outputs created at or before this height\n"
+            "  \"limit\" (number, optional) Return at most this many outputs (default: " + std::to_string(DEFAULT_ADDRESS_INDEX_PAGE_SIZE) + ", max: " + std::to_string(MAX_ADDRESS_INDEX_PAGE_SIZE) + ")\n"
+            "  \"cursor\" (string, optional) Continue after the page that returned this cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -808,8 +954,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (when limit or cursor is given):\n"
+            "{\n"
+            "  \"utxos\"  (array) The outputs as above, in index order\n"
+            "  \"cursor\"  (string) Pass this to get the next page, only present if there are more outputs\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -819,6 +971,36 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    EnsureIndexSynced(g_addressindex.get(), "Addresses");
+
+    size_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        UniValue startValue = find_value(request.params[0].get_obj(), "start");
+        UniValue endValue = find_value(request.params[0].get_obj(), "end");
+        int start = startValue.isNum() ? startValue.get_int() : 0;
+        int end = endValue.isNum() ? endValue.get_int() : 0;
+
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > page;
+        std::string strNext;
+        readAddressPage(addresses, strCursor, nLimit,
+            [start, end](const uint160& hash, int type, const CAddressUnspentKey* pAfter, size_t nRemaining,
+                         std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& vect, bool& fMore) {
+                return GetAddressUnspent(hash, type, pAfter, nRemaining, vect, fMore, start, end);
+            }, page, strNext);
+
+        UniValue utxos(UniValue::VARR);
+        for (const auto& entry : page) {
+            utxos.push_back(addressUnspentToJSON(entry.first, entry.second));
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("utxos", utxos));
+        if (!strNext.empty())
+            result.push_back(Pair("cursor", strNext));
+        return result;
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -832,19 +1014,7 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
-        UniValue output(UniValue::VOBJ);
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        output.push_back(Pair("address", address));
-        output.push_back(Pair("txid", it->first.txhash.GetHex()));
-        output.push_back(Pair("outputIndex", (int)it->first.index));
-        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
-        output.push_back(Pair("satoshis", it->second.satoshis));
-        output.push_back(Pair("height", it->second.blockHeight));
-        result.push_back(output);
+        result.push_back(addressUnspentToJSON(it->first, it->second));
     }
 
     return result;
@@ -865,6 +1035,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many deltas (default: " + std::to_string(DEFAULT_ADDRESS_INDEX_PAGE_SIZE) + ", max: " + std::to_string(MAX_ADDRESS_INDEX_PAGE_SIZE) + ")\n"
+            "  \"cursor\" (string, optional) Continue after the page that returned this cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -877,8 +1049,14 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (when limit or cursor is given):\n"
+            "{\n"
+            "  \"deltas\"  (array) The deltas as above, in index order\n"
+            "  \"cursor\"  (string) Pass this to get the next page, only present if there are more deltas\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -903,6 +1081,31 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    EnsureIndexSynced(g_addressindex.get(), "Addresses");
+
+    size_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+        std::string strNext;
+        readAddressPage(addresses, strCursor, nLimit,
+            [start, end](const uint160& hash, int type, const CAddressIndexKey* pAfter, size_t nRemaining,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, bool& fMore) {
+                return GetAddressIndex(hash, type, pAfter, nRemaining, vect, fMore, start, end);
+            }, page, strNext);
+
+        UniValue deltas(UniValue::VARR);
+        for (const auto& entry : page) {
+            deltas.push_back(addressDeltaToJSON(entry.first, entry.second));
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("deltas", deltas));
+        if (!strNext.empty())
+            result.push_back(Pair("cursor", strNext));
+        return result;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -920,19 +1123,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        result.push_back(delta);
+        result.push_back(addressDeltaToJSON(it->first, it->second));
     }
 
     return result;
@@ -968,10 +1159,12 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    EnsureIndexSynced(g_addressindex.get(), "Addresses");
+
+    std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > balances;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+        if (!GetAddressBalance((*it).first, (*it).second, balances)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
     }
@@ -979,11 +1172,9 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
-        }
-        balance += it->second;
+    for (std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >::const_iterator it=balances.begin(); it!=balances.end(); it++) {
+        received += it->second.received;
+        balance += it->second.balance;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -1009,14 +1200,22 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Read at most this many index entries (default: " + std::to_string(DEFAULT_ADDRESS_INDEX_PAGE_SIZE) + ", max: " + std::to_string(MAX_ADDRESS_INDEX_PAGE_SIZE) + ")\n"
+            "  \"cursor\" (string, optional) Continue after the page that returned this cursor\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (when limit or cursor is given):\n"
+            "{\n"
+            "  \"txids\"  (array) The transaction ids in index order. A transaction can show up again on the next page\n"
+            "  \"cursor\"  (string) Pass this to get the next page, only present if there are more entries\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -1026,6 +1225,8 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    EnsureIndexSynced(g_addressindex.get(), "Addresses");
+
     int start = 0;
     int end = 0;
     if (request.params[0].isObject()) {
@@ -1037,6 +1238,31 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    size_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+        std::string strNext;
+        readAddressPage(addresses, strCursor, nLimit,
+            [start, end](const uint160& hash, int type, const CAddressIndexKey* pAfter, size_t nRemaining,
+                         std::vector<std::pair<CAddressIndexKey, CAmount> >& vect, bool& fMore) {
+                return GetAddressIndex(hash, type, pAfter, nRemaining, vect, fMore, start, end);
+            }, page, strNext);
+
+        std::set<uint256> setSeen;
+        UniValue txids(UniValue::VARR);
+        for (const auto& entry : page) {
+            if (setSeen.insert(entry.first.txhash).second)
+                txids.push_back(entry.first.txhash.GetHex());
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("txids", txids));
+        if (!strNext.empty())
+            result.push_back(Pair("cursor", strNext));
+        return result;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -1106,6 +1332,8 @@ UniValue getspentinfo(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid txid or index");
     }
 
+    EnsureIndexSynced(g_spentindex.get(), "Spent outputs");
+
     uint256 txid = ParseHashV(txidValue, "txid");
     int outputIndex = indexValue.get_int();
 
@@ -1203,6 +1431,167 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+static UniValue HTTPTimeHistogramToJSON(const HTTPTimeHistogram& histogram)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("count", histogram.nCount));
+    obj.push_back(Pair("total_us", histogram.nTotalMicros));
+    obj.push_back(Pair("max_us", histogram.nMaxMicros));
+    UniValue buckets(UniValue::VARR);
+    for (int i = 0; i < HTTPTimeHistogram::BUCKETS; i++) {
+        if (!histogram.vBuckets[i])
+            continue;
+        UniValue bucket(UniValue::VOBJ);
+        if (i < HTTPTimeHistogram::BUCKETS - 1)
+            bucket.push_back(Pair("lt_us", (int64_t)1 << i));
+        bucket.push_back(Pair("count", histogram.vBuckets[i]));
+        buckets.push_back(bucket);
+    }
+    obj.push_back(Pair("histogram", buckets));
+    return obj;
+}
+
+UniValue getrpcqueueinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getrpcqueueinfo\n"
+            "Returns the state of the priority lanes of the HTTP work queue and, for every RPC method\n"
+            "or REST path prefix seen so far, how long its calls waited in the queue and ran.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"lanes\": [                  (array) One entry per lane, highest priority first\n"
+            "    {\n"
+            "      \"priority\": \"xxx\",       (string) high, normal or low\n"
+            "      \"queued\": n,             (numeric) Calls waiting in the lane\n"
+            "      \"running\": n,            (numeric) Calls of the lane that are running\n"
+            "      \"max_running\": n,        (numeric) Calls of the lane that may run at the same time\n"
+            "      \"max_depth\": n           (numeric) Calls that may wait in the lane, see -rpcworkqueue\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"methods\": {\n"
+            "    \"method\": {               (object) Method name, REST path prefix, \"batch\" or \"unknown\"\n"
+            "      \"priority\": \"xxx\",       (string) The lane of the method, see -rpcpriority\n"
+            "      \"max_running\": n,        (numeric, optional) Limit of calls running at the same time, see -rpcmethodthreads\n"
+            "      \"queued\": n,             (numeric) Calls waiting in the queue\n"
+            "      \"running\": n,            (numeric) Calls that are running\n"
+            "      \"processed\": n,          (numeric) Calls that have finished\n"
+            "      \"rejected\": n,           (numeric) Calls rejected because their lane was full\n"
+            "      \"queue_wait\": {          (object) Time spent in the queue\n"
+            "        \"count\": n,            (numeric) Number of calls\n"
+            "        \"total_us\": n,         (numeric) Sum of their times in microseconds\n"
+            "        \"max_us\": n,           (numeric) Longest time in microseconds\n"
+            "        \"histogram\": [         (array) Non-empty buckets, each counting the times below\n"
+            "          {                      lt_us and at least half of it\n"
+            "            \"lt_us\": n,        (numeric, optional) Upper bound in microseconds, missing for the last bucket\n"
+            "            \"count\": n         (numeric) Number of calls\n"
+            "          }, ...\n"
+            "        ]\n"
+            "      },\n"
+            "      \"exec\": { ... }          (object) Time spent running, as queue_wait\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrpcqueueinfo", "")
+            + HelpExampleRpc("getrpcqueueinfo", "")
+        );
+
+    std::vector<HTTPWorkLaneInfo> vLanes;
+    std::vector<HTTPWorkClassInfo> vClasses;
+    GetHTTPWorkQueueInfo(vLanes, vClasses);
+
+    UniValue lanes(UniValue::VARR);
+    for (const HTTPWorkLaneInfo& info : vLanes) {
+        UniValue lane(UniValue::VOBJ);
+        lane.push_back(Pair("priority", HTTPWorkPriorityName(info.priority)));
+        lane.push_back(Pair("queued", (uint64_t)info.nQueued));
+        lane.push_back(Pair("running", (uint64_t)info.nRunning));
+        lane.push_back(Pair("max_running", (uint64_t)info.nMaxRunning));
+        lane.push_back(Pair("max_depth", (uint64_t)info.nMaxDepth));
+        lanes.push_back(lane);
+    }
+
+    UniValue methods(UniValue::VOBJ);
+    for (const HTTPWorkClassInfo& info : vClasses) {
+        UniValue method(UniValue::VOBJ);
+        method.push_back(Pair("priority", HTTPWorkPriorityName(info.priority)));
+        if (info.nMaxRunning)
+            method.push_back(Pair("max_running", (uint64_t)info.nMaxRunning));
+        method.push_back(Pair("queued", (uint64_t)info.nQueued));
+        method.push_back(Pair("running", (uint64_t)info.nRunning));
+        method.push_back(Pair("processed", info.nProcessed));
+        method.push_back(Pair("rejected", info.nRejected));
+        method.push_back(Pair("queue_wait", HTTPTimeHistogramToJSON(info.queueWait)));
+        method.push_back(Pair("exec", HTTPTimeHistogramToJSON(info.execTime)));
+        methods.push_back(Pair(info.strClass, method));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("lanes", lanes));
+    result.push_back(Pair("methods", methods));
+    return result;
+}
+
+UniValue getlockprofile(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getlockprofile ( reset count )\n"
+            "Returns how long the LOCK() sites waited for and held their mutex, longest total wait first.\n"
+            "Sites are only recorded while the node runs with -lockprofile.\n"
+            "\nArguments:\n"
+            "1. reset    (boolean, optional, default=false) Clear the counters after reading them\n"
+            "2. count    (numeric, optional, default=100) Return at most this many sites\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,     (boolean) Whether lock profiling is enabled\n"
+            "  \"sites\": [\n"
+            "    {\n"
+            "      \"lock\": \"xxx\",           (string) The locked expression, e.g. cs_main\n"
+            "      \"site\": \"file:line\",     (string) Where it is locked\n"
+            "      \"acquired\": n,           (numeric) Times the site got the lock\n"
+            "      \"contended\": n,          (numeric) Times it had to wait because another thread held it\n"
+            "      \"wait_us\": n,            (numeric) Total time spent waiting in microseconds\n"
+            "      \"max_wait_us\": n,        (numeric) Longest wait in microseconds\n"
+            "      \"hold_us\": n,            (numeric) Total time the lock was held in microseconds\n"
+            "      \"max_hold_us\": n         (numeric) Longest hold in microseconds\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockprofile", "")
+            + HelpExampleCli("getlockprofile", "true 20")
+            + HelpExampleRpc("getlockprofile", "false, 20")
+        );
+
+    bool fReset = !request.params[0].isNull() && request.params[0].get_bool();
+    int nCount = request.params[1].isNull() ? 100 : request.params[1].get_int();
+    if (nCount < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+
+    std::vector<LockProfileEntry> vEntries = GetLockProfile(fReset);
+    UniValue sites(UniValue::VARR);
+    for (size_t i = 0; i < vEntries.size() && i < (size_t)nCount; i++) {
+        const LockProfileEntry& entry = vEntries[i];
+        UniValue site(UniValue::VOBJ);
+        site.push_back(Pair("lock", entry.strName));
+        site.push_back(Pair("site", strprintf("%s:%d", entry.strFile, entry.nLine)));
+        site.push_back(Pair("acquired", entry.nAcquired));
+        site.push_back(Pair("contended", entry.nContended));
+        site.push_back(Pair("wait_us", entry.nWaitMicros));
+        site.push_back(Pair("max_wait_us", entry.nMaxWaitMicros));
+        site.push_back(Pair("hold_us", entry.nHoldMicros));
+        site.push_back(Pair("max_hold_us", entry.nMaxHoldMicros));
+        sites.push_back(site);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("enabled", g_fLockProfile.load()));
+    result.push_back(Pair("sites", sites));
+    return result;
+}
+
 uint64_t getCategoryMask(UniValue cats) {
     cats = cats.get_array();
     uint64_t mask = 0;
@@ -1293,6 +1682,8 @@ static const CRPCCommand commands[] =
     { "control",            "debug",                  &debug,                  true,  {} },
     { "control",            "getinfo",                &getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,  {"mode"} },
+    { "control",            "getrpcqueueinfo",        &getrpcqueueinfo,        true,  {} },
+    { "control",            "getlockprofile",         &getlockprofile,         true,  {"reset","count"} },
     { "util",               "validateaddress",        &validateaddress,        true,  {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         true,  {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          true,  {"address","signature","message"} },
@@ -427,6 +427,23 @@ UniValue getdistributestatus(const JSONRPCRequest& request) {
                 "4. \"gross_distribution_amount\"  (number, required) The amount of the distribution asset that will be split amongst all owners\n"
                 "5. \"exception_addresses\"        (string, optional) Ownership addresses that should be excluded\n"
 
+                "\nResult:\n"
+                "{\n"
+                "  \"Asset Name\": (string),\n"
+                "  \"Height\": (string),\n"
+                "  \"Distribution Name\": (string),\n"
+                "  \"Distribution Amount\": (number),\n"
+                "  \"Status\": (number),\n"
+                "  \"Owners\": (number) owners being paid, once the distribution has been processed since startup\n"
+                "  \"Owners Processed\": (number) owners covered by the transactions so far\n"
+                "  \"Transactions\": (number) payment transactions reached so far\n"
+                "  \"Transactions Confirmed\": (number)\n"
+                "  \"Transactions Pending\": (number) transactions waiting in the mempool\n"
+                "  \"Transactions Created\": (number) transactions created in the last pass\n"
+                "  \"Complete\": (boolean) every payment transaction is confirmed\n"
+                "  \"Last Update\": (number) time of the last pass\n"
+                "}\n"
+
                 "\nExamples:\n"
                 + HelpExampleCli("getdistributestatus", "\"TRONCO\" 12345 \"RVH\" 1000")
                 + HelpExampleCli("getdistributestatus", "\"PHATSTACKS\" 12345 \"DIVIDENDS\" 1000 \"mwN7xC3yomYdvJuVXkVC7ymY9wNBjWNduD,n4Rf18edydDaRBh7t6gHUbuByLbWEoWUTg\"")
@@ -470,6 +487,19 @@ UniValue getdistributestatus(const JSONRPCRequest& request) {
     responseObj.push_back(std::make_pair("Distribution Amount", ValueFromAmount(temp.nDistributionAmount)));
     responseObj.push_back(std::make_pair("Status", temp.nStatus));
 
+    //  Progress of the last pass over the distribution, if one has run since startup
+    CDistributionProgress progress;
+    if (GetDistributionProgress(hash, progress)) {
+        responseObj.push_back(std::make_pair("Owners", progress.nOwners));
+        responseObj.push_back(std::make_pair("Owners Processed", progress.nOwnersProcessed));
+        responseObj.push_back(std::make_pair("Transactions", progress.nTransactions));
+        responseObj.push_back(std::make_pair("Transactions Confirmed", progress.nTransactionsConfirmed));
+        responseObj.push_back(std::make_pair("Transactions Pending", progress.nTransactionsPending));
+        responseObj.push_back(std::make_pair("Transactions Created", progress.nTransactionsCreated));
+        responseObj.push_back(std::make_pair("Complete", progress.fComplete));
+        responseObj.push_back(std::make_pair("Last Update", progress.nLastUpdate));
+    }
+
     return responseObj;
 }
 #endif
@@ -311,6 +311,149 @@ UniValue stop(const JSONRPCRequest& jsonRequest)
     return "RavenCash Core server stopping";
 }
 
+/** Accumulated statistics of one method, see CRPCMethodStats */
+struct CRPCMethodAccumulator
+{
+    uint64_t nCalls;
+    uint64_t nErrors;
+    int64_t nTotalMicros;
+    int64_t nMaxMicros;
+    uint64_t nBytesReturned;
+    int64_t nLockMicros;
+    //! Ring buffer of the latest latencies
+    std::vector<int64_t> vLatencies;
+    size_t nNextLatency;
+
+    CRPCMethodAccumulator() : nCalls(0), nErrors(0), nTotalMicros(0), nMaxMicros(0), nBytesReturned(0), nLockMicros(0), nNextLatency(0) {}
+};
+
+static CCriticalSection cs_rpcStats;
+static std::map<std::string, CRPCMethodAccumulator> mapRPCStats;
+
+static void RPCStatsAddCall(const std::string& strMethod, int64_t nMicros, int64_t nLockMicros, bool fError)
+{
+    LOCK(cs_rpcStats);
+    CRPCMethodAccumulator& acc = mapRPCStats[strMethod];
+    acc.nCalls++;
+    if (fError)
+        acc.nErrors++;
+    acc.nTotalMicros += nMicros;
+    acc.nMaxMicros = std::max(acc.nMaxMicros, nMicros);
+    acc.nLockMicros += nLockMicros;
+    if (acc.vLatencies.size() < RPC_STATS_LATENCY_SAMPLES) {
+        acc.vLatencies.push_back(nMicros);
+    } else {
+        acc.vLatencies[acc.nNextLatency] = nMicros;
+        acc.nNextLatency = (acc.nNextLatency + 1) % RPC_STATS_LATENCY_SAMPLES;
+    }
+}
+
+void RPCStatsAddBytesReturned(const std::string& strMethod, size_t nBytes)
+{
+    LOCK(cs_rpcStats);
+    auto it = mapRPCStats.find(strMethod);
+    if (it != mapRPCStats.end())
+        it->second.nBytesReturned += nBytes;
+}
+
+static int64_t LatencyPercentile(std::vector<int64_t>& vLatencies, double nPercentile)
+{
+    if (vLatencies.empty())
+        return 0;
+    size_t nIndex = std::min((size_t)(vLatencies.size() * nPercentile), vLatencies.size() - 1);
+    std::nth_element(vLatencies.begin(), vLatencies.begin() + nIndex, vLatencies.end());
+    return vLatencies[nIndex];
+}
+
+std::vector<CRPCMethodStats> GetRPCStats(bool fReset)
+{
+    std::vector<CRPCMethodStats> vStats;
+    LOCK(cs_rpcStats);
+    for (const auto& pair : mapRPCStats) {
+        const CRPCMethodAccumulator& acc = pair.second;
+        CRPCMethodStats stats;
+        stats.strMethod = pair.first;
+        stats.nCalls = acc.nCalls;
+        stats.nErrors = acc.nErrors;
+        stats.nTotalMicros = acc.nTotalMicros;
+        stats.nMaxMicros = acc.nMaxMicros;
+        std::vector<int64_t> vLatencies = acc.vLatencies;
+        stats.nP50Micros = LatencyPercentile(vLatencies, 0.50);
+        stats.nP99Micros = LatencyPercentile(vLatencies, 0.99);
+        stats.nBytesReturned = acc.nBytesReturned;
+        stats.nLockMicros = acc.nLockMicros;
+        vStats.push_back(stats);
+    }
+    if (fReset)
+        mapRPCStats.clear();
+    return vStats;
+}
+
+/** Records the duration and cs_main hold time of an RPC call when it goes out of scope */
+class CRPCCallTimer
+{
+private:
+    const std::string& strMethod;
+    int64_t nTimeStart;
+    int64_t nLockStart;
+
+public:
+    bool fSuccess;
+
+    explicit CRPCCallTimer(const std::string& strMethodIn) :
+        strMethod(strMethodIn), nTimeStart(GetTimeMicros()), nLockStart(GetThreadHoldTimeMicros()), fSuccess(false) {}
+    ~CRPCCallTimer()
+    {
+        RPCStatsAddCall(strMethod, GetTimeMicros() - nTimeStart, GetThreadHoldTimeMicros() - nLockStart, !fSuccess);
+    }
+};
+
+UniValue getrpcstats(const JSONRPCRequest& jsonRequest)
+{
+    if (jsonRequest.fHelp || jsonRequest.params.size() > 1)
+        throw std::runtime_error(
+                "getrpcstats ( reset )\n"
+                        "\nReturns call statistics of every RPC method called since startup or the last reset.\n"
+                        "\nArguments:\n"
+                        "1. reset        (boolean, optional, default=false) Clear the statistics after returning them\n"
+                        "\nResult:\n"
+                        "{\n"
+                        "  \"method\": {\n"
+                        "    \"calls\": n,              (numeric) Number of calls\n"
+                        "    \"errors\": n,             (numeric) Number of calls that failed\n"
+                        "    \"total_us\": n,           (numeric) Total time of the calls in microseconds\n"
+                        "    \"avg_us\": n,             (numeric) Average time of a call\n"
+                        "    \"p50_us\": n,             (numeric) Median time of the last " + std::to_string(RPC_STATS_LATENCY_SAMPLES) + " calls\n"
+                        "    \"p99_us\": n,             (numeric) 99th percentile time of the last " + std::to_string(RPC_STATS_LATENCY_SAMPLES) + " calls\n"
+                        "    \"max_us\": n,             (numeric) Longest call\n"
+                        "    \"bytes_returned\": n,     (numeric) Size of the replies sent for calls in single (non-batch) HTTP requests\n"
+                        "    \"cs_main_us\": n          (numeric) Time the calls held the main lock, only measured with -rpcstatslocktime\n"
+                        "  }, ...\n"
+                        "}\n"
+                        "\nExamples:\n"
+                + HelpExampleCli("getrpcstats", "")
+                + HelpExampleRpc("getrpcstats", "")
+        );
+
+    bool fReset = !jsonRequest.params[0].isNull() && jsonRequest.params[0].get_bool();
+
+    UniValue result(UniValue::VOBJ);
+    for (const CRPCMethodStats& stats : GetRPCStats(fReset)) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("calls", stats.nCalls));
+        obj.push_back(Pair("errors", stats.nErrors));
+        obj.push_back(Pair("total_us", stats.nTotalMicros));
+        obj.push_back(Pair("avg_us", stats.nCalls ? stats.nTotalMicros / (int64_t)stats.nCalls : 0));
+        obj.push_back(Pair("p50_us", stats.nP50Micros));
+        obj.push_back(Pair("p99_us", stats.nP99Micros));
+        obj.push_back(Pair("max_us", stats.nMaxMicros));
+        obj.push_back(Pair("bytes_returned", stats.nBytesReturned));
+        obj.push_back(Pair("cs_main_us", stats.nLockMicros));
+        result.push_back(Pair(stats.strMethod, obj));
+    }
+    return result;
+}
+
 UniValue uptime(const JSONRPCRequest& jsonRequest)
 {
     if (jsonRequest.fHelp || jsonRequest.params.size() > 1)
@@ -337,6 +480,7 @@ static const CRPCCommand vRPCCommands[] =
     { "control",            "help",                   &help,                   true,  {"command"}  },
     { "control",            "stop",                   &stop,                   true,  {"wait"}  },
     { "control",            "uptime",                 &uptime,                 true,  {}  },
+    { "control",            "getrpcstats",            &getrpcstats,            true,  {"reset"}  },
 };
 
 CRPCTable::CRPCTable()
@@ -376,6 +520,9 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
 bool StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    // Let RPC calls report how long they held cs_main. This times every lock of cs_main, so it is opt-in.
+    if (gArgs.GetBoolArg("-rpcstatslocktime", DEFAULT_RPC_STATS_LOCK_TIME))
+        SetHoldTimeMutex(&cs_main);
     fRPCRunning = true;
     g_rpcSignals.Started();
     return true;
@@ -551,14 +698,18 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 
     g_rpcSignals.PreCommand(*pcmd);
 
+    CRPCCallTimer timer(pcmd->name);
     try
     {
         // Execute, convert arguments to array if necessary
+        UniValue result;
         if (request.params.isObject()) {
-            return pcmd->actor(transformNamedArguments(request, pcmd->argNames));
+            result = pcmd->actor(transformNamedArguments(request, pcmd->argNames));
         } else {
-            return pcmd->actor(request);
+            result = pcmd->actor(request);
         }
+        timer.fSuccess = true;
+        return result;
     }
     catch (const std::exception& e)
     {
@@ -35,6 +35,8 @@ struct UniValueType {
     UniValue::VType type;
 };
 
+class JSONStreamWriter;
+
 class JSONRPCRequest
 {
 public:
@@ -44,8 +46,13 @@ public:
     bool fHelp;
     std::string URI;
     std::string authUser;
+    /**
+     * Set when the reply can be streamed. Commands with large results may write their result
+     * into it and return NullUniValue instead of building the whole result in memory.
+     */
+    JSONStreamWriter* pStreamWriter;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), pStreamWriter(nullptr) {}
     void parse(const UniValue& valRequest);
 };
 
@@ -172,6 +179,34 @@ public:
 
 extern CRPCTable tableRPC;
 
+/** Statistics of the calls of one RPC method, see getrpcstats */
+struct CRPCMethodStats
+{
+    std::string strMethod;
+    uint64_t nCalls;
+    uint64_t nErrors;
+    int64_t nTotalMicros;
+    int64_t nMaxMicros;
+    //! Percentiles over the last RPC_STATS_LATENCY_SAMPLES calls
+    int64_t nP50Micros;
+    int64_t nP99Micros;
+    //! Sum of the reply sizes of the calls made through single HTTP requests
+    uint64_t nBytesReturned;
+    //! Time the calls held cs_main
+    int64_t nLockMicros;
+};
+
+/** Measure how long RPC calls hold cs_main for getrpcstats, which times every cs_main lock */
+static const bool DEFAULT_RPC_STATS_LOCK_TIME = false;
+
+/** Number of latencies kept per method for the percentiles */
+static const size_t RPC_STATS_LATENCY_SAMPLES = 1024;
+
+/** Get the statistics of every method called so far, and clear them if fReset is set */
+std::vector<CRPCMethodStats> GetRPCStats(bool fReset = false);
+/** Add the size of a reply to the statistics of its method */
+void RPCStatsAddBytesReturned(const std::string& strMethod, size_t nBytes);
+
 /**
  * Utilities: convert hex-encoded Values
  * (throws error if not hex).
@@ -7,10 +7,177 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <algorithm>
+#include <chrono>
 #include <stdio.h>
 
 #include <boost/thread.hpp>
 
+std::atomic<void*> g_pHoldTimeMutex(nullptr);
+
+//! Recursion depth of the current thread on g_pHoldTimeMutex and when it got hold of it, in steady clock nanoseconds
+static thread_local int nHoldTimeDepth = 0;
+static thread_local int64_t nHoldTimeStart = 0;
+static thread_local int64_t nHoldTimeTotal = 0;
+
+static inline int64_t HoldTimeNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SetHoldTimeMutex(void* cs)
+{
+    g_pHoldTimeMutex = cs;
+}
+
+int64_t GetThreadHoldTimeMicros()
+{
+    int64_t nTotal = nHoldTimeTotal;
+    if (nHoldTimeDepth > 0)
+        nTotal += HoldTimeNanos() - nHoldTimeStart;
+    return nTotal / 1000;
+}
+
+void HoldTimeEnter()
+{
+    if (nHoldTimeDepth++ == 0)
+        nHoldTimeStart = HoldTimeNanos();
+}
+
+void HoldTimeLeave()
+{
+    if (nHoldTimeDepth > 0 && --nHoldTimeDepth == 0)
+        nHoldTimeTotal += HoldTimeNanos() - nHoldTimeStart;
+}
+
+std::atomic<bool> g_fLockProfile(false);
+
+/** One lock site of the profile. Slots are claimed once and never released. */
+struct LockProfileSlot
+{
+    //! Identifies the site: its file name pointer and line, 0 while the slot is free
+    std::atomic<uint64_t> nKey;
+    //! Set once strName, strFile and nLine are written
+    std::atomic<bool> fReady;
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    std::atomic<uint64_t> nAcquired;
+    std::atomic<uint64_t> nContended;
+    std::atomic<uint64_t> nWaitTicks;
+    std::atomic<uint64_t> nMaxWaitTicks;
+    std::atomic<uint64_t> nHoldTicks;
+    std::atomic<uint64_t> nMaxHoldTicks;
+};
+
+static const int LOCK_PROFILE_SLOTS = 4096;
+static LockProfileSlot lockProfileSlots[LOCK_PROFILE_SLOTS];
+static double dLockProfileTicksPerMicro = 1;
+
+static void AtomicMax(std::atomic<uint64_t>& nMax, uint64_t nValue)
+{
+    uint64_t nCurrent = nMax.load(std::memory_order_relaxed);
+    while (nValue > nCurrent && !nMax.compare_exchange_weak(nCurrent, nValue, std::memory_order_relaxed)) {}
+}
+
+int LockProfileSite(const char* pszName, const char* pszFile, int nLine)
+{
+    // __FILE__ strings live as long as the program, so their address and the line identify the site
+    const uint64_t nKey = ((uint64_t)(uintptr_t)pszFile << 16) ^ (uint64_t)(nLine & 0xffff) ^ 1;
+    size_t nSlot = (size_t)((nKey * 0x9E3779B97F4A7C15ULL) >> 52) % LOCK_PROFILE_SLOTS;
+    for (int i = 0; i < LOCK_PROFILE_SLOTS; i++, nSlot = (nSlot + 1) % LOCK_PROFILE_SLOTS) {
+        LockProfileSlot& slot = lockProfileSlots[nSlot];
+        uint64_t nSlotKey = slot.nKey.load(std::memory_order_acquire);
+        if (nSlotKey == nKey)
+            return nSlot;
+        if (nSlotKey != 0)
+            continue;
+        uint64_t nExpected = 0;
+        if (slot.nKey.compare_exchange_strong(nExpected, nKey)) {
+            slot.strName = pszName;
+            slot.strFile = pszFile;
+            slot.nLine = nLine;
+            slot.fReady.store(true, std::memory_order_release);
+            return nSlot;
+        }
+        if (nExpected == nKey)
+            return nSlot;
+    }
+    return -1;
+}
+
+void LockProfileAcquired(int nSite, bool fContended, uint64_t nWaitTicks)
+{
+    if (nSite < 0)
+        return;
+    LockProfileSlot& slot = lockProfileSlots[nSite];
+    slot.nAcquired.fetch_add(1, std::memory_order_relaxed);
+    if (fContended) {
+        slot.nContended.fetch_add(1, std::memory_order_relaxed);
+        slot.nWaitTicks.fetch_add(nWaitTicks, std::memory_order_relaxed);
+        AtomicMax(slot.nMaxWaitTicks, nWaitTicks);
+    }
+}
+
+void LockProfileReleased(int nSite, uint64_t nHoldTicks)
+{
+    LockProfileSlot& slot = lockProfileSlots[nSite];
+    slot.nHoldTicks.fetch_add(nHoldTicks, std::memory_order_relaxed);
+    AtomicMax(slot.nMaxHoldTicks, nHoldTicks);
+}
+
+void EnableLockProfile(bool fEnable)
+{
+    if (fEnable && !g_fLockProfile) {
+        int64_t nTimeStart = GetTimeMicros();
+        uint64_t nTicksStart = LockProfileTicks();
+        MilliSleep(10);
+        int64_t nMicros = GetTimeMicros() - nTimeStart;
+        if (nMicros > 0)
+            dLockProfileTicksPerMicro = std::max((double)(LockProfileTicks() - nTicksStart) / nMicros, 1e-3);
+        LogPrintf("Lock profiling enabled (%.1f ticks per microsecond)\n", dLockProfileTicksPerMicro);
+    }
+    g_fLockProfile = fEnable;
+}
+
+std::vector<LockProfileEntry> GetLockProfile(bool fReset)
+{
+    std::vector<LockProfileEntry> vEntries;
+    auto micros = [](uint64_t nTicks) { return (int64_t)(nTicks / dLockProfileTicksPerMicro); };
+    for (LockProfileSlot& slot : lockProfileSlots) {
+        if (!slot.fReady.load(std::memory_order_acquire))
+            continue;
+        LockProfileEntry entry;
+        entry.strName = slot.strName;
+        entry.strFile = slot.strFile;
+        entry.nLine = slot.nLine;
+        entry.nAcquired = fReset ? slot.nAcquired.exchange(0) : slot.nAcquired.load();
+        entry.nContended = fReset ? slot.nContended.exchange(0) : slot.nContended.load();
+        entry.nWaitMicros = micros(fReset ? slot.nWaitTicks.exchange(0) : slot.nWaitTicks.load());
+        entry.nMaxWaitMicros = micros(fReset ? slot.nMaxWaitTicks.exchange(0) : slot.nMaxWaitTicks.load());
+        entry.nHoldMicros = micros(fReset ? slot.nHoldTicks.exchange(0) : slot.nHoldTicks.load());
+        entry.nMaxHoldMicros = micros(fReset ? slot.nMaxHoldTicks.exchange(0) : slot.nMaxHoldTicks.load());
+        if (entry.nAcquired)
+            vEntries.push_back(entry);
+    }
+    std::sort(vEntries.begin(), vEntries.end(), [](const LockProfileEntry& a, const LockProfileEntry& b) {
+        return a.nWaitMicros > b.nWaitMicros;
+    });
+    return vEntries;
+}
+
+void LogLockProfile(size_t nSites)
+{
+    std::vector<LockProfileEntry> vEntries = GetLockProfile();
+    LogPrintf("Lock profile, %u sites with the longest wait:\n", std::min(nSites, vEntries.size()));
+    for (size_t i = 0; i < vEntries.size() && i < nSites; i++) {
+        const LockProfileEntry& entry = vEntries[i];
+        LogPrintf("  %s %s:%d acquired=%u contended=%u wait=%dus (max %dus) hold=%dus (max %dus)\n",
+            entry.strName, entry.strFile, entry.nLine, entry.nAcquired, entry.nContended,
+            entry.nWaitMicros, entry.nMaxWaitMicros, entry.nHoldMicros, entry.nMaxHoldMicros);
+    }
+}
+
 #ifdef DEBUG_LOCKCONTENTION
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 {
@@ -8,6 +8,16 @@
 
 #include "threadsafety.h"
 
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
@@ -109,37 +119,131 @@ typedef boost::condition_variable CConditionVariable;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * The time each thread holds one chosen mutex is added up, so that work such as an RPC call
+ * can report how long it held it (used for cs_main with -rpcstatslocktime). Only the outermost
+ * lock of a recursive mutex is timed. While no mutex is chosen a lock pays for one relaxed load.
+ */
+extern std::atomic<void*> g_pHoldTimeMutex;
+/** Choose the mutex whose hold time is measured. Call it before other threads lock it. */
+void SetHoldTimeMutex(void* cs);
+/** Microseconds the current thread has held the chosen mutex so far */
+int64_t GetThreadHoldTimeMicros();
+void HoldTimeEnter();
+void HoldTimeLeave();
+
+/**
+ * Lock contention profiler, enabled with -lockprofile. Every LOCK() site records how often it
+ * got its mutex, how often it had to wait for it and how long it waited and held it. While
+ * disabled a lock pays for one relaxed load.
+ */
+static const bool DEFAULT_LOCK_PROFILE = false;
+/** Seconds between dumps of the lock profile to the log, 0 for none */
+static const int64_t DEFAULT_LOCK_PROFILE_INTERVAL = 600;
+/** Number of lock sites in a log dump */
+static const size_t LOCK_PROFILE_LOG_SITES = 20;
+
+extern std::atomic<bool> g_fLockProfile;
+
+/** Timestamp of the lock profiler: the TSC where available */
+static inline uint64_t LockProfileTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/** Return the slot of a lock site in the profile, -1 if the profile is full */
+int LockProfileSite(const char* pszName, const char* pszFile, int nLine);
+void LockProfileAcquired(int nSite, bool fContended, uint64_t nWaitTicks);
+void LockProfileReleased(int nSite, uint64_t nHoldTicks);
+
+struct LockProfileEntry
+{
+    std::string strName;
+    std::string strFile;
+    int nLine;
+    uint64_t nAcquired;
+    uint64_t nContended;
+    int64_t nWaitMicros;
+    int64_t nMaxWaitMicros;
+    int64_t nHoldMicros;
+    int64_t nMaxHoldMicros;
+};
+
+/** Start or stop profiling. Starting calibrates the timestamps, which takes about 10ms. */
+void EnableLockProfile(bool fEnable);
+/** Get the profile of every lock site, sorted by total wait time, and clear it if fReset is set */
+std::vector<LockProfileEntry> GetLockProfile(bool fReset = false);
+/** Write the nSites lock sites with the longest total wait to the log */
+void LogLockProfile(size_t nSites);
+
 /** Wrapper around boost::unique_lock<Mutex> */
 template <typename Mutex>
 class SCOPED_LOCKABLE CMutexLock
 {
 private:
     boost::unique_lock<Mutex> lock;
+    //! Lock profile slot of this lock site, -1 if the lock isn't profiled
+    int nProfileSite;
+    uint64_t nProfileStart;
 
-    void Enter(const char* pszName, const char* pszFile, int nLine)
+    void EnterProfiled(const char* pszName, const char* pszFile, int nLine)
     {
-        EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
+        uint64_t nStart = LockProfileTicks();
+        bool fContended = !lock.try_lock();
+        if (fContended) {
 #ifdef DEBUG_LOCKCONTENTION
-        if (!lock.try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
 #endif
             lock.lock();
-#ifdef DEBUG_LOCKCONTENTION
         }
+        nProfileStart = LockProfileTicks();
+        nProfileSite = LockProfileSite(pszName, pszFile, nLine);
+        LockProfileAcquired(nProfileSite, fContended, fContended ? nProfileStart - nStart : 0);
+    }
+
+    void Enter(const char* pszName, const char* pszFile, int nLine)
+    {
+        EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
+        if (g_fLockProfile.load(std::memory_order_relaxed)) {
+            EnterProfiled(pszName, pszFile, nLine);
+        } else {
+#ifdef DEBUG_LOCKCONTENTION
+            if (!lock.try_lock()) {
+                PrintLockContention(pszName, pszFile, nLine);
 #endif
+                lock.lock();
+#ifdef DEBUG_LOCKCONTENTION
+            }
+#endif
+        }
+        if ((void*)lock.mutex() == g_pHoldTimeMutex.load(std::memory_order_relaxed))
+            HoldTimeEnter();
     }
 
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()), true);
         lock.try_lock();
-        if (!lock.owns_lock())
+        if (!lock.owns_lock()) {
             LeaveCritical();
-        return lock.owns_lock();
+            return false;
+        }
+        if (g_fLockProfile.load(std::memory_order_relaxed)) {
+            nProfileStart = LockProfileTicks();
+            nProfileSite = LockProfileSite(pszName, pszFile, nLine);
+            LockProfileAcquired(nProfileSite, false, 0);
+        }
+        if ((void*)lock.mutex() == g_pHoldTimeMutex.load(std::memory_order_relaxed))
+            HoldTimeEnter();
+        return true;
     }
 
 public:
-    CMutexLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, boost::defer_lock)
+    CMutexLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : lock(mutexIn, boost::defer_lock), nProfileSite(-1), nProfileStart(0)
     {
         if (fTry)
             TryEnter(pszName, pszFile, nLine);
@@ -147,7 +251,7 @@ public:
             Enter(pszName, pszFile, nLine);
     }
 
-    CMutexLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn)
+    CMutexLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn) : nProfileSite(-1), nProfileStart(0)
     {
         if (!pmutexIn) return;
 
@@ -160,8 +264,13 @@ public:
 
     ~CMutexLock() UNLOCK_FUNCTION()
     {
-        if (lock.owns_lock())
+        if (lock.owns_lock()) {
+            if (nProfileSite >= 0)
+                LockProfileReleased(nProfileSite, LockProfileTicks() - nProfileStart);
+            if ((void*)lock.mutex() == g_pHoldTimeMutex.load(std::memory_order_relaxed))
+                HoldTimeLeave();
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -179,16 +288,20 @@ typedef CMutexLock<CCriticalSection> CCriticalBlock;
 #define LOCK2(cs1, cs2) CCriticalBlock criticalblock1(cs1, #cs1, __FILE__, __LINE__), criticalblock2(cs2, #cs2, __FILE__, __LINE__)
 #define TRY_LOCK(cs, name) CCriticalBlock name(cs, #cs, __FILE__, __LINE__, true)
 
-#define ENTER_CRITICAL_SECTION(cs)                            \
-    {                                                         \
-        EnterCritical(#cs, __FILE__, __LINE__, (void*)(&cs)); \
-        (cs).lock();                                          \
+#define ENTER_CRITICAL_SECTION(cs)                                            \
+    {                                                                         \
+        EnterCritical(#cs, __FILE__, __LINE__, (void*)(&cs));                 \
+        (cs).lock();                                                          \
+        if ((void*)(&cs) == g_pHoldTimeMutex.load(std::memory_order_relaxed)) \
+            HoldTimeEnter();                                                  \
     }
 
-#define LEAVE_CRITICAL_SECTION(cs) \
-    {                              \
-        (cs).unlock();             \
-        LeaveCritical();           \
+#define LEAVE_CRITICAL_SECTION(cs)                                            \
+    {                                                                         \
+        if ((void*)(&cs) == g_pHoldTimeMutex.load(std::memory_order_relaxed)) \
+            HoldTimeLeave();                                                  \
+        (cs).unlock();                                                        \
+        LeaveCritical();                                                      \
     }
 
 class CSemaphore
@@ -2,6 +2,8 @@
 #include "assets/assets.h"
 #include <boost/test/unit_test.hpp>
 #include <test/test_ravencash.h>
+#include <chainparams.h>
+#include <validation.h>
 
 BOOST_FIXTURE_TEST_SUITE(cache_tests, BasicTestingSetup)
 
@@ -37,5 +39,51 @@ BOOST_AUTO_TEST_CASE(cache_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(layered_cache_test)
+{
+    BOOST_TEST_MESSAGE("Running Layered Cache Test");
+
+    SelectParams(CBaseChainParams::MAIN);
+
+    fAssetIndex = true;
+    CAssetsCache* pOldAssets = passets;
+    CAssetsCache globalCache;
+    passets = &globalCache;
+
+    std::string address = Params().GlobalBurnAddress();
+    uint256 hash = uint256();
+
+    // The middle layer reads through to passets, the top layer reads through to both
+    CAssetsCache base;
+    CNewAsset asset1("LAYERA", CAmount(100 * COIN), 8, 1, 0, "");
+    BOOST_CHECK_MESSAGE(globalCache.AddNewAsset(asset1, address, 0, hash), "Failed to add LAYERA to passets");
+
+    CNewAsset asset2("LAYERB", CAmount(50 * COIN), 8, 1, 0, "");
+    BOOST_CHECK_MESSAGE(base.AddNewAsset(asset2, address, 0, hash), "Failed to add LAYERB to the base cache");
+
+    CAssetsCache child(&base);
+    BOOST_CHECK_MESSAGE(child.mapAssetsAddressAmount.empty() && child.setNewAssetsToAdd.empty(), "Layered cache should start empty");
+    BOOST_CHECK_MESSAGE(child.CheckIfAssetExists("LAYERA"), "Child didn't see the asset in passets");
+    BOOST_CHECK_MESSAGE(child.CheckIfAssetExists("LAYERB"), "Child didn't see the asset in its base");
+
+    CNewAsset readAsset;
+    BOOST_CHECK_MESSAGE(child.GetAssetMetaDataIfExists("LAYERB", readAsset) && readAsset.nAmount == CAmount(50 * COIN), "Child didn't read the metadata from its base");
+    BOOST_CHECK_MESSAGE(GetBestAssetAddressAmount(child, "LAYERB", address) && child.mapAssetsAddressAmount.at(make_pair(std::string("LAYERB"), address)) == CAmount(50 * COIN), "Child didn't read the balance from its base");
+
+    // Changes stay in the child until it is flushed into its base
+    CNewAsset asset3("LAYERC", CAmount(10 * COIN), 8, 1, 0, "");
+    BOOST_CHECK_MESSAGE(child.AddNewAsset(asset3, address, 0, hash), "Failed to add LAYERC to the child cache");
+    BOOST_CHECK_MESSAGE(!base.CheckIfAssetExists("LAYERC"), "Base saw an asset that wasn't flushed yet");
+
+    BOOST_CHECK_MESSAGE(child.Flush(), "Failed to flush the child cache");
+    BOOST_CHECK_MESSAGE(base.CheckIfAssetExists("LAYERC"), "Base didn't get the flushed asset");
+    BOOST_CHECK_MESSAGE(!globalCache.CheckIfAssetExists("LAYERC"), "Child flushed past its base into passets");
+
+    BOOST_CHECK_MESSAGE(base.Flush(), "Failed to flush the base cache");
+    BOOST_CHECK_MESSAGE(globalCache.CheckIfAssetExists("LAYERB") && globalCache.CheckIfAssetExists("LAYERC"), "passets didn't get the flushed assets");
+
+    passets = pOldAssets;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -368,4 +368,32 @@ BOOST_FIXTURE_TEST_SUITE(verifier_string_tests, BasicTestingSetup)
     }
 
 
+    BOOST_AUTO_TEST_CASE(compiled_verifier_string_test)
+    {
+        BOOST_TEST_MESSAGE("Running Compiled Verifier String Test");
+
+        std::vector<std::string> vars = {"ABC", "DEF", "KYC", "US"};
+
+        // The compiled formula must agree with resolve for every valuation
+        for (const std::string& formula : {"KYC&!ABC", "((KYC&!ABC)|DEF&US)|(US)", "!(KYC|ABC)&1", "0|!!DEF", "((((US))))", "KYC&US&DEF&ABC"}) {
+            LibBoolEE::Compiled compiled = LibBoolEE::compile(formula, vars);
+            for (uint64_t valuation = 0; valuation < 16; valuation++) {
+                LibBoolEE::Vals vals;
+                for (size_t i = 0; i < vars.size(); i++)
+                    vals.insert(std::make_pair(vars[i], (valuation >> i) & 1));
+                BOOST_CHECK_MESSAGE(compiled.evaluate(valuation) == LibBoolEE::resolve(formula, vals), "Compiled formula mismatch - " + formula);
+            }
+        }
+
+        // And fail to compile exactly where resolve throws
+        for (const std::string& formula : {"KYC|MISS", "BAD -- EXPRESSION -- BUST", "(KYC&US", "KYC&&US", "KYC||US", "KYC&", "()"}) {
+            LibBoolEE::Vals vals;
+            for (const auto& var : vars)
+                vals.insert(std::make_pair(var, true));
+            BOOST_CHECK_THROW(LibBoolEE::resolve(formula, vals), std::runtime_error);
+            BOOST_CHECK_THROW(LibBoolEE::compile(formula, vars), std::runtime_error);
+        }
+    }
+
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,274 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+
+#include "assets/assets.h"
+#include "chainparams.h"
+#include "index/blockfilterindex.h"
+#include "script/standard.h"
+#include "streams.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "test/test_ravencash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilter_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(bitstream_reader_writer)
+{
+    CDataStream stream(SER_NETWORK, INIT_PROTO_VERSION);
+
+    BitStreamWriter<CDataStream> bit_writer(stream);
+    bit_writer.Write(0, 1);
+    bit_writer.Write(2, 2);
+    bit_writer.Write(6, 3);
+    bit_writer.Write(11, 4);
+    bit_writer.Write(1, 5);
+    bit_writer.Write(32, 6);
+    bit_writer.Write(7, 7);
+    bit_writer.Write(30497, 16);
+    bit_writer.Flush();
+
+    CDataStream stream_copy(stream);
+    uint32_t serialized_int1;
+    stream >> serialized_int1;
+    BOOST_CHECK_EQUAL(serialized_int1, (uint32_t)0x7700C35A); // NOTE: Serialized as LE
+    uint16_t serialized_int2;
+    stream >> serialized_int2;
+    BOOST_CHECK_EQUAL(serialized_int2, (uint16_t)0x1072); // NOTE: Serialized as LE
+
+    BitStreamReader<CDataStream> bit_reader(stream_copy);
+    BOOST_CHECK_EQUAL(bit_reader.Read(1), 0);
+    BOOST_CHECK_EQUAL(bit_reader.Read(2), 2);
+    BOOST_CHECK_EQUAL(bit_reader.Read(3), 6);
+    BOOST_CHECK_EQUAL(bit_reader.Read(4), 11);
+    BOOST_CHECK_EQUAL(bit_reader.Read(5), 1);
+    BOOST_CHECK_EQUAL(bit_reader.Read(6), 32);
+    BOOST_CHECK_EQUAL(bit_reader.Read(7), 7);
+    BOOST_CHECK_EQUAL(bit_reader.Read(16), 30497);
+    BOOST_CHECK_THROW(bit_reader.Read(8), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_test)
+{
+    GCSFilter::ElementSet included_elements, excluded_elements;
+    for (int i = 0; i < 100; ++i) {
+        GCSFilter::Element element1(32);
+        element1[0] = i;
+        included_elements.insert(std::move(element1));
+
+        GCSFilter::Element element2(32);
+        element2[1] = i;
+        excluded_elements.insert(std::move(element2));
+    }
+
+    GCSFilter filter({0, 0, 10, 1 << 10}, included_elements);
+    for (const auto& element : included_elements) {
+        BOOST_CHECK(filter.Match(element));
+
+        auto insertion = excluded_elements.insert(element);
+        BOOST_CHECK(filter.MatchAny(excluded_elements));
+        excluded_elements.erase(insertion.first);
+    }
+
+    // A filter decoded from its encoding matches the same elements, and one with missing data is rejected
+    GCSFilter decoded(filter.GetParams(), filter.GetEncoded());
+    BOOST_CHECK_EQUAL(decoded.GetN(), filter.GetN());
+    for (const auto& element : included_elements) {
+        BOOST_CHECK(decoded.Match(element));
+    }
+    std::vector<unsigned char> truncated(filter.GetEncoded().begin(), filter.GetEncoded().end() - 1);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), truncated), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
+{
+    GCSFilter filter;
+    BOOST_CHECK_EQUAL(filter.GetN(), 0);
+    BOOST_CHECK_EQUAL(filter.GetEncoded().size(), 1);
+
+    const GCSFilter::Params& params = filter.GetParams();
+    BOOST_CHECK_EQUAL(params.m_siphash_k0, 0);
+    BOOST_CHECK_EQUAL(params.m_siphash_k1, 0);
+    BOOST_CHECK_EQUAL(params.m_P, 0);
+    BOOST_CHECK_EQUAL(params.m_M, 1);
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_basic_test)
+{
+    CScript included_scripts[5], excluded_scripts[3];
+
+    // First two are outputs on a single transaction.
+    included_scripts[0] << std::vector<unsigned char>(0, 65) << OP_CHECKSIG;
+    included_scripts[1] << OP_DUP << OP_HASH160 << std::vector<unsigned char>(1, 20) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    // Third is an output on in a second transaction.
+    included_scripts[2] << OP_1 << std::vector<unsigned char>(2, 33) << OP_1 << OP_CHECKMULTISIG;
+
+    // Last two are spent by a single transaction.
+    included_scripts[3] << OP_0 << std::vector<unsigned char>(3, 32);
+    included_scripts[4] << OP_4 << OP_ADD << OP_8 << OP_EQUAL;
+
+    // OP_RETURN output is an output on the second transaction.
+    excluded_scripts[0] << OP_RETURN << std::vector<unsigned char>(4, 40);
+
+    // This script is not related to the block at all.
+    excluded_scripts[1] << std::vector<unsigned char>(5, 33) << OP_CHECKSIG;
+
+    // An asset transfer to the P2PKH of included_scripts[1]. The holder script is the first 25 bytes.
+    CScript asset_script = included_scripts[1];
+    CAssetTransfer("TEST", COIN).ConstructTransaction(asset_script);
+    BOOST_CHECK(asset_script.IsAssetScript());
+
+    // The holder of this asset output doesn't appear anywhere else in the block
+    CScript other_holder;
+    other_holder << OP_DUP << OP_HASH160 << std::vector<unsigned char>(6, 20) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript other_asset_script = other_holder;
+    CAssetTransfer("TEST", COIN).ConstructTransaction(other_asset_script);
+    BOOST_CHECK(other_asset_script.IsAssetScript());
+
+    // Empty scripts are never added.
+    excluded_scripts[2] = CScript();
+
+    CMutableTransaction tx_1;
+    tx_1.vout.emplace_back(100, included_scripts[0]);
+    tx_1.vout.emplace_back(200, included_scripts[1]);
+    tx_1.vout.emplace_back(0, excluded_scripts[2]);
+
+    CMutableTransaction tx_2;
+    tx_2.vout.emplace_back(300, included_scripts[2]);
+    tx_2.vout.emplace_back(0, excluded_scripts[0]);
+    tx_2.vout.emplace_back(400, asset_script);
+    tx_2.vout.emplace_back(400, other_asset_script);
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(tx_1));
+    block.vtx.push_back(MakeTransactionRef(tx_2));
+
+    CBlockUndo block_undo;
+    block_undo.vtxundo.emplace_back();
+    block_undo.vtxundo.back().vprevout.emplace_back(CTxOut(500, included_scripts[3]), 1000, true);
+    block_undo.vtxundo.back().vprevout.emplace_back(CTxOut(600, included_scripts[4]), 10000, false);
+
+    uint256 block_hash = GetRandHash();
+    BlockFilter block_filter(BlockFilterType::BASIC, block_hash, block, block_undo);
+    const GCSFilter& filter = block_filter.GetFilter();
+
+    for (const CScript& script : included_scripts) {
+        BOOST_CHECK(filter.Match(GCSFilter::Element(script.begin(), script.end())));
+    }
+    for (const CScript& script : excluded_scripts) {
+        BOOST_CHECK(!filter.Match(GCSFilter::Element(script.begin(), script.end())));
+    }
+    BOOST_CHECK(filter.Match(GCSFilter::Element(asset_script.begin(), asset_script.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(other_holder.begin(), other_holder.end())));
+
+    // Test serialization/unserialization.
+    BlockFilter block_filter2;
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block_filter;
+    stream >> block_filter2;
+
+    BOOST_CHECK(block_filter.GetFilterType() == block_filter2.GetFilterType());
+    BOOST_CHECK(block_filter.GetBlockHash() == block_filter2.GetBlockHash());
+    BOOST_CHECK(block_filter.GetEncodedFilter() == block_filter2.GetEncodedFilter());
+
+    BlockFilter default_ctor_block_filter_1;
+    BlockFilter default_ctor_block_filter_2;
+    BOOST_CHECK(default_ctor_block_filter_1.GetFilterType() == default_ctor_block_filter_2.GetFilterType());
+    BOOST_CHECK(default_ctor_block_filter_1.GetBlockHash() == default_ctor_block_filter_2.GetBlockHash());
+    BOOST_CHECK(default_ctor_block_filter_1.GetEncodedFilter() == default_ctor_block_filter_2.GetEncodedFilter());
+
+    // The header commits to the previous header
+    BOOST_CHECK(block_filter.ComputeHeader(uint256()) != block_filter.ComputeHeader(block_hash));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_type_names)
+{
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(BlockFilterType::BASIC), "basic");
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(static_cast<BlockFilterType>(255)), "");
+
+    BlockFilterType filter_type;
+    BOOST_CHECK(BlockFilterTypeByName("basic", filter_type));
+    BOOST_CHECK(filter_type == BlockFilterType::BASIC);
+
+    BOOST_CHECK(!BlockFilterTypeByName("unknown", filter_type));
+}
+
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, TestChain100Setup)
+{
+    BlockFilterIndex filter_index(BlockFilterType::BASIC, 1 << 20, true);
+
+    // The index has no filters before it is started
+    {
+        LOCK(cs_main);
+        BlockFilter filter;
+        BOOST_CHECK(!filter_index.LookupFilter(chainActive.Tip(), filter));
+    }
+    BOOST_CHECK(!filter_index.BlockUntilSyncedToCurrentChain());
+
+    filter_index.Start();
+
+    // Allow the filter index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // Check that the filters and headers of the active chain match a rebuild from the block files, and that
+    // every header commits to the one before it.
+    uint256 prev_header;
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* pindex = chainActive.Genesis(); pindex; pindex = chainActive.Next(pindex)) {
+            CBlock block;
+            BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+            CBlockUndo block_undo;
+            if (pindex->nHeight > 0) {
+                BOOST_REQUIRE(UndoReadFromDisk(block_undo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash()));
+            }
+            BlockFilter expected_filter(BlockFilterType::BASIC, pindex->GetBlockHash(), block, block_undo);
+
+            BlockFilter filter;
+            uint256 filter_header;
+            BOOST_REQUIRE(filter_index.LookupFilter(pindex, filter));
+            BOOST_REQUIRE(filter_index.LookupFilterHeader(pindex, filter_header));
+            BOOST_CHECK(filter.GetEncodedFilter() == expected_filter.GetEncodedFilter());
+            BOOST_CHECK(filter_header == expected_filter.ComputeHeader(prev_header));
+            prev_header = filter_header;
+        }
+
+        std::vector<BlockFilter> filters;
+        std::vector<uint256> filter_hashes;
+        BOOST_CHECK(filter_index.LookupFilterRange(10, chainActive.Tip(), filters));
+        BOOST_CHECK(filter_index.LookupFilterHashRange(10, chainActive.Tip(), filter_hashes));
+        BOOST_CHECK_EQUAL(filters.size(), (size_t)chainActive.Height() - 9);
+        BOOST_CHECK_EQUAL(filter_hashes.size(), filters.size());
+        for (size_t i = 0; i < filters.size(); i++) {
+            BOOST_CHECK(filters[i].GetBlockHash() == chainActive[10 + i]->GetBlockHash());
+            BOOST_CHECK(filter_hashes[i] == filters[i].GetHash());
+        }
+    }
+
+    // Blocks connected after the initial sync are indexed from BlockConnected
+    for (int i = 0; i < 5; i++) {
+        CreateAndProcessBlock({}, GetScriptForDestination(coinbaseKey.GetPubKey().GetID()));
+    }
+    BOOST_CHECK(filter_index.BlockUntilSyncedToCurrentChain());
+    {
+        LOCK(cs_main);
+        uint256 filter_header;
+        BOOST_CHECK(filter_index.LookupFilterHeader(chainActive.Tip(), filter_header));
+    }
+
+    filter_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
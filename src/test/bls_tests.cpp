@@ -5,6 +5,7 @@
 
 #include "bls/bls.h"
 #include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "test/test_ravencash.h"
 
 #include <boost/test/unit_test.hpp>
@@ -78,7 +79,7 @@ static void AddMessage(std::vector<Message>& vec, uint32_t sourceId, uint32_t ms
     vec.emplace_back(m);
 }
 
-static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback)
+static void Verify(std::vector<Message>& vec, bool secureVerification, bool perMessageFallback, CBLSWorker* worker)
 {
     CBLSBatchVerifier<uint32_t, uint32_t> batchVerifier(secureVerification, perMessageFallback);
 
@@ -93,7 +94,12 @@ static void Verify(std::vector<Message>& vec, bool secureVerification, bool perM
         batchVerifier.PushMessage(m.sourceId, m.msgId, m.msgHash, m.sig, m.pk);
     }
 
-    batchVerifier.Verify();
+    if (worker) {
+        // one message per sub-batch at least, so the sources are spread over as many sub-batches as possible
+        batchVerifier.VerifyParallel(*worker, 1);
+    } else {
+        batchVerifier.Verify();
+    }
 
     BOOST_CHECK(batchVerifier.badSources == expectedBadSources);
 
@@ -104,12 +110,12 @@ static void Verify(std::vector<Message>& vec, bool secureVerification, bool perM
     }
 }
 
-static void Verify(std::vector<Message>& vec)
+static void Verify(std::vector<Message>& vec, CBLSWorker* worker = nullptr)
 {
-    Verify(vec, false, false);
-    Verify(vec, true, false);
-    Verify(vec, false, true);
-    Verify(vec, true, true);
+    Verify(vec, false, false, worker);
+    Verify(vec, true, false, worker);
+    Verify(vec, false, true, worker);
+    Verify(vec, true, true, worker);
 }
 
 BOOST_AUTO_TEST_CASE(batch_verifier_tests)
@@ -155,4 +161,31 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     Verify(msgs);
 }
 
+BOOST_AUTO_TEST_CASE(batch_verifier_parallel_tests)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    std::vector<Message> msgs;
+
+    // distinct messages from distinct and from the same sources
+    for (uint32_t i = 1; i <= 12; i++) {
+        AddMessage(msgs, i % 4, i, i, true);
+    }
+    Verify(msgs, &worker);
+
+    // invalid sigs in different sub-batches
+    AddMessage(msgs, 5, 13, 13, false);
+    AddMessage(msgs, 6, 14, 14, false);
+    Verify(msgs, &worker);
+
+    // same message from other sources, which must end up in the same sub-batch
+    AddMessage(msgs, 7, 15, 13, true);
+    AddMessage(msgs, 1, 16, 1, true);
+    AddMessage(msgs, 2, 17, 1, false);
+    Verify(msgs, &worker);
+
+    worker.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+// Copyright (c) 2020-2021 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coinstats.h"
+#include "index/coinstatsindex.h"
+#include "script/standard.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "test/test_ravencash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(coinstatsindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(coinstatsindex_initial_sync, TestChain100Setup)
+{
+    CoinStatsIndex coin_stats_index(1 << 20, true);
+
+    CCoinsStats coin_stats;
+    const CBlockIndex* block_index;
+    {
+        LOCK(cs_main);
+        block_index = chainActive.Tip();
+    }
+
+    // Stats should not be found in the index before it is started.
+    BOOST_CHECK(!coin_stats_index.LookUpStats(block_index, coin_stats, false));
+
+    // BlockUntilSyncedToCurrentChain should return false before the index is started.
+    BOOST_CHECK(!coin_stats_index.BlockUntilSyncedToCurrentChain());
+
+    coin_stats_index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!coin_stats_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // The genesis block and the tip should both be found in the index now.
+    const CBlockIndex* genesis_block_index;
+    {
+        LOCK(cs_main);
+        genesis_block_index = chainActive.Genesis();
+    }
+    BOOST_CHECK(coin_stats_index.LookUpStats(genesis_block_index, coin_stats, false));
+    BOOST_CHECK(coin_stats_index.LookUpStats(block_index, coin_stats, false));
+
+    // The statistics of the tip must match a scan of the flushed chainstate.
+    FlushStateToDisk();
+    CCoinsStats scan_stats;
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview, scan_stats, CoinStatsHashType::MUHASH, false));
+    BOOST_CHECK(scan_stats.hashBlock == block_index->GetBlockHash());
+    BOOST_CHECK(coin_stats.hashSerialized == scan_stats.hashSerialized);
+    BOOST_CHECK_EQUAL(coin_stats.nTransactionOutputs, scan_stats.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(coin_stats.nBogoSize, scan_stats.nBogoSize);
+    BOOST_CHECK_EQUAL(coin_stats.nTotalAmount, scan_stats.nTotalAmount);
+
+    // Spend a coinbase output so that the next block removes an output from the set.
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbaseTxns[0].vout[0].nValue - 10000;
+    spend.vout[0].scriptPubKey = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    std::vector<unsigned char> vchSig;
+    uint256 sighash = SignatureHash(coinbaseTxns[0].vout[0].scriptPubKey, spend, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(sighash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CScript script_pub_key = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    std::vector<CMutableTransaction> txns{spend};
+    CreateAndProcessBlock(txns, script_pub_key);
+
+    // Let the index catch up to the new block before checking it.
+    BOOST_CHECK(coin_stats_index.BlockUntilSyncedToCurrentChain());
+
+    const CBlockIndex* new_block_index;
+    {
+        LOCK(cs_main);
+        new_block_index = chainActive.Tip();
+    }
+    CCoinsStats new_coin_stats;
+    BOOST_CHECK(coin_stats_index.LookUpStats(new_block_index, new_coin_stats, false));
+    BOOST_CHECK(block_index != new_block_index);
+    BOOST_CHECK(new_coin_stats.hashSerialized != coin_stats.hashSerialized);
+
+    FlushStateToDisk();
+    CCoinsStats new_scan_stats;
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview, new_scan_stats, CoinStatsHashType::MUHASH, false));
+    BOOST_CHECK(new_coin_stats.hashSerialized == new_scan_stats.hashSerialized);
+    BOOST_CHECK_EQUAL(new_coin_stats.nTransactionOutputs, new_scan_stats.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(new_coin_stats.nTotalAmount, new_scan_stats.nTotalAmount);
+
+    coin_stats_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
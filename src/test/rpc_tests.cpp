@@ -4,10 +4,12 @@
 
 #include "rpc/server.h"
 #include "rpc/client.h"
+#include "rpc/jsonstream.h"
 
 #include "base58.h"
 #include "core_io.h"
 #include "netbase.h"
+#include "utilstrencodings.h"
 
 #include "test/test_ravencash.h"
 
@@ -237,6 +239,150 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(json_stream_writer)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.push_back(Pair("key \"quoted\"", 1));
+    entry.push_back(Pair("empty", UniValue(UniValue::VARR)));
+    entry.push_back(Pair("amount", ValueFromAmount(123456789)));
+
+    UniValue head(UniValue::VOBJ);
+    head.push_back(Pair("hash", "00ff"));
+    head.push_back(Pair("height", 10));
+
+    UniValue entries(UniValue::VARR);
+    UniValue result(head);
+    for (int i = 0; i < 3; i++)
+        entries.push_back(entry);
+    result.push_back(Pair("entries", entries));
+    result.push_back(Pair("chainlock", false));
+    std::string strExpected = JSONRPCReply(result, NullUniValue, 7);
+
+    // A tiny chunk size, so that the sink is called in the middle of tokens
+    std::string strStreamed;
+    size_t nChunks = 0;
+    JSONStreamWriter writer([&](const char* data, size_t len) { strStreamed.append(data, len); nChunks++; }, 5);
+    writer.BeginObject();
+    writer.Key("result");
+    BOOST_CHECK(writer.ExpectsValue());
+    writer.BeginObject();
+    BOOST_CHECK(!writer.ExpectsValue());
+    writer.Members(head);
+    writer.Key("entries");
+    writer.BeginArray();
+    for (int i = 0; i < 3; i++)
+        writer.Value(entry);
+    writer.EndArray();
+    writer.KeyValue("chainlock", false);
+    writer.EndObject();
+    writer.KeyValue("error", NullUniValue);
+    writer.KeyValue("id", 7);
+    writer.EndObject();
+    writer.WriteRaw("\n");
+    writer.Flush();
+
+    BOOST_CHECK_EQUAL(strStreamed, strExpected);
+    BOOST_CHECK_EQUAL(writer.GetBytesFlushed(), strExpected.size());
+    BOOST_CHECK(nChunks > 1);
+
+    // Empty containers
+    std::string strEmpty;
+    JSONStreamWriter writerEmpty([&](const char* data, size_t len) { strEmpty.append(data, len); });
+    writerEmpty.BeginArray();
+    writerEmpty.BeginObject();
+    writerEmpty.EndObject();
+    writerEmpty.BeginArray();
+    writerEmpty.EndArray();
+    writerEmpty.EndArray();
+    BOOST_CHECK(strEmpty.empty());
+    writerEmpty.Flush();
+    BOOST_CHECK_EQUAL(strEmpty, "[{},[]]");
+}
+
+BOOST_AUTO_TEST_CASE(rpc_stats)
+{
+    if (RPCIsInWarmup(nullptr))
+        SetRPCWarmupFinished();
+    GetRPCStats(true);
+
+    JSONRPCRequest request;
+    request.strMethod = "getblockcount";
+    request.params = UniValue(UniValue::VARR);
+    for (int i = 0; i < 3; i++)
+        tableRPC.execute(request);
+    RPCStatsAddBytesReturned("getblockcount", 10);
+    request.strMethod = "getblockhash";
+    request.params.push_back(1000000);
+    BOOST_CHECK_THROW(tableRPC.execute(request), UniValue);
+
+    std::vector<CRPCMethodStats> vStats = GetRPCStats(true);
+    BOOST_CHECK_EQUAL(vStats.size(), 2);
+    BOOST_CHECK_EQUAL(vStats[0].strMethod, "getblockcount");
+    BOOST_CHECK_EQUAL(vStats[0].nCalls, 3);
+    BOOST_CHECK_EQUAL(vStats[0].nErrors, 0);
+    BOOST_CHECK_EQUAL(vStats[0].nBytesReturned, 10);
+    BOOST_CHECK(vStats[0].nP50Micros <= vStats[0].nP99Micros);
+    BOOST_CHECK(vStats[0].nP99Micros <= vStats[0].nMaxMicros);
+    BOOST_CHECK(vStats[0].nMaxMicros <= vStats[0].nTotalMicros);
+    BOOST_CHECK_EQUAL(vStats[1].strMethod, "getblockhash");
+    BOOST_CHECK_EQUAL(vStats[1].nCalls, 1);
+    BOOST_CHECK_EQUAL(vStats[1].nErrors, 1);
+    BOOST_CHECK(GetRPCStats().empty());
+
+    // Only the outermost lock of the chosen mutex is timed
+    CCriticalSection cs;
+    SetHoldTimeMutex(&cs);
+    int64_t nHoldStart = GetThreadHoldTimeMicros();
+    {
+        LOCK(cs);
+        {
+            LOCK(cs);
+            MilliSleep(5);
+        }
+        MilliSleep(5);
+    }
+    int64_t nHeld = GetThreadHoldTimeMicros() - nHoldStart;
+    SetHoldTimeMutex(nullptr);
+    BOOST_CHECK(nHeld >= 10000);
+    BOOST_CHECK(nHeld < 10000000);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_lockprofile)
+{
+    EnableLockProfile(true);
+    GetLockProfile(true);
+
+    CCriticalSection csProfiled;
+    boost::thread holder([&csProfiled] {
+        LOCK(csProfiled);
+        MilliSleep(20);
+    });
+    MilliSleep(5);
+    {
+        LOCK(csProfiled);
+    }
+    holder.join();
+    EnableLockProfile(false);
+
+    UniValue r;
+    BOOST_CHECK_NO_THROW(r = CallRPC("getlockprofile true"));
+    BOOST_CHECK(!find_value(r, "enabled").get_bool());
+    int nAcquired = 0, nContended = 0;
+    int64_t nMaxHold = 0;
+    for (const UniValue& site : find_value(r, "sites").getValues()) {
+        if (find_value(site, "lock").get_str() != "csProfiled")
+            continue;
+        nAcquired += find_value(site, "acquired").get_int();
+        nContended += find_value(site, "contended").get_int();
+        nMaxHold = std::max(nMaxHold, find_value(site, "max_hold_us").get_int64());
+    }
+    BOOST_CHECK_EQUAL(nAcquired, 2);
+    BOOST_CHECK_EQUAL(nContended, 1);
+    BOOST_CHECK(nMaxHold >= 10000);
+    BOOST_CHECK(GetLockProfile().empty());
+    BOOST_CHECK_THROW(CallRPC("getlockprofile false -1"), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(std::string("clearbanned")));
@@ -320,6 +466,47 @@ BOOST_AUTO_TEST_CASE(rpc_ban)
     BOOST_CHECK_EQUAL(adr.get_str(), "2001:4d48:ac57:400:cacf:e9ff:fe1d:9c63/128");
 }
 
+BOOST_FIXTURE_TEST_CASE(rpc_scantxoutset, TestChain100Setup)
+{
+    // The coinbase outputs of the test chain pay to coinbaseKey's public key
+    std::string pubkey = HexStr(coinbaseKey.GetPubKey());
+    std::string address = EncodeDestination(coinbaseKey.GetPubKey().GetID());
+
+    BOOST_CHECK(CallRPC("scantxoutset status").isNull());
+    BOOST_CHECK_EQUAL(CallRPC("scantxoutset abort").get_bool(), false);
+    BOOST_CHECK_THROW(CallRPC("scantxoutset start"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("scantxoutset start [\"pk(00)\"]"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("scantxoutset start [\"raw(xyz)\"]"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("scantxoutset start [\"notanaddress\"]"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("scantxoutset start [\"sh(00)\"]"), std::runtime_error);
+
+    UniValue r;
+    BOOST_CHECK_NO_THROW(r = CallRPC("scantxoutset start [\"pk(" + pubkey + ")\"]"));
+    BOOST_CHECK(find_value(r, "success").get_bool());
+    BOOST_CHECK_EQUAL(find_value(r, "height").get_int(), 100);
+    const UniValue& unspents = find_value(r, "unspents");
+    BOOST_CHECK_EQUAL(unspents.size(), 100U);
+    CAmount nTotal = 0;
+    for (size_t i = 0; i < unspents.size(); i++) {
+        BOOST_CHECK_EQUAL(find_value(unspents[i], "desc").get_str(), "pk(" + pubkey + ")");
+        nTotal += AmountFromValue(find_value(unspents[i], "amount"));
+        // The results are ordered by txid
+        if (i > 0) {
+            BOOST_CHECK(uint256S(find_value(unspents[i - 1], "txid").get_str()) < uint256S(find_value(unspents[i], "txid").get_str()));
+        }
+    }
+    BOOST_CHECK_EQUAL(AmountFromValue(find_value(r, "total_amount")), nTotal);
+
+    // The outputs are P2PK, so they don't pay to the key's address
+    BOOST_CHECK_NO_THROW(r = CallRPC("scantxoutset start [\"" + address + "\",\"pkh(" + pubkey + ")\"]"));
+    BOOST_CHECK_EQUAL(find_value(r, "unspents").size(), 0U);
+
+    // Scripts repeated across scan objects are matched once
+    BOOST_CHECK_NO_THROW(r = CallRPC("scantxoutset start [\"combo(" + pubkey + ")\",\"pk(" + pubkey + ")\"]"));
+    BOOST_CHECK_EQUAL(find_value(r, "unspents").size(), 100U);
+    BOOST_CHECK(find_value(r, "searched_items").get_int64() >= 100);
+}
+
 #if ENABLE_MINER
 BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
 {
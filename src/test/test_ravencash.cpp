@@ -8,6 +8,7 @@
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
 #include "crypto/sha256.h"
+#include "crypto/x16r_batch.h"
 #include "fs.h"
 #include "key.h"
 #include "validation.h"
@@ -50,6 +51,7 @@ extern void noui_connect();
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
         SHA256AutoDetect();
+        X16RBatchAutoDetect();
         RandomInit();
         ECC_Start();
         BLSInit();
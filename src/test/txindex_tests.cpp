@@ -0,0 +1,201 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2020 The RavenCash developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "index/addressindex.h"
+#include "index/spentinfoindex.h"
+#include "index/txindex.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "txdb.h"
+#include "utiltime.h"
+#include "validation.h"
+#include "test/test_ravencash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txindex_tests)
+
+template <typename Index>
+static void WaitForInitialSync(Index& index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
+{
+    TxIndex txindex(1 << 20, true);
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+
+    // Transaction should not be found in the index before it is started.
+    for (const auto& txn : coinbaseTxns) {
+        BOOST_CHECK(!txindex.FindTx(txn.GetHash(), block_hash, tx_disk));
+    }
+
+    // BlockUntilSyncedToCurrentChain should return false before txindex is started.
+    BOOST_CHECK(!txindex.BlockUntilSyncedToCurrentChain());
+
+    txindex.Start();
+    WaitForInitialSync(txindex);
+
+    // Check that txindex has all txs that were in the chain before it started.
+    for (const auto& txn : coinbaseTxns) {
+        if (!txindex.FindTx(txn.GetHash(), block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else if (tx_disk->GetHash() != txn.GetHash()) {
+            BOOST_ERROR("Read incorrect tx");
+        }
+    }
+
+    // Check that new transactions in new blocks make it into the index.
+    for (int i = 0; i < 10; i++) {
+        CScript coinbase_script_pub_key = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+        std::vector<CMutableTransaction> no_txns;
+        const CBlock& block = CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+        const CTransaction& txn = *block.vtx[0];
+
+        BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+        if (!txindex.FindTx(txn.GetHash(), block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else if (tx_disk->GetHash() != txn.GetHash()) {
+            BOOST_ERROR("Read incorrect tx");
+        }
+    }
+
+    txindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_migration, TestChain100Setup)
+{
+    // Write the positions of the coinbase transactions to the block tree DB, as older versions did.
+    std::vector<std::pair<uint256, CDiskTxPos>> legacy_entries;
+    {
+        LOCK(cs_main);
+        for (int height = 1; height <= chainActive.Height(); height++) {
+            const CBlockIndex* pindex = chainActive[height];
+            CBlock block;
+            BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+            legacy_entries.emplace_back(block.vtx[0]->GetHash(), CDiskTxPos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size())));
+        }
+    }
+    CDBBatch batch(*pblocktree);
+    for (const auto& entry : legacy_entries) {
+        batch.Write(std::make_pair('t', entry.first), entry.second);
+    }
+    BOOST_REQUIRE(pblocktree->WriteBatch(batch));
+    BOOST_REQUIRE(pblocktree->WriteFlag("txindex", true));
+
+    // The migrated index starts out in sync with the chain, without rebuilding it from the blocks.
+    TxIndex txindex(1 << 20, true);
+    txindex.Start();
+    BOOST_CHECK(txindex.IsSynced());
+    BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& entry : legacy_entries) {
+        if (!txindex.FindTx(entry.first, block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        }
+        // The legacy entries are removed once they are migrated.
+        BOOST_CHECK(!pblocktree->Exists(std::make_pair('t', entry.first)));
+    }
+
+    bool f_legacy_flag = true;
+    BOOST_CHECK(pblocktree->ReadFlag("txindex", f_legacy_flag));
+    BOOST_CHECK(!f_legacy_flag);
+
+    txindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(spentindex_migration, TestChain100Setup)
+{
+    // Write a spent index entry to the block tree DB, as older versions did.
+    const CSpentIndexKey key(coinbaseTxns[0].GetHash(), 0);
+    const CSpentIndexValue value(coinbaseTxns[1].GetHash(), 0, 2, 50 * COIN, 1, coinbaseKey.GetPubKey().GetID());
+    BOOST_REQUIRE(pblocktree->Write(std::make_pair('p', key), value));
+    BOOST_REQUIRE(pblocktree->WriteFlag("spentindex", true));
+
+    // The entry is moved and the index starts out in sync with the chain.
+    SpentIndex spentindex(1 << 20, true);
+    spentindex.Start();
+    BOOST_CHECK(spentindex.IsSynced());
+
+    CSpentIndexValue spent_value;
+    BOOST_REQUIRE(spentindex.ReadSpentIndex(key, spent_value));
+    BOOST_CHECK(spent_value.txid == value.txid);
+    BOOST_CHECK_EQUAL(spent_value.blockHeight, 2);
+    BOOST_CHECK(!pblocktree->Exists(std::make_pair('p', key)));
+
+    bool f_legacy_flag = true;
+    BOOST_CHECK(pblocktree->ReadFlag("spentindex", f_legacy_flag));
+    BOOST_CHECK(!f_legacy_flag);
+
+    spentindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_spentindex_sync, TestChain100Setup)
+{
+    AddressIndex addressindex(1 << 20, true);
+    SpentIndex spentindex(1 << 20, true);
+    addressindex.Start();
+    spentindex.Start();
+    WaitForInitialSync(addressindex);
+    WaitForInitialSync(spentindex);
+
+    // The coinbase outputs pay to the coinbase key, so each of them is unspent for its address.
+    const uint160 key_hash = coinbaseKey.GetPubKey().GetID();
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspent;
+    BOOST_CHECK(addressindex.ReadAddressUnspentIndex(key_hash, 1, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), coinbaseTxns.size());
+
+    // Spend the first coinbase output in a new block.
+    CScript script_pub_key = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout.hash = coinbaseTxns[0].GetHash();
+    spend.vin[0].prevout.n = 0;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11 * CENT;
+    spend.vout[0].scriptPubKey = script_pub_key;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(script_pub_key, spend, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CreateAndProcessBlock({spend}, script_pub_key);
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+
+    // The spent output is recorded with the spending transaction and the address it paid to.
+    CSpentIndexValue spent_value;
+    BOOST_REQUIRE(spentindex.ReadSpentIndex(CSpentIndexKey(coinbaseTxns[0].GetHash(), 0), spent_value));
+    BOOST_CHECK(spent_value.txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(spent_value.inputIndex, 0U);
+    BOOST_CHECK_EQUAL(spent_value.addressType, 1);
+    BOOST_CHECK(spent_value.addressHash == key_hash);
+
+    // The spent coinbase output is gone; the new block's coinbase and the spend's output are unspent.
+    unspent.clear();
+    BOOST_CHECK(addressindex.ReadAddressUnspentIndex(key_hash, 1, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), coinbaseTxns.size() + 1);
+    for (const auto& entry : unspent) {
+        BOOST_CHECK(!(entry.first.txhash == coinbaseTxns[0].GetHash() && entry.first.index == 0));
+    }
+
+    spentindex.Stop();
+    addressindex.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -14,6 +14,7 @@
 
 #include "amount.h"
 #include "coins.h"
+#include "consensus/validation.h"
 #include "fs.h"
 #include "protocol.h" // For CMessageHeader::MessageStartChars
 #include "policy/feerate.h"
@@ -41,6 +42,7 @@
 #include <atomic>
 
 class CBlockIndex;
+class CBlockUndo;
 class CBlockTreeDB;
 class CChainParams;
 class CCoinsViewDB;
@@ -53,6 +55,7 @@ class CValidationState;
 class PrecomputedTransactionData;
 struct ChainTxData;
 class CTxUndo;
+struct CCompiledVerifierString;
 
 struct LockPoints;
 
@@ -273,6 +276,27 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  */
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=nullptr, CBlockHeader *first_invalid=nullptr);
 
+/** Context-free proof of work result for a header, computed without holding cs_main */
+struct CHeaderPoWResult
+{
+    uint256 hash;
+    //! Whether the proof of work was checked, which is skipped for headers that are already known
+    bool fChecked{false};
+    bool fValid{false};
+    CValidationState state;
+};
+
+/**
+ * Compute the hash of each header, and check the proof of work of the ones not in mapBlockIndex yet, spread
+ * over the header check threads. ProcessNewBlockHeaders calls this before taking cs_main for the contextual checks.
+ *
+ * Call without cs_main held.
+ */
+void PreVerifyBlockHeaders(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, std::vector<CHeaderPoWResult>& results);
+/** Start/stop the threads used by PreVerifyBlockHeaders */
+void StartHeaderCheckThreads(int nThreads);
+void StopHeaderCheckThreads();
+
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
 /** Open a block file (blk?????.dat) */
@@ -421,6 +445,14 @@ bool GetAddressIndex(uint160 addressHash, int type,
                      int start = 0, int end = 0);
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+bool GetAddressIndex(uint160 addressHash, int type, const CAddressIndexKey* pAfter, size_t nLimit,
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
+                     bool &fMore, int start = 0, int end = 0);
+bool GetAddressUnspent(uint160 addressHash, int type, const CAddressUnspentKey* pAfter, size_t nLimit,
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       bool &fMore, int start = 0, int end = 0);
+bool GetAddressBalance(uint160 addressHash, int type,
+                       std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &balances);
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
@@ -428,6 +460,13 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock);
+/**
+ * Read the serialized block of pindex as it is stored on disk, without deserializing or hashing it. The bytes are
+ * trusted to be the block that passed validation for pindex, so use this only to pass them on unchanged.
+ */
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -522,6 +561,9 @@ extern CRestrictedDB *prestricteddb;
 /** Global variable that points to the asset verifier LRU Cache (protected by cs_main) */
 extern CLRUCache<std::string, CNullAssetTxVerifierString> *passetsVerifierCache;
 
+/** Global variable that points to the compiled verifier string LRU Cache (protected by cs_main) */
+extern CLRUCache<std::string, std::shared_ptr<const CCompiledVerifierString>> *passetsCompiledVerifierCache; // verifier string -> compiled form
+
 /** Global variable that points to the asset address qualifier LRU Cache (protected by cs_main) */
 extern CLRUCache<std::string, int8_t> *passetsQualifierCache; // hash(address,qualifier_name) ->int8_t
 